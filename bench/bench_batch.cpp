@@ -0,0 +1,114 @@
+//compares scanning baskets of 50 to 200 items with one scanItem call per item
+//against one scanBatch call per basket
+#include "inventory.h"
+#include "register.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::duration d) {
+	return std::chrono::duration<double>(d).count();
+}
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 100000;
+	int baskets = argc > 2 ? atoi(argv[2]) : 20000;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	vector<string> names;
+	shared_ptr<Special> bogo = make_shared<SpecialBogo>(2, 1, 50);
+	shared_ptr<Special> bulk = make_shared<SpecialBulk>(6, 499);
+	for (int i = 0; i < skus; ++i) {
+		names.push_back("product " + std::to_string(i));
+		PriceRow row;
+		row.price = 100 + i % 900;
+		row.byWeight = i % 10 == 0;
+		inv->insertRow(names[i].data(), names[i].size(), row, i % 7 == 1 ? bogo : i % 7 == 2 ? bulk : nullptr);
+	}
+
+	//baskets of 50 to 200 items drawn from popular products, each sent by
+	//the conveyor as a run of 1 to 6 of the same item
+	std::mt19937 rng(99);
+	std::uniform_int_distribution<int> size(50, 200);
+	std::uniform_int_distribution<int> run(1, 6);
+	std::geometric_distribution<int> popular(0.002);
+	vector<vector<ScanEntry>> byName(baskets);
+	vector<vector<ScanEntry>> byHandle(baskets);
+	long long items = 0;
+	for (int b = 0; b < baskets; ++b) {
+		int n = size(rng);
+		while ((int) byName[b].size() < n) {
+			int p = popular(rng) % skus;
+			int w = p % 10 == 0 ? 120 : 0;
+			for (int k = run(rng); k > 0 && (int) byName[b].size() < n; --k) {
+				byName[b].push_back(ScanEntry(names[p], w));
+				byHandle[b].push_back(ScanEntry(p, w));
+			}
+		}
+		items += n;
+	}
+
+	//only the scans are timed, since starting a basket costs the same either
+	//way; each pass is repeated and the fastest kept
+	Register single;
+	single.assignInventory(inv);
+	Register batched;
+	batched.assignInventory(inv);
+	double singleNameTime = 1e9, singleHandleTime = 1e9, batchNameTime = 1e9, batchHandleTime = 1e9;
+	long long check = 0;
+	for (int rep = 0; rep < 3; ++rep) {
+		Clock::duration singleName(0), singleHandle(0), batchName(0), batchHandle(0);
+		for (int b = 0; b < baskets; ++b) {
+			single.reset();
+			auto start = Clock::now();
+			for (const ScanEntry& e : byName[b]) {
+				single.scanItem(string(e.name, e.length), e.weight);
+			}
+			singleName += Clock::now() - start;
+			check += single.getTotal();
+
+			single.reset();
+			start = Clock::now();
+			for (const ScanEntry& e : byHandle[b]) {
+				single.scanItem(e.handle, e.weight);
+			}
+			singleHandle += Clock::now() - start;
+
+			batched.reset();
+			start = Clock::now();
+			batched.scanBatch(byName[b].data(), byName[b].size());
+			batchName += Clock::now() - start;
+			check -= batched.getTotal();
+
+			batched.reset();
+			start = Clock::now();
+			batched.scanBatch(byHandle[b].data(), byHandle[b].size());
+			batchHandle += Clock::now() - start;
+		}
+		singleNameTime = std::min(singleNameTime, seconds(singleName));
+		singleHandleTime = std::min(singleHandleTime, seconds(singleHandle));
+		batchNameTime = std::min(batchNameTime, seconds(batchName));
+		batchHandleTime = std::min(batchHandleTime, seconds(batchHandle));
+	}
+
+	printf("skus=%d baskets=%d items=%lld\n", skus, baskets, items);
+	printf("scanItem by name:    %.1f ns/item\n", singleNameTime * 1e9 / items);
+	printf("scanBatch by name:   %.1f ns/item, %.1fx\n", batchNameTime * 1e9 / items, singleNameTime / batchNameTime);
+	printf("scanItem by handle:  %.1f ns/item\n", singleHandleTime * 1e9 / items);
+	printf("scanBatch by handle: %.1f ns/item, %.1fx\n", batchHandleTime * 1e9 / items, singleHandleTime / batchHandleTime);
+	printf("checksum %lld\n", check); //0 when both paths total every basket the same
+	return 0;
+}
@@ -0,0 +1,93 @@
+//a load generator for CheckoutEngine: feeder threads send bursts of scans,
+//removals and resets to many lanes, and throughput is measured for worker
+//pools from one thread up to the core count
+#include "checkout.h"
+#include "inventory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::duration d) {
+	return std::chrono::duration<double>(d).count();
+}
+
+int main(int argc, char** argv) {
+	int laneCount = argc > 1 ? atoi(argv[1]) : 256;
+	int perLane = argc > 2 ? atoi(argv[2]) : 20000;
+	int maxWorkers = argc > 3 ? atoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+	int feeders = 2;
+	int burst = 16;
+	int skus = 50000;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	shared_ptr<Special> bogo = make_shared<SpecialBogo>(2, 1, 50);
+	shared_ptr<Special> bulk = make_shared<SpecialBulk>(6, 499);
+	for (int i = 0; i < skus; ++i) {
+		string name = "product " + std::to_string(i);
+		PriceRow row;
+		row.price = 100 + i % 900;
+		row.byWeight = i % 10 == 0;
+		inv->insertRow(name.data(), name.size(), row, i % 7 == 1 ? bogo : i % 7 == 2 ? bulk : nullptr);
+	}
+
+	//each lane scans baskets of about 100 items, removing one now and then
+	vector<vector<CheckoutEvent>> events(laneCount);
+	std::mt19937 rng(5);
+	std::geometric_distribution<int> popular(0.001);
+	for (vector<CheckoutEvent>& lane : events) {
+		lane.reserve(perLane);
+		for (int i = 0; i < perLane; ++i) {
+			int h = popular(rng) % skus;
+			int w = h % 10 == 0 ? 120 : 0;
+			int r = rng() % 100;
+			lane.push_back(CheckoutEvent(r == 0 ? CHECKOUT_RESET : r < 5 ? CHECKOUT_REMOVE : CHECKOUT_SCAN, h, w));
+		}
+	}
+	long long total = (long long) laneCount * perLane;
+
+	printf("%d lanes, %d events each, %d feeder threads, bursts of %d\n", laneCount, perLane, feeders, burst);
+	printf("%8s %14s %9s %10s\n", "workers", "events/sec", "speedup", "steals");
+	double base = 0;
+	for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+		CheckoutEngine engine(inv, laneCount, workers);
+		auto start = Clock::now();
+		vector<std::thread> threads;
+		for (int f = 0; f < feeders; ++f) {
+			threads.emplace_back([&, f] {
+				for (int i = 0; i < perLane; i += burst) {
+					int n = std::min(burst, perLane - i);
+					for (int l = f; l < laneCount; l += feeders) {
+						engine.submit(l, &events[l][i], n);
+					}
+				}
+			});
+		}
+		for (std::thread& t : threads) {
+			t.join();
+		}
+		engine.drain();
+		double rate = total / seconds(Clock::now() - start);
+		if (workers == 1) {
+			base = rate;
+		}
+		printf("%8d %14.0f %8.2fx %10lld\n", workers, rate, rate / base, engine.getSteals());
+		if (workers < maxWorkers && workers * 2 > maxWorkers) {
+			workers = maxWorkers / 2;
+		}
+	}
+	return 0;
+}
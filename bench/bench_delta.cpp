@@ -0,0 +1,119 @@
+//measures register scan throughput against a shared inventory on its own and
+//while a price delta feed is applied at a fixed rate on another thread
+#include "delta.h"
+#include "inventory.h"
+#include "register.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long long scan(const shared_ptr<Inventory>& inv, int threads, int skus, double seconds) {
+	//each thread scans baskets of 20 items until time runs out, returns the scan count
+	std::atomic<bool> done(false);
+	std::atomic<long long> scans(0);
+	vector<std::thread> scanners;
+	for (int t = 0; t < threads; ++t) {
+		scanners.push_back(std::thread([&inv, &done, &scans, skus, t]() {
+			Register r;
+			r.assignInventory(inv);
+			unsigned h = t * 2654435761u;
+			long long n = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				r.reset();
+				for (int i = 0; i < 20; ++i) {
+					h = h * 1103515245u + 12345u;
+					r.scanItem((int) (h % skus));
+				}
+				n += 20;
+			}
+			scans += n;
+		}));
+	}
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	done = true;
+	for (std::thread& s : scanners) {
+		s.join();
+	}
+	return scans;
+}
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 200000;
+	int rate = argc > 2 ? atoi(argv[2]) : 100000; //deltas per second
+	int threads = argc > 3 ? atoi(argv[3]) : 4;
+	double seconds = 2;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	PriceRow row;
+	for (int i = 0; i < skus; ++i) {
+		string n = "product " + std::to_string(i);
+		row.price = 100 + i % 900;
+		inv->insertRow(n.data(), n.size(), row, nullptr);
+	}
+
+	//a feed mixing every kind of change, applied in 10ms slices to hold the rate
+	const int slices = 100;
+	vector<string> feed(slices);
+	int perSlice = rate / slices;
+	unsigned h = 1;
+	for (int s = 0; s < slices; ++s) {
+		for (int i = 0; i < perSlice; ++i) {
+			h = h * 1103515245u + 12345u;
+			string n = "product " + std::to_string(h % skus);
+			switch (i % 8) {
+				case 0: feed[s] += "M," + n + ",10\n"; break;
+				case 1: feed[s] += "M," + n + ",0\n"; break;
+				case 2: feed[s] += "S," + n + ",BULK,3,200\n"; break;
+				case 3: feed[s] += "S," + n + ",BOGO,1,1,50\n"; break;
+				case 4: feed[s] += "X," + n + "\n"; break;
+				case 5: feed[s] += "U," + n + ",500,0,0\n"; break;
+				default: feed[s] += "P," + n + "," + std::to_string(100 + h % 900) + "\n"; break;
+			}
+		}
+	}
+
+	long long quiet = scan(inv, threads, skus, seconds);
+
+	std::atomic<bool> done(false);
+	long long applied = 0;
+	double applyTime = 0;
+	double feedTime = 0;
+	std::thread feeder([&]() {
+		DeltaApplier applier;
+		auto start = std::chrono::steady_clock::now();
+		auto next = start;
+		for (int s = 0; !done.load(); s = (s + 1) % slices) {
+			auto sliceStart = std::chrono::steady_clock::now();
+			applier.parse(feed[s].data(), feed[s].size(), *inv);
+			applyTime += secondsSince(sliceStart);
+			next += std::chrono::milliseconds(10);
+			std::this_thread::sleep_until(next);
+		}
+		applied = applier.getApplied() + applier.getRejects().size();
+		feedTime = secondsSince(start);
+	});
+	long long busy = scan(inv, threads, skus, seconds);
+	done = true;
+	feeder.join();
+
+	printf("skus=%d scanThreads=%d targetRate=%d deltas/sec\n", skus, threads, rate);
+	printf("scans without feed: %.2f M scans/sec\n", quiet / seconds / 1e6);
+	printf("scans with feed:    %.2f M scans/sec\n", busy / seconds / 1e6);
+	printf("deltas applied:     %lld (%.0f deltas/sec), %.0f ns/delta while applying\n", applied, applied / feedTime, applyTime * 1e9 / applied);
+	return 0;
+}
@@ -0,0 +1,50 @@
+//measures CsvImporter throughput in rows/sec on a generated price file
+#include "importer.h"
+#include "inventory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv) {
+	long rows = argc > 1 ? atol(argv[1]) : 5000000;
+	int threads = argc > 2 ? atoi(argv[2]) : (int) std::thread::hardware_concurrency();
+	const char* path = "bench_import.csv";
+	FILE* f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	fputs("name,price,byWeight,markdown,special\n", f);
+	for (long i = 0; i < rows; ++i) {
+		int price = 99 + (int) (i * 37 % 2000);
+		switch (i % 10) {
+			case 0:
+				fprintf(f, "item %ld,%d,1,0\n", i, price);
+				break;
+			case 1:
+				fprintf(f, "item %ld,%d,0,0,BOGO,%d,1,%d,%d\n", i, price, 1 + (int) (i % 3), 50 + (int) (i % 51), (int) (i % 4) * 2);
+				break;
+			case 2:
+				fprintf(f, "item %ld,%d,0,0,BULK,%d,%d\n", i, price, 2 + (int) (i % 4), price);
+				break;
+			case 3:
+				fprintf(f, "item %ld,%d,0,%d\n", i, price, price / 10);
+				break;
+			default:
+				fprintf(f, "item %ld,%d,0,0\n", i, price);
+		}
+	}
+	fclose(f);
+
+	Inventory inventory;
+	CsvImporter importer(threads);
+	auto start = std::chrono::steady_clock::now();
+	importer.load(path, inventory);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("rows=%ld threads=%d imported=%ld rejected=%zu\n", rows, threads, importer.getImported(), importer.getRejects().size());
+	printf("%.3f s, %.2f M rows/sec\n", seconds, rows / seconds / 1e6);
+	std::remove(path);
+	return 0;
+}
@@ -0,0 +1,74 @@
+//compares lookup throughput of the catalog backed Inventory against the
+//unordered_map<string, shared_ptr<Product>> it replaced
+#include "inventory.h"
+#include "product.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 200000;
+	int lookups = argc > 2 ? atoi(argv[2]) : 10000000;
+	vector<string> names;
+	names.reserve(skus);
+	for (int i = 0; i < skus; ++i) {
+		names.push_back("product " + std::to_string(i * 7919));
+	}
+	unordered_map<string, shared_ptr<Product>> legacy;
+	Inventory inventory;
+	for (int i = 0; i < skus; ++i) {
+		shared_ptr<Product> p = make_shared<Product>(names[i], 100 + i % 900, i % 10 == 0);
+		legacy[names[i]] = p;
+		inventory.insert(p);
+	}
+	std::mt19937 rng(12345);
+	std::uniform_int_distribution<int> pick(0, skus - 1);
+	vector<int> queries(lookups);
+	for (int& q : queries) {
+		q = pick(rng);
+	}
+
+	long long sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int q : queries) {
+		//the old scan path: contains, then retrieve copying the shared_ptr
+		const string& n = names[q];
+		if (legacy.find(n) != legacy.end()) {
+			shared_ptr<Product> p = legacy[n];
+			sum += p->getPrice() - p->getMarkdown() + p->getByWeight() + (p->getSpecial() != nullptr);
+		}
+	}
+	double legacyTime = secondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int q : queries) {
+		int h = inventory.getHandle(names[q]);
+		if (h != -1) {
+			const PriceRow& r = inventory.pricing(h);
+			sum -= r.price - r.markdown + r.byWeight + (r.special != -1);
+		}
+	}
+	double catalogTime = secondsSince(start);
+
+	printf("skus=%d lookups=%d\n", skus, lookups);
+	printf("unordered_map: %.1f ns/lookup, %.2f M lookups/sec\n", legacyTime * 1e9 / lookups, lookups / legacyTime / 1e6);
+	printf("catalog:       %.1f ns/lookup, %.2f M lookups/sec\n", catalogTime * 1e9 / lookups, lookups / catalogTime / 1e6);
+	printf("checksum %lld\n", sum); //0 when both paths read the same fields
+	return 0;
+}
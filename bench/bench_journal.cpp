@@ -0,0 +1,81 @@
+//measures register scan throughput with no journal and with journals at
+//several group commit and sync cadences
+#include "inventory.h"
+#include "journal.h"
+#include "register.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::duration d) {
+	return std::chrono::duration<double>(d).count();
+}
+
+int main(int argc, char** argv) {
+	int scans = argc > 1 ? atoi(argv[1]) : 2000000;
+	string path = argc > 2 ? argv[2] : "/tmp/bench_journal.jrnl";
+	int skus = 10000;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	shared_ptr<Special> bulk = make_shared<SpecialBulk>(6, 499);
+	for (int i = 0; i < skus; ++i) {
+		string name = "product " + std::to_string(i);
+		PriceRow row;
+		row.price = 100 + i % 900;
+		inv->insertRow(name.data(), name.size(), row, i % 5 == 1 ? bulk : nullptr);
+	}
+	std::mt19937 rng(7);
+	std::geometric_distribution<int> popular(0.01);
+	vector<int> handles(scans);
+	for (int& h : handles) {
+		h = popular(rng) % skus;
+	}
+
+	//{commitEvery, syncEvery}; commitEvery 0 runs without a journal
+	const int cadences[][2] = {{0, 0}, {1, 0}, {32, 0}, {256, 0}, {256, 1}, {1024, 1}, {4096, 1}, {256, 16}};
+	printf("%-28s %12s %10s\n", "journal", "scans/sec", "syncs");
+	for (const int* cadence : cadences) {
+		Register reg;
+		reg.assignInventory(inv);
+		reg.reserve(256);
+		Journal journal(cadence[0] ? cadence[0] : 1, cadence[1]);
+		if (cadence[0]) {
+			if (!journal.open(path, true)) {
+				fprintf(stderr, "can't open %s\n", path.c_str());
+				return 1;
+			}
+			reg.setJournal(&journal);
+		}
+		auto start = Clock::now();
+		for (int i = 0; i < scans; ++i) {
+			if (i % 100 == 99) {
+				reg.reset();
+			}
+			reg.scanItem(handles[i]);
+		}
+		journal.close();
+		double s = seconds(Clock::now() - start);
+		char label[64];
+		if (!cadence[0]) {
+			snprintf(label, sizeof(label), "none");
+		}
+		else {
+			snprintf(label, sizeof(label), "commit %d, %s", cadence[0], cadence[1] ? ("sync every " + std::to_string(cadence[1])).c_str() : "no sync");
+		}
+		printf("%-28s %12.0f %10lld\n", label, scans / s, journal.getSyncs());
+	}
+	remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,98 @@
+//measures what Register and Inventory instrumentation costs per operation.
+//the Makefile builds it twice, as bench_metrics with REGISTER_METRICS defined
+//and bench_metrics_off without; compare their ns/op
+#include "inventory.h"
+#include "metrics.h"
+#include "register.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 100000;
+	int ops = argc > 2 ? atoi(argv[2]) : 5000000;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	vector<string> names(skus);
+	shared_ptr<Special> bogo = make_shared<SpecialBogo>(2, 1, 50);
+	for (int i = 0; i < skus; ++i) {
+		names[i] = "product " + std::to_string(i);
+		PriceRow row;
+		row.price = 100 + i % 900;
+		row.byWeight = i % 10 == 0;
+		inv->insertRow(names[i].data(), names[i].size(), row, i % 3 == 1 ? bogo : nullptr);
+	}
+	std::mt19937 rng(8);
+	std::geometric_distribution<int> popular(0.002);
+	vector<int> handles(ops);
+	for (int& h : handles) {
+		h = popular(rng) % skus;
+	}
+
+	Register reg;
+	reg.assignInventory(inv);
+	reg.reserve(128);
+	double scanNs = 1e9, removeNs = 1e9, retrieveNs = 1e9;
+	long long check = 0;
+	for (int rep = 0; rep < 3; ++rep) {
+		Clock::duration scan(0), remove(0), retrieve(0);
+		for (int i = 0; i < ops; i += 100) {
+			int end = i + 100 < ops ? i + 100 : ops;
+			reg.reset();
+			auto t0 = Clock::now();
+			for (int k = i; k < end; ++k) {
+				//weighed products are scanned without a weight one time in
+				//ten, to exercise the reject counters
+				reg.scanItem(handles[k], handles[k] % 10 == 0 && k % 10 != 0 ? 125 : 0);
+			}
+			auto t1 = Clock::now();
+			for (int k = i; k < end; ++k) {
+				reg.removeItem(handles[k], handles[k] % 10 == 0 ? 125 : 0);
+			}
+			auto t2 = Clock::now();
+			for (int k = i; k < end; ++k) {
+				check += inv->retrieve(names[handles[k]]) != nullptr;
+			}
+			auto t3 = Clock::now();
+			scan += t1 - t0;
+			remove += t2 - t1;
+			retrieve += t3 - t2;
+			check += reg.getTotal();
+		}
+		scanNs = std::min(scanNs, std::chrono::duration<double, std::nano>(scan).count() / ops);
+		removeNs = std::min(removeNs, std::chrono::duration<double, std::nano>(remove).count() / ops);
+		retrieveNs = std::min(retrieveNs, std::chrono::duration<double, std::nano>(retrieve).count() / ops);
+	}
+#ifdef REGISTER_METRICS
+	const char* mode = "on";
+#else
+	const char* mode = "off";
+#endif
+	printf("instrumentation %s: scanItem %.1f ns/op, removeItem %.1f ns/op, retrieve %.1f ns/op (check %lld)\n",
+		mode, scanNs, removeNs, retrieveNs, check);
+#ifdef REGISTER_METRICS
+	MetricsSnapshot s = Metrics::snapshot();
+	const char* opNames[] = {"scanItem", "removeItem", "retrieve", "scanBatch", "removeBatch"};
+	for (int op = 0; op < METRIC_OPS; ++op) {
+		printf("  %-11s %10llu ops  p50 %6.0f ns  p99 %6.0f ns  p999 %6.0f ns\n", opNames[op],
+			(unsigned long long) s.getOps(op), s.percentile(op, 0.5), s.percentile(op, 0.99), s.percentile(op, 0.999));
+	}
+	printf("  scanned %llu, scanned without weight %llu, removed %llu, removed unscanned %llu, retrieve hits %llu\n",
+		(unsigned long long) s.getCount(COUNT_SCANNED), (unsigned long long) s.getCount(COUNT_SCAN_NO_WEIGHT),
+		(unsigned long long) s.getCount(COUNT_REMOVED), (unsigned long long) s.getCount(COUNT_REMOVE_NOT_SCANNED),
+		(unsigned long long) s.getCount(COUNT_RETRIEVE_HIT));
+#endif
+	return 0;
+}
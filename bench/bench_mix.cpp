@@ -0,0 +1,99 @@
+//times scanning and removing units of a 40 flavour "any 3 for $5" mix and
+//match special as baskets grow, against repricing the whole basket on
+//every scan as a front end without group specials has to
+#include "inventory.h"
+#include "register.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::duration d) {
+	return std::chrono::duration<double>(d).count();
+}
+
+static long long repriceBasket(const vector<int>& units) {
+	//the whole basket from scratch: each complete run of 3 in scan order
+	//for 500, the rest at their own prices
+	long long total = 0;
+	long long run = 0;
+	for (size_t i = 0; i < units.size(); ++i) {
+		run += units[i];
+		if (i % 3 == 2) {
+			total += 500;
+			run = 0;
+		}
+	}
+	return total + run;
+}
+
+int main(int argc, char** argv) {
+	int scans = argc > 1 ? atoi(argv[1]) : 2000000;
+	const int flavours = 40;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Special> deal = make_shared<SpecialMix>(3, 500);
+	for (int i = 0; i < flavours; ++i) {
+		shared_ptr<Product> p = make_shared<Product>("yogurt " + std::to_string(i), i % 4 == 0 ? 249 : 199);
+		p->assignSpecial(deal);
+		inv->insert(p);
+	}
+	std::mt19937 rng(5);
+	printf("%10s %16s %16s %20s\n", "basket", "scan ns", "remove ns", "reprice scan ns");
+	for (int basket : {3, 30, 300, 3000}) {
+		int rounds = scans / basket;
+		vector<int> handles(basket);
+		for (int& h : handles) {
+			h = rng() % flavours;
+		}
+		Register reg;
+		reg.assignInventory(inv);
+		reg.reserve(flavours);
+		long long check = 0;
+		Clock::duration scanTime(0), removeTime(0);
+		for (int r = 0; r < rounds; ++r) {
+			reg.reset();
+			Clock::time_point start = Clock::now();
+			for (int h : handles) {
+				reg.scanItem(h);
+			}
+			Clock::time_point scanned = Clock::now();
+			for (int i = 0; i < basket; i += 4) {
+				reg.removeItem(handles[i]);
+			}
+			Clock::time_point removed = Clock::now();
+			scanTime += scanned - start;
+			removeTime += removed - scanned;
+			check += reg.getTotal();
+		}
+
+		vector<int> units;
+		units.reserve(basket);
+		Clock::time_point start = Clock::now();
+		for (int r = 0; r < rounds; ++r) {
+			units.clear();
+			for (int h : handles) {
+				units.push_back(h % 4 == 0 ? 249 : 199);
+				check += repriceBasket(units);
+			}
+		}
+		Clock::duration repriceTime = Clock::now() - start;
+		double n = (double) rounds * basket;
+		printf("%10d %16.1f %16.1f %20.1f\n", basket, seconds(scanTime) * 1e9 / n,
+			seconds(removeTime) * 1e9 / (rounds * ((basket + 3) / 4)), seconds(repriceTime) * 1e9 / n);
+		if (check == 0) {
+			printf("unexpected zero checksum\n");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,177 @@
+//times the basket optimizer on 200 line baskets built to overlap specials
+//as badly as possible: every product with stacked item specials, chains of
+//group deals sharing products, and dense random group overlaps, cold, as
+//rescans after each item, and repeated from the memo
+#include "inventory.h"
+#include "optimizer.h"
+#include "register.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+const int PRODUCTS = 1000;
+const int LINES = 200;
+
+SpecialTerms terms(int kind, int purchaseQuantity, int discountQuantity, int discountPercentage, int discountPrice, int limit) {
+	SpecialTerms t;
+	t.kind = kind;
+	t.purchaseQuantity = purchaseQuantity;
+	t.discountQuantity = discountQuantity;
+	t.discountPercentage = discountPercentage;
+	t.discountPrice = discountPrice;
+	t.limit = limit;
+	return t;
+}
+
+Promotion promotion(const SpecialTerms& t, const vector<int>& handles) {
+	Promotion p;
+	p.terms = t;
+	p.handles = handles;
+	return p;
+}
+
+struct Scenario {
+	const char* name;
+	int maxQuantity;
+	void (*promote)(BasketOptimizer&, std::mt19937&);
+};
+
+void stacked(BasketOptimizer& opt, std::mt19937& rng) {
+	//a bulk price and a second BOGO on every product, over its catalog BOGO
+	for (int h = 0; h < PRODUCTS; ++h) {
+		opt.addPromotion(promotion(terms(SPECIAL_BULK, 2 + rng() % 4, 0, 0, 300 + rng() % 500, rng() % 2 ? 6 : 0), {h}));
+		opt.addPromotion(promotion(terms(SPECIAL_BOGO, 3, 2, 50, 0, 0), {h}));
+	}
+}
+
+void chained(BasketOptimizer& opt, std::mt19937& rng) {
+	//stacked item specials, plus group deals on sliding windows of products
+	//so that every product is in two and all of them link into one chain
+	stacked(opt, rng);
+	for (int start = 0; start < PRODUCTS; start += 5) {
+		vector<int> window;
+		for (int h = start; h < start + 10 && h < PRODUCTS; ++h) {
+			window.push_back(h);
+		}
+		int n = 2 + rng() % 3;
+		opt.addPromotion(promotion(terms(SPECIAL_MIX, n, 0, 0, n * (120 + rng() % 100), rng() % 2 ? 2 * n : 0), window));
+	}
+}
+
+void dense(BasketOptimizer& opt, std::mt19937& rng) {
+	//stacked item specials, plus 24 group deals each on a random third of
+	//the products, so a basket's groups all overlap
+	stacked(opt, rng);
+	for (int g = 0; g < 24; ++g) {
+		vector<int> members;
+		for (int h = 0; h < PRODUCTS; ++h) {
+			if (rng() % 3 == 0) {
+				members.push_back(h);
+			}
+		}
+		int n = 2 + rng() % 3;
+		opt.addPromotion(promotion(terms(SPECIAL_MIX, n, 0, 0, n * (120 + rng() % 100), 0), members));
+	}
+}
+
+double micros(Clock::duration d) {
+	return std::chrono::duration<double, std::micro>(d).count();
+}
+
+//times and outcomes of one kind of call
+struct Calls {
+	vector<double> wall;
+	long bounded = 0, timedOut = 0;
+	double bound = 0, total = 0;
+
+	void time(BasketOptimizer& opt, const Register& reg, OptimizedBasket& best) {
+		long b = opt.getBounded(), t = opt.getTimedOut();
+		Clock::time_point start = Clock::now();
+		opt.optimize(reg, best);
+		wall.push_back(micros(Clock::now() - start));
+		bounded += opt.getBounded() > b;
+		timedOut += opt.getTimedOut() > t;
+		bound += best.bound;
+		total += best.total;
+	}
+};
+
+void report(const char* scenario, const char* mode, Calls& calls) {
+	vector<double>& times = calls.wall;
+	std::sort(times.begin(), times.end());
+	long over = times.end() - std::upper_bound(times.begin(), times.end(), 1000.0);
+	double n = times.size();
+	printf("%-9s %-7s %8.1f %8.1f %8.1f %8.2f%% %8.2f%% %8.2f%% %7.2f%%\n", scenario, mode, times[times.size() / 2],
+		times[times.size() * 99 / 100], times.back(), 100.0 * over / n, 100.0 * calls.bounded / n,
+		100.0 * calls.timedOut / n, calls.total > 0 ? 100.0 * calls.bound / calls.total : 0.0);
+}
+
+}
+
+int main(int argc, char** argv) {
+	int baskets = argc > 1 ? atoi(argv[1]) : 200;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	std::mt19937 rng(25);
+	for (int h = 0; h < PRODUCTS; ++h) {
+		shared_ptr<Product> p = make_shared<Product>("product " + std::to_string(h), 99 + rng() % 900);
+		p->assignSpecial(make_shared<SpecialBogo>(1 + rng() % 3, 1, 25 * (1 + rng() % 4)));
+		inv->insert(p);
+	}
+	Scenario scenarios[] = {{"stacked", 12, stacked}, {"chained", 4, chained}, {"dense", 3, dense}};
+	printf("%-9s %-7s %8s %8s %8s %9s %9s %9s %8s\n", "overlaps", "mode", "p50 us", "p99 us", "max us", "over 1ms",
+		"bounded", "timed out", "bound");
+	long long check = 0;
+	for (const Scenario& scenario : scenarios) {
+		BasketOptimizer opt;
+		scenario.promote(opt, rng);
+		Calls cold, rescan, memo;
+		for (int b = 0; b < baskets; ++b) {
+			vector<int> handles(PRODUCTS);
+			for (int h = 0; h < PRODUCTS; ++h) {
+				handles[h] = h;
+			}
+			std::shuffle(handles.begin(), handles.end(), rng);
+			Register reg;
+			reg.assignInventory(inv);
+			OptimizedBasket best;
+			//rescan: optimize after every line is scanned, as a display would
+			opt.clear();
+			for (int i = 0; i < LINES; ++i) {
+				int q = 1 + rng() % scenario.maxQuantity;
+				for (int k = 0; k < q; ++k) {
+					reg.scanItem(handles[i]);
+				}
+				rescan.time(opt, reg, best);
+			}
+			opt.clear();
+			cold.time(opt, reg, best);
+			memo.time(opt, reg, best);
+			check += best.total;
+			if (best.total > reg.getTotal()) {
+				printf("optimized %d above register %d\n", best.total, reg.getTotal());
+				return 1;
+			}
+		}
+		report(scenario.name, "cold", cold);
+		report(scenario.name, "rescan", rescan);
+		report(scenario.name, "memo", memo);
+	}
+	printf("(bounded: share of calls with a connected set not searched whole, timed out: of those past the time\n"
+		"limit; bound: sum of bounds over sum of totals; checksum %lld)\n", check);
+	return 0;
+}
@@ -0,0 +1,92 @@
+//compares scanning with and without the register's price cache, on baskets
+//drawn from a Zipf distribution over the catalog, and reports hit rates
+#include "inventory.h"
+#include "register.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::duration d) {
+	return std::chrono::duration<double>(d).count();
+}
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 100000;
+	int scans = argc > 2 ? atoi(argv[2]) : 5000000;
+	double skew = argc > 3 ? atof(argv[3]) : 1.0;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->reserve(skus);
+	shared_ptr<Special> bogo = make_shared<SpecialBogo>(2, 1, 50);
+	shared_ptr<Special> bulk = make_shared<SpecialBulk>(6, 499);
+	shared_ptr<Special> limited = make_shared<SpecialBogo>(1, 1, 100);
+	limited->setLimit(4);
+	for (int i = 0; i < skus; ++i) {
+		string name = "product " + std::to_string(i);
+		PriceRow row;
+		row.price = 100 + i % 900;
+		row.byWeight = i % 10 == 0;
+		shared_ptr<Special> s = i % 3 == 1 ? bogo : i % 3 == 2 ? bulk : i % 11 == 3 ? limited : nullptr;
+		inv->insertRow(name.data(), name.size(), row, s);
+	}
+
+	//rank r is drawn with probability proportional to 1 / r^skew, and ranks
+	//are scattered over the catalog so hot products aren't neighbours
+	vector<double> cdf(skus);
+	double sum = 0;
+	for (int r = 0; r < skus; ++r) {
+		sum += 1 / std::pow(r + 1, skew);
+		cdf[r] = sum;
+	}
+	vector<int> rankToHandle(skus);
+	for (int i = 0; i < skus; ++i) {
+		rankToHandle[i] = i;
+	}
+	std::mt19937 rng(3);
+	std::shuffle(rankToHandle.begin(), rankToHandle.end(), rng);
+	std::uniform_real_distribution<double> uniform(0, sum);
+	vector<int> handles(scans);
+	for (int& h : handles) {
+		h = rankToHandle[std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()];
+	}
+
+	printf("%d skus, %d scans, zipf skew %.2f, baskets of 100\n", skus, scans, skew);
+	printf("%-14s %14s %10s\n", "cache entries", "scans/sec", "hit rate");
+	for (int entries : {0, 256, 1024, 4096, 16384}) {
+		Register reg;
+		reg.assignInventory(inv);
+		reg.reserve(128);
+		reg.setPriceCache(entries);
+		double best = 1e9;
+		long long check = 0;
+		for (int rep = 0; rep < 3; ++rep) {
+			Clock::duration elapsed(0);
+			for (int i = 0; i < scans; i += 100) {
+				reg.reset();
+				auto start = Clock::now();
+				for (int k = i; k < i + 100 && k < scans; ++k) {
+					reg.scanItem(handles[k], 125);
+				}
+				elapsed += Clock::now() - start;
+				check += reg.getTotal();
+			}
+			best = std::min(best, seconds(elapsed));
+		}
+		const PriceCache& cache = reg.getPriceCache();
+		printf("%-14d %14.0f %9.1f%%   (check %lld)\n", entries, scans / best, 100 * cache.getHitRate(), check);
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+//compares weighted line pricing in integer fixed point against the former
+//floating point calcPrice, each pricing a weight onto an empty line
+#include "pricing.h"
+#include "special.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using std::vector;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+__attribute__((noinline)) static int baselineCalcPrice(int p, int w, int q, const Special* s) {
+	//Register::calcPrice as it was before pricing moved to integers, kept
+	//verbatim apart from taking the special by pointer: what adding w
+	//hundredths of a pound (or one unit if w is 0) to q adds to a line
+	int total = 0;
+	int overLimit = 0; //used for weight priced specials
+	if (w && s && s->getLimit() != 0) {
+		overLimit = w + q - s->getLimit();
+		overLimit = overLimit > 0 ? overLimit : 0;
+		w -= overLimit;
+	}
+	if (w && s) { //special for weighted item
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		int discountPrice = (int) (p * ((100 - discountPercentage) / 100.0) + .5); //cents per lb
+		int price = 0;
+		int fullCycles = w / totalSpecialQuantity; //amount of sets of max full price and discount price quantities
+		w = w % totalSpecialQuantity; //amount left over after taking out full sets
+		price += ((int) ((fullCycles * discountPrice * discountQuantity / 100.0) + (fullCycles * p * purchaseQuantity / 100.0) + .5)); //adding the total of max full and discount price quantities
+		int margin = q % totalSpecialQuantity; //amount of product towards next cycle previously scanned
+		if (margin / purchaseQuantity) { //already in discount price
+			int discPriceQuantity = totalSpecialQuantity - margin; //calculate how much quantity to add until out of discount price range and add
+			discPriceQuantity = discPriceQuantity < w ? discPriceQuantity : w; //check if enough weight to cover dpq range
+			price += ((int) (discountPrice * (discPriceQuantity / 100.0) + .5));
+			w -= discPriceQuantity;
+			price += ((int) (p * (w / 100.0) + .5)); //dump rest into full price
+		}
+		else { //have some way to go in full price
+			int fullPriceQuantity = purchaseQuantity - margin; //calculate how much quantity to add in full price range and add
+			fullPriceQuantity = fullPriceQuantity < w ? fullPriceQuantity : w; //check if enough weight to cover fPQ
+			w -= fullPriceQuantity;
+			price += ((int) (p * (fullPriceQuantity / 100.0) + .5));
+			price += ((int) (discountPrice * (w / 100.0) + .5)); //dump rest into disc price
+		}
+		w = overLimit;
+		total = price;
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BOGO") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		if (q % totalSpecialQuantity >= purchaseQuantity) {
+			double discountPrice = 100 - discountPercentage;
+			discountPrice /= 100.0;
+			discountPrice *= p;
+			discountPrice += .5; //for rounding
+			p = (int) discountPrice;
+		}
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BULK") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountPrice = s->getDiscountPrice();
+		if (q % purchaseQuantity == purchaseQuantity - 1) {
+			p = discountPrice - (p * (purchaseQuantity - 1));
+		}
+	}
+	if (w != 0) { //multiply price per pound by quantity in
+		//hundredths of a pound
+		double lbScanned = w / 100.0;
+		double cost = lbScanned * p;
+		cost += .5; //for rounding
+		total += (int) cost;
+	}
+	if (total) { //for weight priced items
+		p = total;
+	}
+	return p;
+}
+
+int main(int argc, char** argv) {
+	int lines = argc > 1 ? atoi(argv[1]) : 10000000;
+	SpecialBogo bogo(200, 100, 35, 900);
+	std::mt19937 rng(4242);
+	std::uniform_int_distribution<int> price(50, 2999);
+	std::uniform_int_distribution<int> weight(1, 2000);
+	vector<int> prices(1 << 16);
+	vector<int> weights(1 << 16);
+	vector<const Special*> specials(1 << 16);
+	for (size_t i = 0; i < prices.size(); ++i) {
+		prices[i] = price(rng);
+		weights[i] = weight(rng);
+	}
+	size_t mask = prices.size() - 1;
+	printf("lines=%d\n", lines);
+	const char* mixes[3] = {"no special", "BOGO special", "mixed"};
+	for (int mix = 0; mix < 3; ++mix) {
+		for (size_t i = 0; i < specials.size(); ++i) {
+			specials[i] = (mix == 1 || (mix == 2 && i % 2)) ? &bogo : nullptr;
+		}
+		long long sum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < lines; ++i) {
+			sum += baselineCalcPrice(prices[i & mask], weights[i & mask], 0, specials[i & mask]);
+		}
+		double legacyTime = secondsSince(start);
+
+		long long fixedSum = 0;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < lines; ++i) {
+			const Special* s = specials[i & mask];
+			fixedSum += linePrice(prices[i & mask], true, weights[i & mask], s ? &s->getTerms() : nullptr);
+		}
+		double fixedTime = secondsSince(start);
+
+		printf("%s:\n", mixes[mix]);
+		printf("  floating point: %.2f ns/line, %.1f M lines/sec\n", legacyTime * 1e9 / lines, lines / legacyTime / 1e6);
+		printf("  fixed point:    %.2f ns/line, %.1f M lines/sec\n", fixedTime * 1e9 / lines, lines / fixedTime / 1e6);
+		printf("  totals %lld %lld\n", sum, fixedSum); //differ by the drifts test_pricing documents
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+//compares basket quantity stores over a distribution of basket sizes: the
+//adaptive QuantityStore, an unordered_map, and a flat array indexed by
+//handle with the scanned lines tracked for reset
+#include "quantity.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using std::unordered_map;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct FlatStore {
+	vector<int> quantity;
+	vector<int> lines;
+	FlatStore(int handles) : quantity(handles, 0) { }
+	int get(int h) const { return quantity[h]; }
+	void set(int h, int q) {
+		if (quantity[h] == 0) {
+			lines.push_back(h);
+		}
+		quantity[h] = q;
+	}
+	void clear() {
+		for (int h : lines) {
+			quantity[h] = 0;
+		}
+		lines.clear();
+	}
+};
+
+struct MapStore {
+	unordered_map<int, int> quantity;
+	int get(int h) const {
+		auto i = quantity.find(h);
+		return i == quantity.end() ? 0 : i->second;
+	}
+	void set(int h, int q) { quantity[h] = q; }
+	void clear() { quantity.clear(); }
+};
+
+template <typename Store>
+static double run(Store& store, const vector<vector<int>>& baskets, long long& sum) {
+	//scans each item of each basket as the register does, reading the line's
+	//quantity then writing it back one higher, then starts the next basket
+	auto start = Clock::now();
+	for (const vector<int>& basket : baskets) {
+		for (int h : basket) {
+			store.set(h, store.get(h) + 1);
+		}
+		sum += store.get(basket[0]);
+		store.clear();
+	}
+	return secondsSince(start);
+}
+
+int main(int argc, char** argv) {
+	int skus = argc > 1 ? atoi(argv[1]) : 1000000;
+	int count = argc > 2 ? atoi(argv[2]) : 200000;
+	//distinct products per basket: mostly under 16, with a long tail of large
+	//shops, roughly log-normal around 8
+	std::mt19937 rng(2024);
+	std::lognormal_distribution<double> distinct(2.0, 0.8);
+	std::geometric_distribution<int> units(0.6);
+	std::uniform_int_distribution<int> product(0, skus - 1);
+	vector<vector<int>> baskets(count);
+	long long items = 0;
+	int small = 0;
+	for (vector<int>& basket : baskets) {
+		int d = std::max(1, std::min(300, (int) distinct(rng)));
+		small += d <= QuantityStore::INLINE_LINES;
+		for (int i = 0; i < d; ++i) {
+			int h = product(rng);
+			for (int u = units(rng); u >= 0; --u) {
+				basket.push_back(h);
+			}
+		}
+		std::shuffle(basket.begin(), basket.end(), rng);
+		items += basket.size();
+	}
+
+	long long sums[3] = {0, 0, 0};
+	QuantityStore adaptive;
+	MapStore map;
+	FlatStore flat(skus);
+	double adaptiveTime = 1e9, mapTime = 1e9, flatTime = 1e9;
+	for (int rep = 0; rep < 3; ++rep) {
+		adaptiveTime = std::min(adaptiveTime, run(adaptive, baskets, sums[0]));
+		mapTime = std::min(mapTime, run(map, baskets, sums[1]));
+		flatTime = std::min(flatTime, run(flat, baskets, sums[2]));
+	}
+
+	printf("skus=%d baskets=%d items=%lld, %.0f%% of baskets within %d products\n", skus, count, items,
+		100.0 * small / count, QuantityStore::INLINE_LINES);
+	printf("QuantityStore: %.1f ns/item\n", adaptiveTime * 1e9 / items);
+	printf("unordered_map: %.1f ns/item\n", mapTime * 1e9 / items);
+	printf("flat array:    %.1f ns/item, %zu KB per register\n", flatTime * 1e9 / items, flat.quantity.size() * sizeof(int) / 1024);
+	printf("checksums %lld %lld %lld\n", sums[0], sums[1], sums[2]);
+	return 0;
+}
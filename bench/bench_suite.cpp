@@ -0,0 +1,186 @@
+//microbenchmarks for the pricing hot path over catalog sizes, special mixes
+//and basket shapes. prints one JSON object per line, sorted the same way
+//every run, so results from two releases can be diffed line by line
+#include "inventory.h"
+#include "pricing.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+std::atomic<long long> allocations(0);
+
+}
+
+void* operator new(size_t n) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(n ? n : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+namespace {
+
+FILE* out = stdout;
+volatile long long sink = 0; //keeps results live so nothing timed is optimized away
+
+void report(const char* op, int skus, const char* mix, const char* basket, long long ops, double ns, long long allocs) {
+	//one result line, from the total time and allocations of ops operations
+	fprintf(out, "{\"op\":\"%s\",\"skus\":%d,\"mix\":\"%s\",\"basket\":\"%s\",\"ops\":%lld,"
+		"\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f,\"allocs_per_op\":%.3f}\n",
+		op, skus, mix, basket, ops, ns / ops, ops / (ns / 1e9), (double) allocs / ops);
+	fflush(out);
+}
+
+//times ops calls of f, which is handed the index of each
+template <typename F>
+void measure(const char* op, int skus, const char* mix, const char* basket, long long ops, F f) {
+	long long before = allocations.load(std::memory_order_relaxed);
+	auto start = Clock::now();
+	for (long long i = 0; i < ops; ++i) {
+		f(i);
+	}
+	double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	report(op, skus, mix, basket, ops, ns, allocations.load(std::memory_order_relaxed) - before);
+}
+
+struct Mix {
+	const char* name;
+	bool byWeight;
+	shared_ptr<Special> special;
+};
+
+struct Basket {
+	const char* name;
+	int items;
+	int distinct;
+};
+
+}
+
+int main(int argc, char** argv) {
+	//bench_suite [maxSkus] [output.json]
+	int maxSkus = argc > 1 ? atoi(argv[1]) : 1000000;
+	if (argc > 2 && !(out = fopen(argv[2], "w"))) {
+		fprintf(stderr, "can't write %s\n", argv[2]);
+		return 1;
+	}
+	shared_ptr<Special> limited = make_shared<SpecialBogo>(1, 1, 50);
+	limited->setLimit(400);
+	const Mix mixes[] = {
+		{"none", false, nullptr},
+		{"bogo", false, make_shared<SpecialBogo>(2, 1, 50)},
+		{"bulk", false, make_shared<SpecialBulk>(3, 500)},
+		{"weighted_bogo_limit", true, limited},
+	};
+	const Basket baskets[] = {
+		{"small", 10, 8}, //a few items, mostly different
+		{"large", 120, 60}, //a weekly shop
+		{"repeat", 48, 2}, //a case of soda and a case of water
+	};
+	const long long ops = 200000;
+	std::mt19937 rng(2024);
+
+	for (int skus = 1000; skus <= maxSkus; skus *= 10) {
+		vector<string> names(skus);
+		vector<shared_ptr<Product>> products(skus);
+		for (int i = 0; i < skus; ++i) {
+			names[i] = "product " + std::to_string(i * 7919);
+			products[i] = make_shared<Product>(names[i], 100 + i % 900);
+		}
+		shared_ptr<Inventory> inv = make_shared<Inventory>();
+		measure("Inventory::insert", skus, "none", "-", skus, [&](long long i) {
+			inv->insert(products[i]);
+		});
+		std::uniform_int_distribution<int> pick(0, skus - 1);
+
+		for (const Mix& mix : mixes) {
+			for (int i = 0; i < skus; ++i) {
+				products[i]->setByWeight(mix.byWeight);
+				products[i]->assignSpecial(mix.special);
+			}
+			int weight = mix.byWeight ? 125 : 0;
+
+			measure("Inventory::retrieve", skus, mix.name, "-", ops, [&](long long i) {
+				sink += inv->retrieve(names[(i * 7907) % skus])->getPrice();
+			});
+
+			const SpecialTerms* terms = mix.special ? &mix.special->getTerms() : nullptr;
+			measure("linePrice", skus, mix.name, "-", ops, [&](long long i) {
+				sink += linePrice(100 + i % 900, mix.byWeight, 1 + i % 500, terms);
+			});
+
+			for (const Basket& shape : baskets) {
+				//the basket's items, each one of shape.distinct products drawn
+				//at random from the whole catalog
+				vector<int> chosen(shape.distinct);
+				for (int& h : chosen) {
+					h = pick(rng);
+				}
+				vector<const string*> items(shape.items);
+				for (int i = 0; i < shape.items; ++i) {
+					items[i] = &names[chosen[i % shape.distinct]];
+				}
+				Register reg;
+				reg.assignInventory(inv);
+				reg.reserve(shape.distinct);
+				long long rounds = ops / shape.items;
+
+				//removals are timed on their own, each round first scanning the
+				//basket untimed
+				long long scanTime = 0, removeTime = 0;
+				long long scanAllocs = 0, removeAllocs = 0;
+				for (long long r = 0; r < rounds; ++r) {
+					long long a0 = allocations.load(std::memory_order_relaxed);
+					auto t0 = Clock::now();
+					for (const string* s : items) {
+						reg.scanItem(*s, weight);
+					}
+					auto t1 = Clock::now();
+					long long a1 = allocations.load(std::memory_order_relaxed);
+					for (const string* s : items) {
+						reg.removeItem(*s, weight);
+					}
+					auto t2 = Clock::now();
+					removeAllocs += allocations.load(std::memory_order_relaxed) - a1;
+					scanAllocs += a1 - a0;
+					scanTime += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+					removeTime += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+					sink += reg.getTotal();
+					reg.reset();
+				}
+				long long n = rounds * shape.items;
+				report("Register::scanItem", skus, mix.name, shape.name, n, scanTime, scanAllocs);
+				report("Register::removeItem", skus, mix.name, shape.name, n, removeTime, removeAllocs);
+			}
+		}
+	}
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
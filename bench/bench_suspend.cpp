@@ -0,0 +1,57 @@
+//times suspending a basket to a blob and resuming it on another register
+#include "inventory.h"
+#include "register.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char** argv) {
+	int lineCount = argc > 1 ? atoi(argv[1]) : 50;
+	int rounds = argc > 2 ? atoi(argv[2]) : 1000000;
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Special> bulk = make_shared<SpecialBulk>(3, 500);
+	for (int i = 0; i < 10000; ++i) {
+		string name = "product " + std::to_string(i);
+		PriceRow row;
+		row.price = 100 + i % 900;
+		row.byWeight = i % 10 == 0;
+		inv->insertRow(name.data(), name.size(), row, i % 4 == 1 ? bulk : nullptr);
+	}
+	Register kiosk;
+	kiosk.assignInventory(inv);
+	for (int i = 0; i < lineCount; ++i) {
+		int h = i * 197 % 10000;
+		kiosk.scanItem(h, 125);
+		kiosk.scanItem(h, 125);
+	}
+	Register lane;
+	lane.assignInventory(inv);
+	lane.reserve(lineCount);
+	vector<char> blob(kiosk.suspendedSize());
+
+	double best = 1e9;
+	long long check = 0;
+	for (int rep = 0; rep < 3; ++rep) {
+		auto start = Clock::now();
+		for (int i = 0; i < rounds; ++i) {
+			size_t n = kiosk.suspend(blob.data(), blob.size());
+			check += lane.resume(blob.data(), n);
+		}
+		double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / rounds;
+		best = ns < best ? ns : best;
+	}
+	printf("%d lines, %zu byte blob: %.0f ns per suspend and resume (check %lld, total %s)\n",
+		lineCount, blob.size(), best, check, lane.getTotal() == kiosk.getTotal() ? "matches" : "DIFFERS");
+	return 0;
+}
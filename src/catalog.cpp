@@ -0,0 +1,582 @@
+#include "catalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::memory_order_seq_cst;
+
+namespace {
+
+//leads the catalog section of a catalog file, followed by the slots, rows,
+//name offsets and name bytes, all in native byte order
+struct SectionHeader {
+	uint32_t rowCount;
+	uint32_t slotCount;
+	uint32_t nameBytes;
+	uint32_t reserved;
+};
+
+const uint32_t BY_WEIGHT = 0x80000000u;
+const uint32_t ERASED = 0x40000000u;
+const uint32_t SPECIAL_MASK = 0x3fffffffu;
+const uint32_t TOMBSTONE = 0xffffffffu; //low half of an erased row's slot in files
+	//written before erased rows kept their slots
+
+//a thread's announcement of the epoch its outermost Reader began in, 0
+//while it has none. records are kept for the life of the process on a
+//list shared by every catalog, and handed on to new threads as threads exit
+struct ReaderRecord {
+	std::atomic<uint64_t> epoch;
+	std::atomic<bool> taken;
+	ReaderRecord* next;
+	char pad[64]; //keeps another thread's record off the cache line
+};
+
+std::atomic<uint64_t> globalEpoch(1);
+std::atomic<ReaderRecord*> readerRecords(nullptr);
+thread_local ReaderRecord* readerRecord = nullptr; //plain, so reading it needs no guard
+thread_local int readerDepth = 0;
+
+bool registerBarrier() {
+	return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+}
+
+//when the kernel can make every thread of the process run a full barrier on
+//the writer's behalf, readers announce their epoch with a plain store and
+//the writer pays for the barrier when it reclaims, which is rare; otherwise
+//each reader fences
+const bool asymmetric = registerBarrier();
+
+struct RecordRelease {
+	~RecordRelease() {
+		readerRecord->taken.store(false, memory_order_release);
+	}
+};
+
+ReaderRecord* claimRecord() {
+	static thread_local RecordRelease release; //hands the record on at thread exit
+	(void) release;
+	for (ReaderRecord* r = readerRecords.load(memory_order_acquire); r; r = r->next) {
+		bool taken = false;
+		if (!r->taken.load(memory_order_relaxed) && r->taken.compare_exchange_strong(taken, true)) {
+			return r;
+		}
+	}
+	ReaderRecord* r = new ReaderRecord();
+	r->epoch.store(0, memory_order_relaxed);
+	r->taken.store(true, memory_order_relaxed);
+	r->next = readerRecords.load(memory_order_relaxed);
+	while (!readerRecords.compare_exchange_weak(r->next, r, memory_order_release, memory_order_relaxed)) {
+	}
+	return r;
+}
+
+}
+
+Catalog::Reader::Reader() {
+	//the barrier orders the announcement before the reads of the table, and
+	//pairs with the one in reclaim: either the writer sees the epoch, or
+	//this thread sees the table that replaced the one being freed
+	if (readerDepth++ == 0) {
+		if (!readerRecord) {
+			readerRecord = claimRecord();
+		}
+		readerRecord->epoch.store(globalEpoch.load(memory_order_acquire), memory_order_relaxed);
+		if (asymmetric) {
+			std::atomic_signal_fence(memory_order_seq_cst);
+		}
+		else {
+			std::atomic_thread_fence(memory_order_seq_cst);
+		}
+	}
+}
+
+Catalog::Reader::~Reader() {
+	if (--readerDepth == 0) {
+		readerRecord->epoch.store(0, memory_order_release);
+	}
+}
+
+Catalog::Table::Table() {
+	slotCount = 0;
+	slots = nullptr;
+	rowCapacity = 0;
+	rows = nullptr;
+	nameOffsets = nullptr;
+	nameCapacity = 0;
+	names = nullptr;
+	specialCapacity = 0;
+	specials = nullptr;
+	owned = true;
+}
+
+Catalog::Table::~Table() {
+	if (owned) {
+		delete[] slots;
+		delete[] rows;
+		delete[] nameOffsets;
+		delete[] names;
+	}
+	delete[] specials;
+}
+
+Catalog::Catalog() {
+	rowCount.store(0);
+	specialCount.store(0);
+	table.store(nullptr);
+	grow(nullptr, 0, 0, 0, 0, 0);
+}
+
+Catalog::Catalog(const Catalog& o) {
+	//a copy always owns its arrays, even when the original is mapped
+	int n = o.size();
+	int s = o.specialsSize();
+	rowCount.store(n);
+	specialCount.store(s);
+	generations = o.generations;
+	table.store(nullptr);
+	grow(o.table.load(memory_order_acquire), n, s, n, 0, s);
+}
+
+uint32_t Catalog::hash(const char* s, size_t n) {
+	uint32_t h = 2166136261u; //32 bit FNV-1a
+	for (size_t i = 0; i < n; ++i) {
+		h ^= (unsigned char) s[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+size_t Catalog::probe(const Table* t, const char* s, size_t n, uint32_t h, int* row) const {
+	//returns the slot holding the name, or the empty slot where it would go,
+	//and the row the slot held when it was read (-1 if empty), erased or not
+	size_t mask = t->slotCount - 1;
+	for (size_t i = h & mask; ; i = (i + 1) & mask) {
+		uint64_t v = t->slots[i].load(memory_order_acquire);
+		if (v == 0) {
+			*row = -1;
+			return i;
+		}
+		if ((uint32_t) v == TOMBSTONE) {
+			continue;
+		}
+		//stored hash rejects almost every mismatch without touching the name
+		if ((uint32_t) (v >> 32) == h) {
+			int r = (int) (uint32_t) v - 1;
+			const uint32_t* off = t->nameOffsets;
+			if (off[r + 1] - off[r] == n && memcmp(t->names + off[r], s, n) == 0) {
+				*row = r;
+				return i;
+			}
+		}
+	}
+}
+
+int Catalog::find(const char* s, size_t n) const {
+	Reader pin;
+	const Table* t = table.load(memory_order_acquire);
+	int row;
+	probe(t, s, n, hash(s, n), &row);
+	if (row != -1 && (t->rows[row].flags.load(memory_order_relaxed) & ERASED) != 0) {
+		return -1;
+	}
+	return row;
+}
+
+int Catalog::insert(const char* s, size_t n, const PriceRow& r, PriceRow* replaced) {
+	//returns the new row's handle, or -1 if the name is present. a name
+	//erased before gets its old handle back, optionally reporting the row
+	//it replaces
+	if (!retired.empty()) {
+		reclaim();
+	}
+	Table* t = table.load(memory_order_relaxed);
+	uint32_t h = hash(s, n);
+	int found;
+	size_t i = probe(t, s, n, h, &found);
+	if (found != -1) {
+		PriceRow old = getRow(found);
+		if (!old.erased) {
+			return -1;
+		}
+		if (replaced) {
+			*replaced = old;
+		}
+		PriceRow row = r;
+		row.erased = 0;
+		setRow(found, row);
+		return found;
+	}
+	int row = rowCount.load(memory_order_relaxed);
+	size_t nameStart = t->nameOffsets[row];
+	if (!t->owned || row + 1 > t->rowCapacity || nameStart + n > t->nameCapacity) {
+		t = grow(t, row, specialCount.load(memory_order_relaxed), row + 1, nameStart + n, 0);
+		i = probe(t, s, n, h, &found);
+	}
+	//everything a reader needs is written before the row count and the slot
+	//are published
+	storeRow(t->rows[row], r);
+	memcpy(t->names + nameStart, s, n);
+	t->nameOffsets[row + 1] = nameStart + n;
+	rowCount.store(row + 1, memory_order_release);
+	t->slots[i].store(((uint64_t) h << 32) | (uint32_t) (row + 1), memory_order_release);
+	return row;
+}
+
+bool Catalog::erase(int h) {
+	//marks the row erased so its name no longer resolves; the row keeps its
+	//prices so a basket holding it can still remove it, and its slot so the
+	//name can be given the handle again
+	if (h < 0 || h >= rowCount.load(memory_order_relaxed)) {
+		return false;
+	}
+	PriceRow r = getRow(h);
+	if (r.erased) {
+		return false;
+	}
+	r.erased = 1;
+	setRow(h, r);
+	return true;
+}
+
+void Catalog::reserve(int n) {
+	Table* t = table.load(memory_order_relaxed);
+	if (n > t->rowCapacity) {
+		grow(t, rowCount.load(memory_order_relaxed), specialCount.load(memory_order_relaxed), n, 0, 0);
+	}
+}
+
+PriceRow Catalog::getRow(int h, uint32_t* version, SpecialTerms* terms, uint32_t* generation) const {
+	//optionally reports the row's version, which every change to the row
+	//advances, so a caller can tell whether something it derived from the
+	//row is still current, and the terms of its special and the generation
+	//of its slot, read consistently with the row. terms and generation are
+	//left as they were if the row has no special
+	Reader pin;
+	const Table* t = table.load(memory_order_acquire);
+	const Row& row = t->rows[h];
+	PriceRow r;
+	SpecialTerms special;
+	uint32_t before, after, flags, slotGeneration = 0;
+	do {
+		before = row.seq.load(memory_order_acquire);
+		r.price = row.price.load(memory_order_relaxed);
+		r.markdown = row.markdown.load(memory_order_relaxed);
+		flags = row.flags.load(memory_order_relaxed);
+		if (terms && (flags & SPECIAL_MASK) != 0) {
+			//while the row refers to the slot it can't be given to another
+			//special, so an unchanged sequence means the copy is whole
+			const Terms& slot = t->specials[(flags & SPECIAL_MASK) - 1];
+			special = loadTerms(slot);
+			slotGeneration = slot.generation.load(memory_order_relaxed);
+		}
+		std::atomic_thread_fence(memory_order_acquire);
+		after = row.seq.load(memory_order_relaxed);
+	} while ((before & 1) || before != after); //retry if the writer was mid change
+	r.byWeight = (flags & BY_WEIGHT) != 0;
+	r.erased = (flags & ERASED) != 0;
+	r.special = (int) (flags & SPECIAL_MASK) - 1;
+	if (version) {
+		*version = before;
+	}
+	if (terms && r.special != -1) {
+		*terms = special;
+		if (generation) {
+			*generation = slotGeneration;
+		}
+	}
+	return r;
+}
+
+void Catalog::setRow(int h, const PriceRow& r) {
+	if (!retired.empty()) {
+		reclaim();
+	}
+	Table* t = table.load(memory_order_relaxed);
+	if (!t->owned) {
+		int n = rowCount.load(memory_order_relaxed);
+		t = grow(t, n, specialCount.load(memory_order_relaxed), n, 0, 0);
+	}
+	storeRow(t->rows[h], r);
+}
+
+void Catalog::storeRow(Row& row, const PriceRow& r) {
+	uint32_t seq = row.seq.load(memory_order_relaxed);
+	row.seq.store(seq + 1, memory_order_relaxed);
+	std::atomic_thread_fence(memory_order_release);
+	row.price.store(r.price, memory_order_relaxed);
+	row.markdown.store(r.markdown, memory_order_relaxed);
+	row.flags.store((uint32_t) (r.special + 1) | (r.byWeight ? BY_WEIGHT : 0) | (r.erased ? ERASED : 0), memory_order_relaxed);
+	row.seq.store(seq + 2, memory_order_release);
+}
+
+void Catalog::storeTerms(Terms& slot, const SpecialTerms& t, uint32_t generation) {
+	slot.kind.store(t.kind, memory_order_relaxed);
+	slot.purchaseQuantity.store(t.purchaseQuantity, memory_order_relaxed);
+	slot.discountQuantity.store(t.discountQuantity, memory_order_relaxed);
+	slot.discountPercentage.store(t.discountPercentage, memory_order_relaxed);
+	slot.discountPrice.store(t.discountPrice, memory_order_relaxed);
+	slot.limit.store(t.limit, memory_order_relaxed);
+	slot.generation.store(generation, memory_order_relaxed);
+}
+
+SpecialTerms Catalog::loadTerms(const Terms& slot) {
+	SpecialTerms t;
+	t.kind = slot.kind.load(memory_order_relaxed);
+	t.purchaseQuantity = slot.purchaseQuantity.load(memory_order_relaxed);
+	t.discountQuantity = slot.discountQuantity.load(memory_order_relaxed);
+	t.discountPercentage = slot.discountPercentage.load(memory_order_relaxed);
+	t.discountPrice = slot.discountPrice.load(memory_order_relaxed);
+	t.limit = slot.limit.load(memory_order_relaxed);
+	return t;
+}
+
+int Catalog::addSpecial(const SpecialTerms& terms) {
+	//returns the new slot's index, published before any row can refer to it
+	if (!retired.empty()) {
+		reclaim();
+	}
+	Table* t = table.load(memory_order_relaxed);
+	int i = specialCount.load(memory_order_relaxed);
+	if (i + 1 > t->specialCapacity) {
+		t = grow(t, rowCount.load(memory_order_relaxed), i, 0, 0, i + 1);
+	}
+	storeTerms(t->specials[i], terms, ++generations);
+	specialCount.store(i + 1, memory_order_release);
+	return i;
+}
+
+void Catalog::setSpecial(int i, const SpecialTerms& terms) {
+	//gives slot i, which no row may refer to, to another special. a reader
+	//still copying the slot for a row which referred to it before sees that
+	//row's sequence move on and retries, as the fence orders the row's
+	//change before the new terms
+	Table* t = table.load(memory_order_relaxed);
+	std::atomic_thread_fence(memory_order_release);
+	storeTerms(t->specials[i], terms, ++generations);
+}
+
+SpecialTerms Catalog::getSpecial(int i, uint32_t* generation) const {
+	//the terms in slot i. only whole while a row the caller has read refers
+	//to the slot and hasn't changed since, or when the catalog isn't
+	//changing; scans read a row's special through getRow instead
+	Reader pin;
+	const Terms& slot = table.load(memory_order_acquire)->specials[i];
+	if (generation) {
+		*generation = slot.generation.load(memory_order_relaxed);
+	}
+	return loadTerms(slot);
+}
+
+string Catalog::getName(int h) const {
+	Reader pin;
+	const Table* t = table.load(memory_order_acquire);
+	return string(t->names + t->nameOffsets[h], t->nameOffsets[h + 1] - t->nameOffsets[h]);
+}
+
+const char* Catalog::getName(int h, size_t* length) const {
+	//the name in place, without copying; it stays valid while the caller
+	//holds a Reader, or until the catalog next changes
+	Reader pin;
+	const Table* t = table.load(memory_order_acquire);
+	*length = t->nameOffsets[h + 1] - t->nameOffsets[h];
+	return t->names + t->nameOffsets[h];
+}
+
+Catalog::Table* Catalog::grow(const Table* src, int rows, int specials, int minRows, size_t minNames, int minSpecials) {
+	//publishes an owned table holding the first rows and specials of src,
+	//doubling each array until it fits the requested minimum
+	unique_ptr<Table> t(new Table());
+	t->rowCapacity = std::max(src ? src->rowCapacity : 0, 16);
+	while (t->rowCapacity < minRows) {
+		t->rowCapacity *= 2;
+	}
+	t->slotCount = 16;
+	while ((size_t) t->rowCapacity * 4 > t->slotCount * 3) { //keep load factor at most 3/4
+		t->slotCount *= 2;
+	}
+	t->nameCapacity = std::max(src ? src->nameCapacity : 0, (size_t) 256);
+	while (t->nameCapacity < minNames) {
+		t->nameCapacity *= 2;
+	}
+	t->specialCapacity = std::max(src ? src->specialCapacity : 0, 4);
+	while (t->specialCapacity < minSpecials) {
+		t->specialCapacity *= 2;
+	}
+	t->slots = new std::atomic<uint64_t>[t->slotCount];
+	t->rows = new Row[t->rowCapacity];
+	t->nameOffsets = new uint32_t[t->rowCapacity + 1];
+	t->names = new char[t->nameCapacity];
+	t->specials = new Terms[t->specialCapacity];
+	for (size_t i = 0; i < t->slotCount; ++i) {
+		t->slots[i].store(0, memory_order_relaxed);
+	}
+	for (int i = 0; i < t->rowCapacity; ++i) {
+		t->rows[i].seq.store(0, memory_order_relaxed);
+	}
+	t->nameOffsets[0] = 0;
+	if (src) {
+		size_t mask = t->slotCount - 1;
+		for (size_t i = 0; i < src->slotCount; ++i) {
+			uint64_t v = src->slots[i].load(memory_order_relaxed);
+			if (v == 0 || (uint32_t) v == TOMBSTONE) {
+				continue;
+			}
+			size_t j = (v >> 32) & mask;
+			while (t->slots[j].load(memory_order_relaxed) != 0) {
+				j = (j + 1) & mask;
+			}
+			t->slots[j].store(v, memory_order_relaxed);
+		}
+		for (int i = 0; i < rows; ++i) {
+			t->rows[i].seq.store(src->rows[i].seq.load(memory_order_relaxed), memory_order_relaxed);
+			t->rows[i].price.store(src->rows[i].price.load(memory_order_relaxed), memory_order_relaxed);
+			t->rows[i].markdown.store(src->rows[i].markdown.load(memory_order_relaxed), memory_order_relaxed);
+			t->rows[i].flags.store(src->rows[i].flags.load(memory_order_relaxed), memory_order_relaxed);
+		}
+		memcpy(t->nameOffsets, src->nameOffsets, (rows + 1) * sizeof(uint32_t));
+		memcpy(t->names, src->names, src->nameOffsets[rows]);
+		for (int i = 0; i < specials; ++i) {
+			storeTerms(t->specials[i], loadTerms(src->specials[i]), src->specials[i].generation.load(memory_order_relaxed));
+		}
+	}
+	return publish(std::move(t));
+}
+
+Catalog::Table* Catalog::publish(unique_ptr<Table> t) {
+	//makes t current with one pointer store and retires the table it
+	//replaces in the epoch before the next, as a reader announcing any
+	//later one loaded the table after the store
+	Table* published = t.get();
+	table.store(published, memory_order_release);
+	if (current) {
+		retired.push_back(Retired{globalEpoch.fetch_add(1), std::move(current)});
+	}
+	current = std::move(t);
+	reclaim();
+	return published;
+}
+
+void Catalog::reclaim() {
+	//frees the retired tables which no reader can still be using: every
+	//reader running now began in a later epoch than they were retired in
+	if (!asymmetric) {
+		std::atomic_thread_fence(memory_order_seq_cst);
+	}
+	else if (syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) != 0) {
+		return; //readers' announcements may not be visible yet, so everything is kept
+	}
+	uint64_t oldest = UINT64_MAX;
+	for (ReaderRecord* r = readerRecords.load(memory_order_acquire); r; r = r->next) {
+		uint64_t e = r->epoch.load(memory_order_relaxed);
+		if (e != 0 && e < oldest) {
+			oldest = e;
+		}
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < retired.size(); ++i) {
+		if (retired[i].epoch >= oldest) {
+			retired[kept++] = std::move(retired[i]);
+		}
+	}
+	retired.resize(kept);
+}
+
+bool Catalog::write(FILE* f) const {
+	//callers must not change the catalog while it is being written
+	const Table* t = table.load(memory_order_acquire);
+	int n = size();
+	SectionHeader header;
+	header.rowCount = n;
+	header.slotCount = t->slotCount;
+	header.nameBytes = t->nameOffsets[n];
+	header.reserved = 0;
+	return fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(t->slots, sizeof(t->slots[0]), t->slotCount, f) == t->slotCount
+		&& fwrite(t->rows, sizeof(Row), n, f) == (size_t) n
+		&& fwrite(t->nameOffsets, sizeof(uint32_t), n + 1, f) == (size_t) n + 1
+		&& fwrite(t->names, 1, header.nameBytes, f) == header.nameBytes;
+}
+
+size_t Catalog::map(const char* data, size_t len, const vector<SpecialTerms>& specials) {
+	//points a new table at a catalog section written by write, which must
+	//stay mapped for the catalog's lifetime, with the given specials in its
+	//slots; returns the bytes used, or 0 if the section is malformed. every
+	//index in the section is checked against what it indexes, so a corrupt
+	//or truncated file fails to map instead of sending lookups out of bounds
+	static_assert(sizeof(Row) == 16 && sizeof(std::atomic<uint64_t>) == 8, "catalog file layout");
+	SectionHeader header;
+	if (len < sizeof(header) || ((uintptr_t) data & 7) != 0) {
+		return 0;
+	}
+	memcpy(&header, data, sizeof(header));
+	size_t slotBytes = (size_t) header.slotCount * 8;
+	size_t rowBytes = (size_t) header.rowCount * sizeof(Row);
+	size_t offsetBytes = ((size_t) header.rowCount + 1) * sizeof(uint32_t);
+	size_t used = sizeof(header) + slotBytes + rowBytes + offsetBytes + header.nameBytes;
+	if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0
+		|| header.rowCount >= header.slotCount || used > len) {
+		return 0;
+	}
+	const char* p = data + sizeof(header);
+	uint32_t* offsets = (uint32_t*) (p + slotBytes + rowBytes);
+	if (offsets[0] != 0 || offsets[header.rowCount] != header.nameBytes) {
+		return 0;
+	}
+	for (uint32_t h = 0; h < header.rowCount; ++h) {
+		if (offsets[h] > offsets[h + 1]) {
+			return 0;
+		}
+	}
+	//each slot names a row or is a tombstone, and one at least is empty so
+	//probes end
+	const std::atomic<uint64_t>* slots = (const std::atomic<uint64_t>*) p;
+	bool empty = false;
+	for (uint32_t i = 0; i < header.slotCount; ++i) {
+		uint64_t v = slots[i].load(memory_order_relaxed);
+		uint32_t row = (uint32_t) v;
+		if (v == 0) {
+			empty = true;
+		}
+		else if (row != TOMBSTONE && (row == 0 || row > header.rowCount)) {
+			return 0;
+		}
+	}
+	if (!empty) {
+		return 0;
+	}
+	//each row is whole, as a reader would otherwise wait on it forever, and
+	//refers to a special given
+	const Row* rows = (const Row*) (p + slotBytes);
+	for (uint32_t h = 0; h < header.rowCount; ++h) {
+		uint32_t special = rows[h].flags.load(memory_order_relaxed) & SPECIAL_MASK;
+		if ((rows[h].seq.load(memory_order_relaxed) & 1) != 0 || special > specials.size()
+			|| (special != 0 && specials[special - 1].kind == SPECIAL_NONE)) {
+			return 0;
+		}
+	}
+	unique_ptr<Table> t(new Table());
+	t->owned = false;
+	t->slotCount = header.slotCount;
+	t->slots = (std::atomic<uint64_t>*) p;
+	t->rowCapacity = header.rowCount;
+	t->rows = (Row*) (p + slotBytes);
+	t->nameOffsets = offsets;
+	t->nameCapacity = header.nameBytes;
+	t->names = (char*) (p + slotBytes + rowBytes + offsetBytes);
+	t->specialCapacity = std::max((int) specials.size(), 4);
+	t->specials = new Terms[t->specialCapacity];
+	for (size_t i = 0; i < specials.size(); ++i) {
+		storeTerms(t->specials[i], specials[i], ++generations);
+	}
+	rowCount.store(header.rowCount, memory_order_release);
+	specialCount.store(specials.size(), memory_order_release);
+	publish(std::move(t));
+	return used;
+}
@@ -0,0 +1,139 @@
+#ifndef _CATALOG_H_
+#define _CATALOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "special.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+//pricing fields read on every scan
+struct PriceRow {
+	int32_t price = 0; //if byWeight set, represents price per pound
+		//else, represents price per unit
+	int32_t markdown = 0;
+	int32_t byWeight = 0;
+	int32_t special = -1; //index of the special in the catalog, -1 if none
+	int32_t erased = 0; //set once the product is erased, its handle goes only to the same name
+};
+
+//open addressing hash index from product name to a dense handle, with the
+//hot pricing rows, the names and the specials kept in separate arrays
+//indexed by handle
+//
+//lookups never lock and may run on any number of threads alongside a single
+//writer; callers must serialize insert, erase, setRow, addSpecial, setSpecial
+//and reserve. new entries are published with a release store of their slot,
+//row changes are published through a per row sequence lock, and when an
+//array fills up the writer copies everything into a larger table and
+//publishes it with one pointer store. every lookup holds a Reader, which
+//announces the epoch it began in, and the writer frees a replaced table once
+//no reader that began before the replacement is still running
+//
+//an erased row keeps its handle and its slot, so a name erased and inserted
+//again gets its old handle back, and a delta feed churning the same names
+//doesn't grow the catalog
+//
+//specials are held as copies of their terms in slots, which getRow reads
+//under the row's sequence lock. a slot no row refers to may be given to
+//another special with setSpecial, so the caller deciding which slots are
+//free can bound them without readers ever seeing one special's row priced
+//by another's terms
+//
+//a table can also point straight into a mapped catalog file, in which case
+//the first change copies it into owned memory
+class Catalog {
+private:
+	struct Row { //stored form of a PriceRow, 16 bytes so rows never straddle a cache line
+		std::atomic<uint32_t> seq; //odd while the writer is changing the row
+		std::atomic<int32_t> price;
+		std::atomic<int32_t> markdown;
+		std::atomic<uint32_t> flags; //special index + 1 in the low 30 bits, then erased, then byWeight in the top bit
+	};
+	struct Terms { //stored form of a special's SpecialTerms, rewritten only while no row refers to it
+		std::atomic<int32_t> kind;
+		std::atomic<int32_t> purchaseQuantity;
+		std::atomic<int32_t> discountQuantity;
+		std::atomic<int32_t> discountPercentage;
+		std::atomic<int32_t> discountPrice;
+		std::atomic<int32_t> limit;
+		std::atomic<uint32_t> generation; //new each time the slot is given to a special, unique in the catalog
+	};
+	struct Table {
+		size_t slotCount; //power of two, linear probing
+		std::atomic<uint64_t>* slots; //hash in the high 32 bits, row + 1 in the low 32 bits, 0 when empty
+			//and all ones in the low 32 bits once the row is erased
+		int rowCapacity;
+		Row* rows;
+		uint32_t* nameOffsets; //name of row h is names[nameOffsets[h], nameOffsets[h + 1])
+		size_t nameCapacity;
+		char* names;
+		int specialCapacity;
+		Terms* specials;
+		bool owned; //false when slots, rows and names live in a mapped file
+		Table();
+		~Table();
+	};
+	struct Retired {
+		uint64_t epoch; //last epoch a reader could have begun in and still found it current
+		unique_ptr<Table> table;
+	};
+	std::atomic<Table*> table;
+	std::atomic<int> rowCount;
+	std::atomic<int> specialCount;
+	uint32_t generations = 0; //given to slots so far, touched only by the writer
+	unique_ptr<Table> current; //owns table
+	vector<Retired> retired; //replaced tables readers may still be using, touched only by the writer
+
+	size_t probe(const Table*, const char*, size_t, uint32_t, int*) const;
+	Table* grow(const Table*, int, int, int, size_t, int);
+	Table* publish(unique_ptr<Table>);
+	void reclaim();
+	static void storeRow(Row&, const PriceRow&);
+	static void storeTerms(Terms&, const SpecialTerms&, uint32_t);
+	static SpecialTerms loadTerms(const Terms&);
+public:
+	//pins the tables the calling thread reads until it goes out of scope;
+	//nests, and only the outermost one announces an epoch
+	class Reader {
+	public:
+		Reader();
+		~Reader();
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+	};
+
+	Catalog();
+	Catalog(const Catalog&);
+	Catalog& operator=(const Catalog&) = delete;
+	static uint32_t hash(const char*, size_t);
+	int find(const char*, size_t) const;
+	inline int find(const string& n) const { return find(n.data(), n.size()); }
+	int insert(const char*, size_t, const PriceRow&, PriceRow* = nullptr);
+	inline int insert(const string& n, const PriceRow& r, PriceRow* replaced = nullptr) { return insert(n.data(), n.size(), r, replaced); }
+	bool erase(int);
+	void reserve(int);
+	inline int size() const { return rowCount.load(std::memory_order_acquire); }
+	PriceRow getRow(int, uint32_t* = nullptr, SpecialTerms* = nullptr, uint32_t* = nullptr) const;
+	void setRow(int, const PriceRow&);
+	int addSpecial(const SpecialTerms&);
+	void setSpecial(int, const SpecialTerms&);
+	SpecialTerms getSpecial(int, uint32_t* = nullptr) const;
+	inline int specialsSize() const { return specialCount.load(std::memory_order_acquire); }
+	string getName(int) const;
+	const char* getName(int, size_t*) const;
+	inline bool isMapped() const { Reader pin; return !table.load(std::memory_order_acquire)->owned; }
+	inline int retiredTables() const { return retired.size(); } //writer only
+	bool write(FILE*) const;
+	size_t map(const char*, size_t, const vector<SpecialTerms>&);
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "checkout.h"
+
+CheckoutEngine::CheckoutEngine(shared_ptr<Inventory> inv, int laneCount, int workerCount, int lines)
+	: queued(0), outstanding(0), applied(0), steals(0) {
+	//each lane's register is sized for baskets of up to lines distinct products
+	for (int i = 0; i < laneCount; ++i) {
+		lanes.emplace_back(new Lane());
+		lanes.back()->reg.assignInventory(inv);
+		lanes.back()->reg.reserve(lines);
+	}
+	for (int i = 0; i < workerCount; ++i) {
+		workers.emplace_back(new Worker());
+	}
+	for (int i = 0; i < workerCount; ++i) {
+		workers[i]->thread = std::thread(&CheckoutEngine::work, this, i);
+	}
+}
+
+CheckoutEngine::~CheckoutEngine() {
+	//applies what was submitted, then stops the workers
+	drain();
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (unique_ptr<Worker>& w : workers) {
+		w->thread.join();
+	}
+}
+
+bool CheckoutEngine::submit(int l, const CheckoutEvent& e) {
+	return submit(l, &e, 1);
+}
+
+bool CheckoutEngine::submit(int l, const CheckoutEvent* e, size_t n) {
+	//queues n events for lane l, after any submitted before them; false if
+	//there is no such lane
+	if (l < 0 || l >= (int) lanes.size() || workers.empty()) {
+		return false;
+	}
+	if (n == 0) {
+		return true;
+	}
+	Lane& lane = *lanes[l];
+	outstanding += n;
+	bool ready;
+	{
+		std::lock_guard<std::mutex> guard(lane.lock);
+		lane.pending.insert(lane.pending.end(), e, e + n);
+		ready = !lane.scheduled;
+		lane.scheduled = true;
+	}
+	if (ready) {
+		schedule(l);
+	}
+	return true;
+}
+
+void CheckoutEngine::drain() {
+	//waits until every event submitted so far has been applied
+	std::unique_lock<std::mutex> guard(sleepLock);
+	idle.wait(guard, [this] { return outstanding == 0; });
+}
+
+void CheckoutEngine::schedule(int l) {
+	//queues a lane on its home worker and wakes a sleeping worker for it
+	Worker& w = *workers[l % workers.size()];
+	{
+		std::lock_guard<std::mutex> guard(w.lock);
+		w.lanes.push_back(l);
+	}
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		++queued;
+	}
+	wake.notify_one();
+}
+
+int CheckoutEngine::take(int self) {
+	//the next lane for worker self: from its own queue, or else stolen from
+	//the back of another's; -1 if every queue is empty
+	{
+		Worker& w = *workers[self];
+		std::lock_guard<std::mutex> guard(w.lock);
+		if (!w.lanes.empty()) {
+			int l = w.lanes.front();
+			w.lanes.pop_front();
+			--queued;
+			return l;
+		}
+	}
+	for (size_t i = 1; i < workers.size(); ++i) {
+		Worker& w = *workers[(self + i) % workers.size()];
+		std::lock_guard<std::mutex> guard(w.lock);
+		if (!w.lanes.empty()) {
+			int l = w.lanes.back();
+			w.lanes.pop_back();
+			--queued;
+			++steals;
+			return l;
+		}
+	}
+	return -1;
+}
+
+void CheckoutEngine::run(int self, int l) {
+	//applies the events waiting for a lane. if more arrive meanwhile the
+	//lane goes to the back of this worker's queue, so one busy lane can't
+	//starve the others
+	Lane& lane = *lanes[l];
+	{
+		std::lock_guard<std::mutex> guard(lane.lock);
+		lane.working.swap(lane.pending);
+	}
+	for (const CheckoutEvent& e : lane.working) {
+		bool ok = true;
+		if (e.op == CHECKOUT_SCAN) {
+			ok = lane.reg.scanItem(e.handle, e.weight);
+		}
+		else if (e.op == CHECKOUT_REMOVE) {
+			ok = lane.reg.removeItem(e.handle, e.weight);
+		}
+		else {
+			lane.reg.reset();
+		}
+		lane.rejected += !ok;
+	}
+	long long n = lane.working.size();
+	lane.working.clear();
+	bool again;
+	{
+		std::lock_guard<std::mutex> guard(lane.lock);
+		again = !lane.pending.empty();
+		lane.scheduled = again;
+	}
+	if (again) {
+		Worker& w = *workers[self];
+		{
+			std::lock_guard<std::mutex> guard(w.lock);
+			w.lanes.push_back(l);
+		}
+		++queued;
+	}
+	applied += n;
+	if ((outstanding -= n) == 0) {
+		std::lock_guard<std::mutex> guard(sleepLock);
+		idle.notify_all();
+	}
+}
+
+void CheckoutEngine::work(int self) {
+	while (true) {
+		int l = take(self);
+		if (l != -1) {
+			run(self, l);
+			continue;
+		}
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [this] { return queued > 0 || stopping; });
+		if (stopping && queued == 0) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef _CHECKOUT_H_
+#define _CHECKOUT_H_
+
+#include "inventory.h"
+#include "register.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::shared_ptr;
+using std::unique_ptr;
+using std::vector;
+
+const int CHECKOUT_SCAN = 0;
+const int CHECKOUT_REMOVE = 1;
+const int CHECKOUT_RESET = 2;
+
+//one thing done to a lane's basket, applied as scanItem, removeItem or reset
+struct CheckoutEvent {
+	int op;
+	int handle;
+	int weight;
+	CheckoutEvent(int o = CHECKOUT_SCAN, int h = -1, int w = 0) : op(o), handle(h), weight(w) { }
+};
+
+//runs many lanes, each a Register and its basket, on a fixed set of worker
+//threads. a lane's events are applied in the order submitted and by one
+//worker at a time, while different lanes run in parallel. a lane with
+//events waiting is queued on its home worker, and a worker with nothing
+//queued steals lanes from the others
+class CheckoutEngine {
+private:
+	struct Lane {
+		Register reg;
+		std::mutex lock;
+		vector<CheckoutEvent> pending; //submitted, not yet taken by a worker
+		vector<CheckoutEvent> working; //being applied by the worker running the lane
+		bool scheduled = false; //queued on a worker or being run by one
+		long long rejected = 0; //events the register refused, only touched by the worker running the lane
+	};
+	struct Worker {
+		std::mutex lock;
+		std::deque<int> lanes; //lanes ready to run: the owner takes from the front, thieves from the back
+		std::thread thread;
+	};
+
+	vector<unique_ptr<Lane>> lanes;
+	vector<unique_ptr<Worker>> workers;
+	std::mutex sleepLock;
+	std::condition_variable wake; //signalled when a lane is queued or the engine stops
+	std::condition_variable idle; //signalled when every submitted event has been applied
+	std::atomic<long> queued; //lanes sitting in worker queues
+	std::atomic<long long> outstanding; //events submitted and not yet applied
+	std::atomic<long long> applied;
+	std::atomic<long long> steals;
+	bool stopping = false;
+
+	void schedule(int);
+	int take(int);
+	void run(int, int);
+	void work(int);
+public:
+	CheckoutEngine(shared_ptr<Inventory>, int, int, int = 256);
+	CheckoutEngine(const CheckoutEngine&) = delete;
+	CheckoutEngine& operator=(const CheckoutEngine&) = delete;
+	~CheckoutEngine();
+	bool submit(int, const CheckoutEvent&);
+	bool submit(int, const CheckoutEvent*, size_t);
+	void drain();
+	inline int getLanes() const { return lanes.size(); }
+	inline int getWorkers() const { return workers.size(); }
+	inline const Register& getRegister(int l) const { return lanes[l]->reg; } //only once drained
+	inline long long getRejected(int l) const { return lanes[l]->rejected; } //only once drained
+	inline long long getApplied() const { return applied; }
+	inline long long getSteals() const { return steals; }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "delta.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* parseDelta(const char* p, const char* end, PriceDelta& d, SpecialTerms& s, int& group) {
+	//parses one line without its newline, returns nullptr on success or the
+	//reason it was rejected
+	if (end - p < 3 || p[1] != ',') {
+		return "expected change type and product name";
+	}
+	char type = *p;
+	p += 2;
+	const char* comma = (const char*) memchr(p, ',', end - p);
+	const char* nameEnd = comma ? comma : end;
+	if (nameEnd == p) {
+		return "missing product name";
+	}
+	d.name.assign(p, nameEnd - p);
+	p = nameEnd;
+	d.special = nullptr;
+	s = SpecialTerms();
+	group = 0;
+	switch (type) {
+		case 'U':
+			d.op = PriceDelta::UPSERT;
+			if (!parseField(p, end, d.price) || !parseField(p, end, d.byWeight) || !parseField(p, end, d.markdown)) {
+				return "expected integer price, byWeight and markdown";
+			}
+			if (d.byWeight != 0 && d.byWeight != 1) {
+				return "byWeight must be 0 or 1";
+			}
+			break;
+		case 'P':
+			d.op = PriceDelta::PRICE;
+			if (!parseField(p, end, d.price)) {
+				return "expected integer price";
+			}
+			break;
+		case 'M':
+			d.op = PriceDelta::MARKDOWN;
+			if (!parseField(p, end, d.markdown)) {
+				return "expected integer markdown";
+			}
+			if (d.markdown < 0) {
+				return "negative markdown";
+			}
+			break;
+		case 'S':
+			d.op = PriceDelta::SPECIAL;
+			return parseSpecial(p, end, s, group);
+		case 'X':
+			d.op = PriceDelta::SPECIAL;
+			break;
+		case 'D':
+			d.op = PriceDelta::ERASE;
+			break;
+		default:
+			return "unknown change type";
+	}
+	if (p != end) {
+		return "unexpected trailing fields";
+	}
+	return nullptr;
+}
+
+}
+
+DeltaApplier::DeltaApplier(size_t b) {
+	batchSize = b > 0 ? b : 1;
+}
+
+bool DeltaApplier::load(const string& path, Inventory& inv) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return true;
+	}
+	void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+	parse((const char*) base, st.st_size, inv);
+	munmap(base, st.st_size);
+	return true;
+}
+
+void DeltaApplier::parse(const char* data, size_t len, Inventory& inv) {
+	const char* end = data + len;
+	const char* p = data;
+	long line = 0;
+	SpecialTerms s;
+	int group;
+	while (p < end) {
+		const char* nl = (const char*) memchr(p, '\n', end - p);
+		const char* e = nl ? nl : end;
+		++line;
+		if (e > p && e[-1] == '\r') {
+			--e;
+		}
+		if (e > p) {
+			batch.emplace_back();
+			const char* reason = parseDelta(p, e, batch.back(), s, group);
+			if (!reason) {
+				batch.back().special = specials.make(s, group);
+				if (s.kind != SPECIAL_NONE && !batch.back().special) {
+					reason = "MIX group listed with other terms";
+				}
+			}
+			if (reason) {
+				batch.pop_back();
+				unparsed.push_back(ImportReject{line, reason});
+			}
+			else {
+				batchLines.push_back(line);
+				if (batch.size() >= batchSize) {
+					flush(inv);
+				}
+			}
+		}
+		p = nl ? nl + 1 : end;
+	}
+	flush(inv);
+}
+
+void DeltaApplier::flush(Inventory& inv) {
+	//applies the batch, then reports its rejects merged in line order with
+	//the lines rejected while parsing it
+	if (!batch.empty()) {
+		applied += inv.apply(batch, &reasons);
+	}
+	size_t k = 0;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		if (reasons[i]) {
+			while (k < unparsed.size() && unparsed[k].line < batchLines[i]) {
+				rejects.push_back(unparsed[k++]);
+			}
+			rejects.push_back(ImportReject{batchLines[i], reasons[i]});
+		}
+	}
+	for (; k < unparsed.size(); ++k) {
+		rejects.push_back(unparsed[k]);
+	}
+	batch.clear();
+	batchLines.clear();
+	unparsed.clear();
+}
@@ -0,0 +1,50 @@
+#ifndef _DELTA_H_
+#define _DELTA_H_
+
+#include "fields.h"
+#include "importer.h"
+#include "inventory.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+//applies a feed of incremental price changes to a live inventory, one change
+//per line:
+//	U,name,price,byWeight,markdown		insert or update a product, keeping its special
+//	P,name,price				change the price
+//	M,name,markdown				set the markdown, 0 clears it
+//	S,name,BOGO,purchaseQuantity,discountQuantity,discountPercentage[,limit]
+//	S,name,BULK,purchaseQuantity,discountPrice[,limit]	attach a special
+//	S,name,MIX,group,purchaseQuantity,discountPrice[,limit]
+//	X,name					detach the special
+//	D,name					delete the product
+//products given the same MIX group share one pool; group ids are the
+//feed's own, and a group once given terms keeps them for the whole feed.
+//changes are grouped into batches applied under one writer lock acquisition
+//each, in feed order, while registers keep scanning. rejected lines are
+//reported with the same rules as the price file importer
+class DeltaApplier {
+private:
+	size_t batchSize;
+	long applied = 0;
+	vector<ImportReject> rejects;
+	vector<ImportReject> unparsed; //rejected while parsing the current batch
+	SpecialFactory specials;
+	vector<PriceDelta> batch;
+	vector<long> batchLines;
+	vector<const char*> reasons;
+
+	void flush(Inventory&);
+public:
+	DeltaApplier(size_t = 4096);
+	bool load(const string&, Inventory&);
+	void parse(const char*, size_t, Inventory&);
+	inline long getApplied() const { return applied; }
+	inline const vector<ImportReject>& getRejects() const { return rejects; }
+};
+
+#endif
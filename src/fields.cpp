@@ -0,0 +1,115 @@
+#include "fields.h"
+
+#include <cstring>
+
+bool parseInt(const char*& p, const char* end, int& out) {
+	//reads an optionally signed decimal integer up to the next comma or the end
+	bool negative = false;
+	if (p < end && *p == '-') {
+		negative = true;
+		++p;
+	}
+	if (p == end || *p < '0' || *p > '9') {
+		return false;
+	}
+	long long v = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		v = v * 10 + (*p - '0');
+		if (v > 2147483647LL) {
+			return false;
+		}
+		++p;
+	}
+	out = negative ? (int) -v : (int) v;
+	return true;
+}
+
+bool parseField(const char*& p, const char* end, int& out) {
+	//reads a comma then an integer
+	if (p == end || *p != ',') {
+		return false;
+	}
+	++p;
+	return parseInt(p, end, out);
+}
+
+const char* parseSpecial(const char*& p, const char* end, SpecialTerms& s, int& group) {
+	//reads the rest of a line holding ,BOGO,purchaseQuantity,discountQuantity,discountPercentage[,limit],
+	//,BULK,purchaseQuantity,discountPrice[,limit] or ,MIX,group,purchaseQuantity,discountPrice[,limit],
+	//with the same rules as SpecialBogo::setDiscountPercentage; returns
+	//nullptr on success or the reason it was rejected. group is 0 unless MIX
+	s = SpecialTerms();
+	group = 0;
+	if (end - p >= 5 && memcmp(p, ",BOGO", 5) == 0) {
+		p += 5;
+		s.kind = SPECIAL_BOGO;
+		if (!parseField(p, end, s.purchaseQuantity) || !parseField(p, end, s.discountQuantity)
+			|| !parseField(p, end, s.discountPercentage)) {
+			return "expected BOGO purchaseQuantity, discountQuantity and discountPercentage";
+		}
+		if (s.discountPercentage < 0 || s.discountPercentage > 100) {
+			return "discountPercentage must be between 0 and 100";
+		}
+		if (s.discountQuantity < 0) {
+			return "negative discountQuantity";
+		}
+	}
+	else if (end - p >= 5 && memcmp(p, ",BULK", 5) == 0) {
+		p += 5;
+		s.kind = SPECIAL_BULK;
+		if (!parseField(p, end, s.purchaseQuantity) || !parseField(p, end, s.discountPrice)) {
+			return "expected BULK purchaseQuantity and discountPrice";
+		}
+	}
+	else if (end - p >= 4 && memcmp(p, ",MIX", 4) == 0) {
+		p += 4;
+		s.kind = SPECIAL_MIX;
+		if (!parseField(p, end, group) || !parseField(p, end, s.purchaseQuantity) || !parseField(p, end, s.discountPrice)) {
+			return "expected MIX group, purchaseQuantity and discountPrice";
+		}
+		if (group < 0) {
+			return "negative MIX group";
+		}
+	}
+	else {
+		return "unknown special type";
+	}
+	if (s.purchaseQuantity <= 0) {
+		return "purchaseQuantity must be positive";
+	}
+	if (p != end && (!parseField(p, end, s.limit) || s.limit < 0)) {
+		return "limit must be a non-negative integer";
+	}
+	if (p != end) {
+		return "unexpected trailing fields";
+	}
+	return nullptr;
+}
+
+shared_ptr<Special> SpecialFactory::make(const SpecialTerms& s, int group) {
+	if (s.kind == SPECIAL_NONE) {
+		return nullptr;
+	}
+	if (s.kind == SPECIAL_MIX) {
+		//a group is one promotion, whatever other groups happen to charge
+		shared_ptr<Special>& mix = groups[group];
+		if (!mix) {
+			mix = std::make_shared<SpecialMix>(s.purchaseQuantity, s.discountPrice, s.limit);
+		}
+		else if (mix->getPurchaseQuantity() != s.purchaseQuantity || mix->getDiscountPrice() != s.discountPrice
+			|| mix->getLimit() != s.limit) {
+			return nullptr;
+		}
+		return mix;
+	}
+	shared_ptr<Special>& special = made[std::make_tuple(s.kind, s.purchaseQuantity, s.discountQuantity, s.discountPercentage, s.discountPrice, s.limit)];
+	if (!special) {
+		if (s.kind == SPECIAL_BOGO) {
+			special = std::make_shared<SpecialBogo>(s.purchaseQuantity, s.discountQuantity, s.discountPercentage, s.limit);
+		}
+		else {
+			special = std::make_shared<SpecialBulk>(s.purchaseQuantity, s.discountPrice, s.limit);
+		}
+	}
+	return special;
+}
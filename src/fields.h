@@ -0,0 +1,32 @@
+#ifndef _FIELDS_H_
+#define _FIELDS_H_
+
+#include "special.h"
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+using std::map;
+using std::shared_ptr;
+
+//helpers shared by the price file importer and the price delta feed for
+//reading comma separated integer fields and special definitions
+
+bool parseInt(const char*&, const char*, int&);
+bool parseField(const char*&, const char*, int&);
+const char* parseSpecial(const char*&, const char*, SpecialTerms&, int&);
+
+//creates specials, handing out the same object for identical BOGO and BULK
+//definitions and one per MIX group, so the products of a price file listing
+//the same group share one pool while two groups with equal terms stay apart.
+//make returns nullptr for a group already made with other terms
+class SpecialFactory {
+private:
+	map<std::tuple<int, int, int, int, int, int>, shared_ptr<Special>> made;
+	map<int, shared_ptr<Special>> groups;
+public:
+	shared_ptr<Special> make(const SpecialTerms&, int group = 0);
+};
+
+#endif
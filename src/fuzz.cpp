@@ -0,0 +1,565 @@
+#include "fuzz.h"
+#include "inventory.h"
+#include "pricing.h"
+#include "product.h"
+#include "register.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+long long roundCents(long long x, int rounding) {
+	//x hundredths of a cent to whole cents, written out longhand so the
+	//reference shares no arithmetic with the pricing kernels
+	long long whole = x / 100;
+	long long rest = x % 100;
+	if (rest > 50 || (rest == 50 && (rounding != ROUND_HALF_EVEN || whole % 2 == 1))) {
+		++whole;
+	}
+	return whole;
+}
+
+int baselineCalcPrice(int p, int w, int q, const Special* s) {
+	//Register::calcPrice as it was before pricing moved to integers, kept
+	//verbatim apart from taking the special by pointer: what adding w
+	//hundredths of a pound (or one unit if w is 0) to q adds to a line
+	int total = 0;
+	int overLimit = 0; //used for weight priced specials
+	if (w && s && s->getLimit() != 0) {
+		overLimit = w + q - s->getLimit();
+		overLimit = overLimit > 0 ? overLimit : 0;
+		w -= overLimit;
+	}
+	if (w && s) { //special for weighted item
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		int discountPrice = (int) (p * ((100 - discountPercentage) / 100.0) + .5); //cents per lb
+		int price = 0;
+		int fullCycles = w / totalSpecialQuantity; //amount of sets of max full price and discount price quantities
+		w = w % totalSpecialQuantity; //amount left over after taking out full sets
+		price += ((int) ((fullCycles * discountPrice * discountQuantity / 100.0) + (fullCycles * p * purchaseQuantity / 100.0) + .5)); //adding the total of max full and discount price quantities
+		int margin = q % totalSpecialQuantity; //amount of product towards next cycle previously scanned
+		if (margin / purchaseQuantity) { //already in discount price
+			int discPriceQuantity = totalSpecialQuantity - margin; //calculate how much quantity to add until out of discount price range and add
+			discPriceQuantity = discPriceQuantity < w ? discPriceQuantity : w; //check if enough weight to cover dpq range
+			price += ((int) (discountPrice * (discPriceQuantity / 100.0) + .5));
+			w -= discPriceQuantity;
+			price += ((int) (p * (w / 100.0) + .5)); //dump rest into full price
+		}
+		else { //have some way to go in full price
+			int fullPriceQuantity = purchaseQuantity - margin; //calculate how much quantity to add in full price range and add
+			fullPriceQuantity = fullPriceQuantity < w ? fullPriceQuantity : w; //check if enough weight to cover fPQ
+			w -= fullPriceQuantity;
+			price += ((int) (p * (fullPriceQuantity / 100.0) + .5));
+			price += ((int) (discountPrice * (w / 100.0) + .5)); //dump rest into disc price
+		}
+		w = overLimit;
+		total = price;
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BOGO") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		if (q % totalSpecialQuantity >= purchaseQuantity) {
+			double discountPrice = 100 - discountPercentage;
+			discountPrice /= 100.0;
+			discountPrice *= p;
+			discountPrice += .5; //for rounding
+			p = (int) discountPrice;
+		}
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BULK") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountPrice = s->getDiscountPrice();
+		if (q % purchaseQuantity == purchaseQuantity - 1) {
+			p = discountPrice - (p * (purchaseQuantity - 1));
+		}
+	}
+	if (w != 0) { //multiply price per pound by quantity in
+		//hundredths of a pound
+		double lbScanned = w / 100.0;
+		double cost = lbScanned * p;
+		cost += .5; //for rounding
+		total += (int) cost;
+	}
+	if (total) { //for weight priced items
+		p = total;
+	}
+	return p;
+}
+
+int unitLine(const FuzzProduct& p, int q, int rounding) {
+	//prices q units by adding them to the line one at a time through the
+	//original calcPrice. it rounded a discounted price in a double, ignoring
+	//the rounding mode, so a discount landing on an exact half cent could
+	//come out a cent low; only those units are rounded here instead, found
+	//by asking calcPrice which units the same special at 100% off gives away
+	int price = p.price - p.markdown;
+	const SpecialTerms& t = p.terms;
+	SpecialBogo bogo(t.purchaseQuantity, t.discountQuantity, t.discountPercentage, t.limit);
+	SpecialBogo free(t.purchaseQuantity, t.discountQuantity, 100, t.limit);
+	SpecialBulk bulk(t.purchaseQuantity, t.discountPrice, t.limit);
+	const Special* s = t.purchaseQuantity <= 0 ? nullptr
+		: t.kind == SPECIAL_BOGO ? (const Special*) &bogo : t.kind == SPECIAL_BULK ? &bulk : nullptr;
+	bool tie = s == &bogo && (long long) price * (100 - t.discountPercentage) % 100 == 50;
+	long long cost = 0;
+	for (int k = 0; k < q; ++k) {
+		if (tie && baselineCalcPrice(price, 0, k, &free) == 0) {
+			cost += roundCents((long long) price * (100 - t.discountPercentage), rounding);
+		}
+		else {
+			cost += baselineCalcPrice(price, 0, k, s);
+		}
+	}
+	return (int) cost;
+}
+
+int weighedLine(const FuzzProduct& p, int q, int rounding) {
+	//prices q hundredths of a pound one at a time, rounding once at the end.
+	//the original calcPrice rounded each part of a weighed line on its own,
+	//so it can't serve here
+	int price = p.price - p.markdown;
+	const SpecialTerms t = p.mix == -1 ? p.terms : SpecialTerms(); //a weighed product's mix special is ignored
+	bool special = t.kind != SPECIAL_NONE && t.purchaseQuantity > 0;
+	int covered = !special ? 0 : (t.limit == 0 || t.limit > q ? q : t.limit);
+	int cycle = t.purchaseQuantity + t.discountQuantity;
+	long long off = roundCents((long long) price * (100 - t.discountPercentage), rounding);
+	long long cost = 0;
+	for (int k = 0; k < q; ++k) {
+		//weighed products take any special as buy some, get some off
+		cost += k < covered && k % cycle >= t.purchaseQuantity ? off : price;
+	}
+	return (int) roundCents(cost, rounding);
+}
+
+int pooled(const FuzzCase& c, int product) {
+	//the mix a product's units are pooled in, or -1
+	const FuzzProduct& p = c.products[product];
+	return p.mix != -1 && !p.byWeight && c.mixes[p.mix].purchaseQuantity > 0 ? p.mix : -1;
+}
+
+int referencePool(const SpecialTerms& t, const vector<int>& units, const vector<int>& prices) {
+	//the first complete runs of purchaseQuantity positions, as many as the
+	//limit allows, sell for discountPrice and the rest pay their own prices
+	int runs = units.size() / t.purchaseQuantity;
+	if (t.limit != 0 && runs > t.limit / t.purchaseQuantity) {
+		runs = t.limit / t.purchaseQuantity;
+	}
+	long long value = (long long) runs * t.discountPrice;
+	for (size_t i = runs * t.purchaseQuantity; i < units.size(); ++i) {
+		value += prices[units[i]];
+	}
+	return (int) value;
+}
+
+shared_ptr<Inventory> fuzzInventory(const FuzzCase& c) {
+	//products go in in order, so each one's handle is its index in the case
+	shared_ptr<Inventory> inv = std::make_shared<Inventory>();
+	vector<shared_ptr<Special>> mixes;
+	for (const SpecialTerms& t : c.mixes) {
+		mixes.push_back(std::make_shared<SpecialMix>(t.purchaseQuantity, t.discountPrice, t.limit));
+	}
+	for (size_t i = 0; i < c.products.size(); ++i) {
+		const FuzzProduct& f = c.products[i];
+		shared_ptr<Product> p = std::make_shared<Product>("p" + std::to_string(i), f.price, f.byWeight);
+		p->setMarkdown(f.markdown);
+		const SpecialTerms& t = f.terms;
+		if (f.mix != -1) {
+			p->assignSpecial(mixes[f.mix]);
+		}
+		else if (t.kind == SPECIAL_BOGO) {
+			p->assignSpecial(std::make_shared<SpecialBogo>(t.purchaseQuantity, t.discountQuantity, t.discountPercentage, t.limit));
+		}
+		else if (t.kind == SPECIAL_BULK) {
+			p->assignSpecial(std::make_shared<SpecialBulk>(t.purchaseQuantity, t.discountPrice, t.limit));
+		}
+		inv->insert(p);
+	}
+	return inv;
+}
+
+void apply(Register& reg, const FuzzOp& o) {
+	switch (o.op) {
+	case FUZZ_SCAN:
+		reg.scanItem(o.product, o.amount);
+		break;
+	case FUZZ_REMOVE:
+		reg.removeItem(o.product, o.amount);
+		break;
+	case FUZZ_SCAN_N:
+		reg.scanItems(o.product, o.amount);
+		break;
+	default:
+		reg.removeItems(o.product, o.amount);
+	}
+}
+
+void playScans(const FuzzCase& c, vector<int>& totals) {
+	//one register call per op
+	Register reg;
+	reg.assignInventory(fuzzInventory(c));
+	reg.setRounding(c.rounding);
+	for (const FuzzOp& o : c.ops) {
+		apply(reg, o);
+		totals.push_back(reg.getTotal());
+	}
+}
+
+void playCached(const FuzzCase& c, vector<int>& totals) {
+	//single unit scans and removals through the price cache
+	Register reg;
+	reg.assignInventory(fuzzInventory(c));
+	reg.setRounding(c.rounding);
+	reg.setPriceCache(64);
+	for (const FuzzOp& o : c.ops) {
+		apply(reg, o);
+		totals.push_back(reg.getTotal());
+	}
+}
+
+void playBatches(const FuzzCase& c, vector<int>& totals) {
+	//scans through scanBatch against a pinned snapshot, a scanItems call
+	//becoming a batch of that many single units
+	Register reg;
+	reg.assignInventory(fuzzInventory(c));
+	reg.setRounding(c.rounding);
+	reg.setSnapshotMode(true);
+	vector<ScanEntry> entries;
+	for (const FuzzOp& o : c.ops) {
+		entries.clear();
+		if (o.op == FUZZ_SCAN || o.op == FUZZ_REMOVE) {
+			entries.push_back(ScanEntry(o.product, o.amount));
+		}
+		else if (o.op == FUZZ_SCAN_N) {
+			entries.assign(o.amount > 0 ? o.amount : 0, ScanEntry(o.product, 0));
+		}
+		if (o.op == FUZZ_REMOVE_N) {
+			//a batch removes what it can, removeItems all or nothing
+			reg.removeItems(o.product, o.amount);
+		}
+		else if (o.op == FUZZ_REMOVE) {
+			reg.removeBatch(entries.data(), entries.size());
+		}
+		else {
+			reg.scanBatch(entries.data(), entries.size());
+		}
+		totals.push_back(reg.getTotal());
+	}
+}
+
+void playResumed(const FuzzCase& c, vector<int>& totals) {
+	//the basket moves to the other of two registers after every op
+	shared_ptr<Inventory> inv = fuzzInventory(c);
+	Register regs[2];
+	for (Register& reg : regs) {
+		reg.assignInventory(inv);
+		reg.setRounding(c.rounding);
+	}
+	vector<char> blob;
+	int cur = 0;
+	for (const FuzzOp& o : c.ops) {
+		apply(regs[cur], o);
+		blob.resize(regs[cur].suspendedSize());
+		bool moved = regs[cur].suspend(blob.data(), blob.size()) == blob.size() && regs[1 - cur].resume(blob.data(), blob.size());
+		cur = moved ? 1 - cur : cur;
+		totals.push_back(moved ? regs[cur].getTotal() : -1);
+	}
+}
+
+void describeOp(string& out, const FuzzOp& o) {
+	static const char* names[] = {"scanItem", "removeItem", "scanItems", "removeItems"};
+	char line[96];
+	snprintf(line, sizeof(line), "%s(p%d, %d)\n", names[o.op], o.product, o.amount);
+	out += line;
+}
+
+}
+
+PricingFuzzer::PricingFuzzer(unsigned seed) : rng(seed) {
+}
+
+void PricingFuzzer::addRegisterEngines() {
+	addEngine("scan", playScans);
+	addEngine("price cache", playCached);
+	addEngine("batch snapshot", playBatches);
+	addEngine("suspend resume", playResumed);
+}
+
+FuzzCase PricingFuzzer::generate() {
+	//small catalogs and short baskets, so that the same few lines wrap
+	//round their specials' cycles and limits many times. prices, percentages
+	//and quantities lean towards the edges where rounding and limits bite
+	FuzzCase c;
+	c.rounding = rng() % 2 ? ROUND_HALF_EVEN : ROUND_HALF_UP;
+	int mixes = rng() % 3;
+	for (int i = 0; i < mixes; ++i) {
+		SpecialTerms t;
+		t.kind = SPECIAL_MIX;
+		t.purchaseQuantity = 1 + rng() % 4;
+		t.discountPrice = rng() % (t.purchaseQuantity * 600 + 1);
+		t.limit = rng() % 3 != 0 ? 0 : 1 + rng() % 10;
+		c.mixes.push_back(t);
+	}
+	int n = 1 + rng() % 6;
+	for (int i = 0; i < n; ++i) {
+		FuzzProduct p;
+		p.price = rng() % 4 == 0 ? 1 + rng() % 10 : 1 + rng() % 999;
+		p.markdown = rng() % 4 == 0 ? rng() % p.price : 0;
+		p.byWeight = rng() % 4 == 0;
+		int kind = rng() % 5;
+		int limit = rng() % 3 != 0 ? 0 : (p.byWeight ? 1 + rng() % 600 : 1 + rng() % 10);
+		if (kind == 2 || kind == 3) {
+			int percentages[] = {0, 50, 100, (int) (rng() % 101)};
+			p.terms.kind = SPECIAL_BOGO;
+			p.terms.purchaseQuantity = 1 + rng() % (p.byWeight ? 200 : 4);
+			p.terms.discountQuantity = rng() % (p.byWeight ? 200 : 4);
+			p.terms.discountPercentage = percentages[rng() % 4];
+			p.terms.limit = limit;
+		}
+		else if (kind == 4) {
+			p.terms.kind = SPECIAL_BULK;
+			p.terms.purchaseQuantity = 1 + rng() % 5;
+			p.terms.discountPrice = rng() % ((p.price - p.markdown) * p.terms.purchaseQuantity * 3 / 2 + 1);
+			p.terms.limit = limit;
+		}
+		if (mixes && rng() % 2 == 0) {
+			p.terms = SpecialTerms();
+			p.mix = rng() % mixes;
+		}
+		c.products.push_back(p);
+	}
+	int ops = 1 + rng() % 40;
+	for (int i = 0; i < ops; ++i) {
+		FuzzOp o;
+		int r = rng() % 100;
+		o.op = r < 55 ? FUZZ_SCAN : r < 80 ? FUZZ_REMOVE : r < 92 ? FUZZ_SCAN_N : FUZZ_REMOVE_N;
+		o.product = rng() % 20 == 0 ? n : rng() % n; //now and then a product the inventory doesn't have
+		bool byWeight = o.product < n && c.products[o.product].byWeight;
+		if (o.op == FUZZ_SCAN || o.op == FUZZ_REMOVE) {
+			o.amount = !byWeight ? 0 : rng() % 20 == 0 ? 0 : 1 + rng() % 300;
+		}
+		else {
+			o.amount = rng() % 10 == 0 ? -(int) (rng() % 2) : 1 + rng() % 6;
+		}
+		c.ops.push_back(o);
+	}
+	return c;
+}
+
+void PricingFuzzer::reference(const FuzzCase& c, vector<int>& totals) {
+	//keeps each product's quantity under the register's rules for which
+	//calls are refused, and after every op prices the whole basket afresh:
+	//unit priced lines through the original calcPrice, weighed lines and
+	//mix pools through naive models.
+	//each mix keeps its units in a plain list by position, a removal taking
+	//the product's latest unit and moving the last unit into its place
+	vector<int> quantity(c.products.size(), 0);
+	vector<vector<int>> pools(c.mixes.size()); //unit ids by position
+	vector<vector<int>> pooledUnits(c.products.size()); //each product's unit ids in scan order
+	vector<int> prices; //by unit id
+	for (const FuzzOp& o : c.ops) {
+		bool known = o.product >= 0 && o.product < (int) c.products.size();
+		bool byWeight = known && c.products[o.product].byWeight;
+		bool single = o.op == FUZZ_SCAN || o.op == FUZZ_REMOVE;
+		int n = !single ? o.amount : byWeight ? o.amount : 1;
+		bool ok = known && n > 0 && (single || !byWeight);
+		if (ok && (o.op == FUZZ_REMOVE || o.op == FUZZ_REMOVE_N)) {
+			ok = n <= quantity[o.product];
+			n = -n;
+		}
+		if (ok) {
+			quantity[o.product] += n;
+		}
+		int mix = ok ? pooled(c, o.product) : -1;
+		for (int k = 0; mix != -1 && k < n; ++k) {
+			const FuzzProduct& p = c.products[o.product];
+			pools[mix].push_back(prices.size());
+			pooledUnits[o.product].push_back(prices.size());
+			prices.push_back(p.price - p.markdown);
+		}
+		for (int k = 0; mix != -1 && k < -n; ++k) {
+			vector<int>& units = pools[mix];
+			size_t i = std::find(units.begin(), units.end(), pooledUnits[o.product].back()) - units.begin();
+			pooledUnits[o.product].pop_back();
+			units[i] = units.back();
+			units.pop_back();
+		}
+		long long total = 0;
+		for (size_t i = 0; i < c.products.size(); ++i) {
+			const FuzzProduct& p = c.products[i];
+			if (pooled(c, i) == -1) {
+				total += p.byWeight ? weighedLine(p, quantity[i], c.rounding) : unitLine(p, quantity[i], c.rounding);
+			}
+		}
+		for (size_t i = 0; i < pools.size(); ++i) {
+			total += referencePool(c.mixes[i], pools[i], prices);
+		}
+		totals.push_back((int) total);
+	}
+}
+
+bool PricingFuzzer::fails(const FuzzCase& c, PricingEngine engine) const {
+	vector<int> expected, actual;
+	reference(c, expected);
+	engine(c, actual);
+	return expected != actual;
+}
+
+bool PricingFuzzer::check(const FuzzCase& c, FuzzMismatch& mismatch) const {
+	//true if every engine agrees with the reference after every op of c;
+	//otherwise describes the first engine that doesn't and a minimal case
+	for (const pair<string, PricingEngine>& e : engines) {
+		if (!fails(c, e.second)) {
+			continue;
+		}
+		mismatch.engine = e.first;
+		mismatch.failing = c;
+		mismatch.minimal = minimize(c, e.second);
+		vector<int> expected, actual;
+		reference(mismatch.minimal, expected);
+		e.second(mismatch.minimal, actual);
+		actual.resize(expected.size(), 0);
+		size_t i = 0;
+		while (i + 1 < expected.size() && expected[i] == actual[i]) {
+			++i;
+		}
+		mismatch.op = i;
+		mismatch.expected = expected.empty() ? 0 : expected[i];
+		mismatch.actual = actual.empty() ? 0 : actual[i];
+		return false;
+	}
+	return true;
+}
+
+FuzzCase PricingFuzzer::minimize(const FuzzCase& c, PricingEngine engine) const {
+	//shrinks a failing case while it still fails: drops runs of ops, halving
+	//the run length whenever no run can go (delta debugging), then strips
+	//markdowns, limits, specials and mixes, pares amounts down to 1, and
+	//drops products no op refers to
+	FuzzCase best = c;
+	size_t chunk = std::max<size_t>(best.ops.size() / 2, 1);
+	while (!best.ops.empty()) {
+		bool dropped = false;
+		for (size_t i = 0; i < best.ops.size(); ) {
+			FuzzCase trial = best;
+			trial.ops.erase(trial.ops.begin() + i, trial.ops.begin() + std::min(i + chunk, trial.ops.size()));
+			if (fails(trial, engine)) {
+				best = trial;
+				dropped = true;
+			}
+			else {
+				i += chunk;
+			}
+		}
+		if (!dropped) {
+			if (chunk == 1) {
+				break;
+			}
+			chunk /= 2;
+		}
+	}
+
+	for (size_t i = 0; i < best.products.size(); ++i) {
+		FuzzCase trial = best;
+		trial.products[i].markdown = 0;
+		if (fails(trial, engine)) {
+			best = trial;
+		}
+		trial = best;
+		trial.products[i].terms.limit = 0;
+		if (fails(trial, engine)) {
+			best = trial;
+		}
+		trial = best;
+		trial.products[i].terms = SpecialTerms();
+		if (fails(trial, engine)) {
+			best = trial;
+		}
+		trial = best;
+		trial.products[i].mix = -1;
+		if (fails(trial, engine)) {
+			best = trial;
+		}
+	}
+	for (size_t i = 0; i < best.mixes.size(); ++i) {
+		FuzzCase trial = best;
+		trial.mixes[i].limit = 0;
+		if (fails(trial, engine)) {
+			best = trial;
+		}
+	}
+	for (size_t i = 0; i < best.ops.size(); ++i) {
+		while (best.ops[i].amount > 1) {
+			FuzzCase trial = best;
+			trial.ops[i].amount /= 2;
+			if (!fails(trial, engine)) {
+				break;
+			}
+			best = trial;
+		}
+	}
+
+	//renumber the products left, unknown ones after them
+	vector<int> renumbered(best.products.size() + 1, -1);
+	FuzzCase trial = best;
+	trial.products.clear();
+	for (const FuzzOp& o : best.ops) {
+		if (o.product >= 0 && o.product < (int) best.products.size() && renumbered[o.product] == -1) {
+			renumbered[o.product] = trial.products.size();
+			trial.products.push_back(best.products[o.product]);
+		}
+	}
+	for (FuzzOp& o : trial.ops) {
+		o.product = o.product >= 0 && o.product < (int) best.products.size() ? renumbered[o.product] : trial.products.size();
+	}
+	return fails(trial, engine) ? trial : best;
+}
+
+bool PricingFuzzer::run(long iterations, FuzzMismatch& mismatch) {
+	//checks that many generated cases; false at the first mismatch
+	for (long i = 0; i < iterations; ++i) {
+		++cases;
+		if (!check(generate(), mismatch)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+string PricingFuzzer::describe(const FuzzCase& c) {
+	//a case as readable lines, for a bug report or a regression test
+	string out = c.rounding == ROUND_HALF_EVEN ? "rounding half even\n" : "rounding half up\n";
+	char line[160];
+	for (size_t i = 0; i < c.mixes.size(); ++i) {
+		const SpecialTerms& t = c.mixes[i];
+		snprintf(line, sizeof(line), "mix %zu: any %d for %d, limit %d\n", i, t.purchaseQuantity, t.discountPrice, t.limit);
+		out += line;
+	}
+	for (size_t i = 0; i < c.products.size(); ++i) {
+		const FuzzProduct& p = c.products[i];
+		const SpecialTerms& t = p.terms;
+		int n = snprintf(line, sizeof(line), "p%zu: %d%s markdown %d", i, p.price, p.byWeight ? "/lb" : "", p.markdown);
+		if (p.mix != -1) {
+			snprintf(line + n, sizeof(line) - n, ", mix %d\n", p.mix);
+		}
+		else if (t.kind == SPECIAL_BOGO) {
+			snprintf(line + n, sizeof(line) - n, ", buy %d get %d at %d%% off, limit %d\n", t.purchaseQuantity,
+				t.discountQuantity, t.discountPercentage, t.limit);
+		}
+		else if (t.kind == SPECIAL_BULK) {
+			snprintf(line + n, sizeof(line) - n, ", %d for %d, limit %d\n", t.purchaseQuantity, t.discountPrice, t.limit);
+		}
+		else {
+			snprintf(line + n, sizeof(line) - n, "\n");
+		}
+		out += line;
+	}
+	for (const FuzzOp& o : c.ops) {
+		describeOp(out, o);
+	}
+	return out;
+}
@@ -0,0 +1,87 @@
+#ifndef _FUZZ_H_
+#define _FUZZ_H_
+
+#include "special.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::string;
+using std::vector;
+
+//what a fuzz case does to a basket, mirroring the register calls
+const int FUZZ_SCAN = 0; //scanItem(product, amount)
+const int FUZZ_REMOVE = 1; //removeItem(product, amount)
+const int FUZZ_SCAN_N = 2; //scanItems(product, amount)
+const int FUZZ_REMOVE_N = 3; //removeItems(product, amount)
+
+struct FuzzProduct {
+	int price;
+	int markdown;
+	bool byWeight;
+	SpecialTerms terms; //kind SPECIAL_NONE for no special
+	int mix = -1; //index into the case's mixes of a mix and match special it shares, which replaces terms
+};
+
+struct FuzzOp {
+	int op;
+	int product; //index into the case's products, which is also its inventory handle
+	int amount; //weight for FUZZ_SCAN and FUZZ_REMOVE, a count for the others
+};
+
+//a random catalog and a sequence of basket changes against it
+struct FuzzCase {
+	int rounding = 0;
+	vector<FuzzProduct> products;
+	vector<SpecialTerms> mixes; //mix and match specials, each one object shared by its products
+	vector<FuzzOp> ops;
+};
+
+//a pricing engine under test plays a case's ops in order, appending the
+//basket total after each one to the vector, a rejected op leaving it as is
+typedef void (*PricingEngine)(const FuzzCase&, vector<int>&);
+
+//the first disagreement found between an engine and the reference
+struct FuzzMismatch {
+	string engine;
+	FuzzCase failing; //as generated
+	FuzzCase minimal; //as small as minimize could make it while still failing
+	size_t op = 0; //index into minimal.ops of the first wrong total
+	int expected = 0;
+	int actual = 0;
+};
+
+//differential fuzzer for basket pricing: generates random catalogs of BOGO,
+//BULK, mix and match, weighed and marked down products with random scan and remove
+//sequences, plays each through a reference, which prices unit priced lines
+//with the register's original floating point calcPrice and weighed lines
+//and mix pools with deliberately naive models, and through every engine added,
+//and reports the first case on which an engine's running total differs,
+//shrunk to a minimal reproduction
+class PricingFuzzer {
+private:
+	std::mt19937 rng;
+	vector<pair<string, PricingEngine>> engines;
+	long cases = 0;
+
+	bool fails(const FuzzCase&, PricingEngine) const;
+public:
+	PricingFuzzer(unsigned = 1);
+	inline void addEngine(const string& n, PricingEngine e) { engines.push_back(std::make_pair(n, e)); }
+	void addRegisterEngines();
+	inline size_t getEngines() const { return engines.size(); }
+	inline long getCases() const { return cases; }
+	FuzzCase generate();
+	bool check(const FuzzCase&, FuzzMismatch&) const;
+	FuzzCase minimize(const FuzzCase&, PricingEngine) const;
+	bool run(long, FuzzMismatch&);
+	static void reference(const FuzzCase&, vector<int>&);
+	static string describe(const FuzzCase&);
+};
+
+#endif
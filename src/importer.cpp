@@ -0,0 +1,198 @@
+#include "importer.h"
+#include "fields.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+//a parsed line, naming its product by position in the file buffer rather
+//than by an owned string
+struct ParsedRow {
+	const char* name;
+	size_t nameLength;
+	long line;
+	PriceRow row;
+	SpecialTerms special;
+	int group; //MIX group id
+};
+
+struct ChunkResult {
+	vector<ParsedRow> rows;
+	vector<ImportReject> rejects;
+	long lines = 0;
+};
+
+const char* validate(const char* p, const char* end, ParsedRow& r) {
+	//parses one line without its newline, returns nullptr on success or the
+	//reason it was rejected
+	const char* comma = (const char*) memchr(p, ',', end - p);
+	if (!comma || comma == p) {
+		return "missing product name";
+	}
+	r.name = p;
+	r.nameLength = comma - p;
+	p = comma;
+	int price, byWeight, markdown;
+	if (!parseField(p, end, price) || !parseField(p, end, byWeight) || !parseField(p, end, markdown)) {
+		return "expected integer price, byWeight and markdown";
+	}
+	if (price < 0) {
+		return "negative price";
+	}
+	if (byWeight != 0 && byWeight != 1) {
+		return "byWeight must be 0 or 1";
+	}
+	if (markdown != 0 && markdown >= price) {
+		return "markdown must be less than price";
+	}
+	r.row.price = price;
+	r.row.byWeight = byWeight;
+	r.row.markdown = markdown;
+	r.special = SpecialTerms();
+	r.group = 0;
+	if (p == end) {
+		return nullptr;
+	}
+	return parseSpecial(p, end, r.special, r.group);
+}
+
+void parseChunk(const char* p, const char* end, ChunkResult& out) {
+	//line numbers here are relative to the chunk and fixed up when merging
+	while (p < end) {
+		const char* nl = (const char*) memchr(p, '\n', end - p);
+		const char* lineEnd = nl ? nl : end;
+		++out.lines;
+		const char* e = lineEnd;
+		if (e > p && e[-1] == '\r') {
+			--e;
+		}
+		if (e > p) {
+			ParsedRow r;
+			const char* reason = validate(p, e, r);
+			if (reason) {
+				out.rejects.push_back(ImportReject{out.lines, reason});
+			}
+			else {
+				r.line = out.lines;
+				out.rows.push_back(r);
+			}
+		}
+		p = nl ? nl + 1 : end;
+	}
+}
+
+}
+
+CsvImporter::CsvImporter(int t, size_t b) {
+	threads = t > 0 ? t : std::max(1u, std::thread::hardware_concurrency());
+	blockSize = b;
+}
+
+bool CsvImporter::load(const string& path, Inventory& inv) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return true;
+	}
+	void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+	parse((const char*) base, st.st_size, inv);
+	munmap(base, st.st_size);
+	return true;
+}
+
+void CsvImporter::parse(const char* data, size_t len, Inventory& inv) {
+	//streams the buffer in blocks ending on a line boundary; each block is
+	//split into one chunk per thread, parsed in parallel into plain rows, then
+	//merged into the inventory in file order
+	const char* end = data + len;
+	const char* p = data;
+	long line = 0;
+	SpecialFactory specials; //identical specials and MIX groups are shared
+	if (len >= 5 && memcmp(p, "name,", 5) == 0) {
+		const char* nl = (const char*) memchr(p, '\n', len);
+		p = nl ? nl + 1 : end;
+		line = 1;
+	}
+	vector<ChunkResult> results(threads);
+	vector<std::thread> workers;
+	bool reserved = false;
+	while (p < end) {
+		const char* blockEnd = end - p > (long) blockSize ? p + blockSize : end;
+		const char* nl = blockEnd < end ? (const char*) memchr(blockEnd, '\n', end - blockEnd) : nullptr;
+		blockEnd = blockEnd < end ? (nl ? nl + 1 : end) : end;
+		size_t step = (blockEnd - p) / threads + 1;
+		const char* chunkStart = p;
+		for (int t = 0; t < threads; ++t) {
+			const char* chunkEnd = blockEnd - chunkStart > (long) step ? chunkStart + step : blockEnd;
+			if (chunkEnd < blockEnd) {
+				nl = (const char*) memchr(chunkEnd, '\n', blockEnd - chunkEnd);
+				chunkEnd = nl ? nl + 1 : blockEnd;
+			}
+			results[t] = ChunkResult();
+			if (t == threads - 1) {
+				parseChunk(chunkStart, chunkEnd, results[t]);
+			}
+			else {
+				workers.push_back(std::thread(parseChunk, chunkStart, chunkEnd, std::ref(results[t])));
+			}
+			chunkStart = chunkEnd;
+		}
+		for (std::thread& w : workers) {
+			w.join();
+		}
+		workers.clear();
+		if (!reserved) {
+			//size the catalog once from the row density of the first block
+			long rowsInBlock = 0;
+			for (const ChunkResult& c : results) {
+				rowsInBlock += c.rows.size();
+			}
+			inv.reserve(inv.size() + (int) ((double) rowsInBlock * (end - p) / (blockEnd - p)) + 1);
+			reserved = true;
+		}
+		for (ChunkResult& c : results) {
+			size_t k = 0;
+			for (const ParsedRow& r : c.rows) {
+				while (k < c.rejects.size() && c.rejects[k].line < r.line) {
+					c.rejects[k].line += line;
+					rejects.push_back(c.rejects[k++]);
+				}
+				shared_ptr<Special> s = specials.make(r.special, r.group);
+				if (r.special.kind != SPECIAL_NONE && !s) {
+					rejects.push_back(ImportReject{line + r.line, "MIX group listed with other terms"});
+				}
+				else if (inv.insertRow(r.name, r.nameLength, r.row, s) == -1) {
+					rejects.push_back(ImportReject{line + r.line, "duplicate product name"});
+				}
+				else {
+					++imported;
+				}
+			}
+			for (; k < c.rejects.size(); ++k) {
+				c.rejects[k].line += line;
+				rejects.push_back(c.rejects[k]);
+			}
+			line += c.lines;
+		}
+		p = blockEnd;
+	}
+}
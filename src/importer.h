@@ -0,0 +1,41 @@
+#ifndef _IMPORTER_H_
+#define _IMPORTER_H_
+
+#include "inventory.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+struct ImportReject {
+	long line; //1 based line number in the imported file
+	string reason;
+};
+
+//builds an inventory from a price file with one product per line:
+//	name,price,byWeight,markdown[,BOGO,purchaseQuantity,discountQuantity,discountPercentage[,limit]]
+//	name,price,byWeight,markdown[,BULK,purchaseQuantity,discountPrice[,limit]]
+//	name,price,byWeight,markdown[,MIX,group,purchaseQuantity,discountPrice[,limit]]
+//prices are in cents, byWeight is 0 or 1, names may not contain commas and an
+//optional header line starting with "name," is skipped. products listing one
+//MIX group id share one pool, and every row of a group must give the same
+//terms. rows are parsed in parallel blocks and rejected with the same rules
+//as Product::setMarkdown and SpecialBogo::setDiscountPercentage
+class CsvImporter {
+private:
+	int threads;
+	size_t blockSize;
+	long imported = 0;
+	vector<ImportReject> rejects;
+public:
+	CsvImporter(int = 0, size_t = 1 << 24);
+	bool load(const string&, Inventory&);
+	void parse(const char*, size_t, Inventory&);
+	inline long getImported() const { return imported; }
+	inline const vector<ImportReject>& getRejects() const { return rejects; }
+};
+
+#endif
@@ -1,28 +1,525 @@
 #include "inventory.h"
+#include "metrics.h"
+#include "special.h"
 
-bool Inventory::contains(string n) {
-	auto it = productList.find(n);
-	if (it == productList.end()) {
-		return false;
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+//catalog file layout, all fields in native byte order:
+//	FileHeader
+//	SpecialRecord[specialCount]
+//	catalog section (see Catalog::write)
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t specialCount;
+};
+
+static_assert(sizeof(FileHeader) == 16, "catalog file layout");
+
+struct SpecialRecord {
+	int32_t type; //SPECIAL_BOGO, SPECIAL_BULK or SPECIAL_MIX
+	int32_t purchaseQuantity;
+	int32_t discountQuantity;
+	int32_t discountPercentage;
+	int32_t discountPrice;
+	int32_t limit;
+};
+
+static_assert(sizeof(SpecialRecord) == 24, "catalog file layout");
+
+const char CATALOG_MAGIC[8] = {'I', 'N', 'V', 'C', 'A', 'T', 'L', 'G'};
+const uint32_t CATALOG_VERSION = 3;
+
+}
+
+InventorySnapshot::InventorySnapshot(const Catalog& c, unsigned long v) : catalog(c) {
+	version = v;
+}
+
+Inventory::~Inventory() {
+	for (const shared_ptr<Product>& p : products) {
+		if (p) {
+			p->detach(this);
+		}
 	}
-	return true;
+	for (const shared_ptr<Special>& s : specials) {
+		if (s) {
+			s->detach(this);
+		}
+	}
+	if (mapBase) {
+		munmap(mapBase, mapLength);
+	}
+}
+
+bool Inventory::contains(const string& n) const {
+	return getHandle(n) != -1;
 }
 
 bool Inventory::insert(shared_ptr<Product> p) {
-	if (this->contains(p->getName())) {
+	std::lock_guard<std::mutex> lock(writeLock);
+	//the row is complete before the name is published to readers
+	int h = insertLocked(p->getName().data(), p->getName().size(), rowOf(*p), p);
+	if (h == -1) {
 		return false;
 	}
-	productList[p->getName()] = p;
+	p->attach(this, h);
 	return true;
 }
 
-shared_ptr<Product> Inventory::retrieve(string n) {
-	shared_ptr<Product> p;
-	if (contains(n)) {
-		p = productList[n];
+int Inventory::insertRow(const char* n, size_t len, const PriceRow& r, const shared_ptr<Special>& s) {
+	//inserts pricing fields directly, the product object is only created if
+	//it is later retrieved; returns the new handle, or -1 if the name exists
+	std::lock_guard<std::mutex> lock(writeLock);
+	PriceRow row = r;
+	row.special = internSpecial(s);
+	return insertLocked(n, len, row, nullptr);
+}
+
+void Inventory::reserve(int n) {
+	std::lock_guard<std::mutex> lock(writeLock);
+	catalog.reserve(n);
+	products.reserve(n);
+}
+
+bool Inventory::erase(const string& n) {
+	//the name stops resolving, the handle goes only to the same name inserted
+	//again, and the product object stays alive so borrowed pointers to it
+	//remain valid
+	PriceDelta d;
+	d.op = PriceDelta::ERASE;
+	d.name = n;
+	std::lock_guard<std::mutex> lock(writeLock);
+	return applyLocked(d) == nullptr;
+}
+
+int Inventory::apply(const vector<PriceDelta>& batch, vector<const char*>* reasons) {
+	//applies a batch of changes under one lock acquisition; scans keep
+	//running against the rows throughout. returns how many were applied and
+	//optionally why each of the rest was not (nullptr where it was applied)
+	std::lock_guard<std::mutex> lock(writeLock);
+	int applied = 0;
+	if (reasons) {
+		reasons->assign(batch.size(), nullptr);
 	}
-	else {
-		p = nullptr;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		const char* reason = applyLocked(batch[i]);
+		if (reason == nullptr) {
+			++applied;
+		}
+		else if (reasons) {
+			(*reasons)[i] = reason;
+		}
+	}
+	return applied;
+}
+
+const char* Inventory::applyLocked(const PriceDelta& d) {
+	int h = catalog.find(d.name);
+	if (d.op == PriceDelta::UPSERT || d.op == PriceDelta::PRICE) {
+		if (d.price < 0) {
+			return "negative price";
+		}
+	}
+	if (d.op == PriceDelta::UPSERT) {
+		//same rule as Product::setMarkdown
+		if (d.markdown != 0 && d.markdown >= d.price) {
+			return "markdown must be less than price";
+		}
+		PriceRow r;
+		r.price = d.price;
+		r.byWeight = d.byWeight;
+		r.markdown = d.markdown;
+		if (h == -1) {
+			insertLocked(d.name.data(), d.name.size(), r, nullptr);
+			return nullptr;
+		}
+		PriceRow old = catalog.getRow(h);
+		r.special = old.special;
+		change(h, r, old.special == -1 ? nullptr : specials[old.special]);
+		return nullptr;
 	}
+	if (h == -1) {
+		return "unknown product";
+	}
+	PriceRow r = catalog.getRow(h);
+	shared_ptr<Special> special = r.special == -1 ? nullptr : specials[r.special];
+	switch (d.op) {
+		case PriceDelta::PRICE:
+			r.price = d.price;
+			break;
+		case PriceDelta::MARKDOWN:
+			if (d.markdown != 0 && d.markdown >= r.price) {
+				return "markdown must be less than price";
+			}
+			r.markdown = d.markdown;
+			break;
+		case PriceDelta::SPECIAL:
+			special = d.special;
+			break;
+		default:
+			catalog.erase(h);
+			if (products[h]) {
+				products[h]->detach(this);
+			}
+			return nullptr;
+	}
+	change(h, r, special);
+	return nullptr;
+}
+
+void Inventory::change(int h, const PriceRow& r, const shared_ptr<Special>& s) {
+	//sets a row's pricing, keeping its product object and the rows of any
+	//other inventory holding that product in step; writeLock held
+	Product* p = products[h].get();
+	if (!p) {
+		PriceRow row = r;
+		row.special = internSpecial(s);
+		setRow(h, row);
+		return;
+	}
+	p->price = r.price;
+	p->markdown = r.markdown;
+	p->byWeight = r.byWeight != 0;
+	p->special = s;
+	storePricing(h);
+	p->notify(this);
+}
+
+shared_ptr<Product> Inventory::retrieve(const string& n) const {
+	METRIC_START(start);
+	shared_ptr<Product> p = product(getHandle(n));
+	METRIC_STOP(METRIC_RETRIEVE, start);
 	return p;
 }
+
+shared_ptr<Product> Inventory::retrieve(int h) const {
+	METRIC_START(start);
+	shared_ptr<Product> p = product(h);
+	METRIC_STOP(METRIC_RETRIEVE, start);
+	return p;
+}
+
+shared_ptr<Product> Inventory::product(int h) const {
+	if (!get(h)) {
+		METRIC_COUNT(COUNT_RETRIEVE_MISS);
+		return nullptr;
+	}
+	METRIC_COUNT(COUNT_RETRIEVE_HIT);
+	std::lock_guard<std::mutex> lock(writeLock);
+	return products[h];
+}
+
+Product* Inventory::find(const string& n, int* h) const {
+	//single hash probe, optionally reporting the handle of the found product
+	int found = catalog.find(n);
+	if (h) {
+		*h = found;
+	}
+	return get(found);
+}
+
+Product* Inventory::get(int h) const {
+	if (h < 0 || h >= size() || catalog.getRow(h).erased) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(writeLock);
+	if (products[h]) {
+		return products[h].get();
+	}
+	return const_cast<Inventory*>(this)->load(h);
+}
+
+int Inventory::internSpecial(const shared_ptr<Special>& s) {
+	//the special's slot, giving it a retired one or a new one if it has
+	//none; the slot counts as used once a row refers to it
+	if (!s) {
+		return -1;
+	}
+	unordered_map<const Special*, int>::iterator found = specialIndex.find(s.get());
+	if (found != specialIndex.end()) {
+		return found->second;
+	}
+	s->attach(this); //a change to its terms is republished through restate
+	int i;
+	if (!freeSpecials.empty()) {
+		i = freeSpecials.back();
+		freeSpecials.pop_back();
+		catalog.setSpecial(i, s->getTerms());
+		specials[i] = s;
+	}
+	else {
+		i = catalog.addSpecial(s->getTerms());
+		specials.push_back(s);
+		specialRefs.push_back(0);
+	}
+	specialIndex.emplace(s.get(), i);
+	return i;
+}
+
+void Inventory::releaseSpecial(int i) {
+	//drops a row's hold on slot i, retiring the slot once no row refers to
+	//it; called with no hold to retire a slot a failed insert didn't use
+	if (i == -1 || specialRefs[i] < 0 || (specialRefs[i] > 0 && --specialRefs[i] > 0)) {
+		return;
+	}
+	specials[i]->detach(this);
+	specialIndex.erase(specials[i].get());
+	specials[i] = nullptr;
+	freeSpecials.push_back(i);
+}
+
+void Inventory::restate(const Special* s) {
+	//called by a special after its terms change. scans may be reading its
+	//slot at any moment, so it gets a new slot and every row referring to
+	//the old one moves to that, advancing the row's version, before the old
+	//one is retired; a pass over every row
+	std::lock_guard<std::mutex> lock(writeLock);
+	unordered_map<const Special*, int>::iterator found = specialIndex.find(s);
+	if (found == specialIndex.end()) {
+		return;
+	}
+	int old = found->second;
+	shared_ptr<Special> held = specials[old];
+	specialIndex.erase(found);
+	specials[old] = nullptr;
+	int i = internSpecial(held);
+	int rows = 0;
+	for (int h = 0; h < catalog.size(); ++h) {
+		PriceRow r = catalog.getRow(h);
+		if (r.special == old) {
+			r.special = i;
+			catalog.setRow(h, r);
+			++rows;
+		}
+	}
+	//counted now, even for a special read from a mapped file
+	specialRefs[i] = rows;
+	specialRefs[old] = 0;
+	freeSpecials.push_back(old);
+	if (rows == 0) {
+		releaseSpecial(i);
+	}
+}
+
+int Inventory::insertLocked(const char* n, size_t len, const PriceRow& r, const shared_ptr<Product>& p) {
+	//adds a row for product p, or for one made on first use if p is
+	//nullptr, holding its special's slot; returns the handle, or -1 if the
+	//name exists. a name erased before takes back its row, dropping the
+	//erased row's hold on its special
+	PriceRow replaced;
+	int h = catalog.insert(n, len, r, &replaced);
+	if (r.special != -1 && specialRefs[r.special] >= 0) {
+		if (h != -1) {
+			++specialRefs[r.special];
+		}
+		else if (specialRefs[r.special] == 0) {
+			releaseSpecial(r.special);
+		}
+	}
+	if (h == -1) {
+		return -1;
+	}
+	if (h < (int) products.size()) {
+		releaseSpecial(replaced.special);
+		if (products[h]) {
+			erasedProducts.push_back(products[h]);
+		}
+		products[h] = p;
+	}
+	else {
+		products.push_back(p);
+	}
+	return h;
+}
+
+void Inventory::setRow(int h, const PriceRow& r) {
+	//changes a row, moving its hold from its old special's slot to the new
+	//one's; the row's version advances, so anything priced from the old
+	//terms is seen to be stale
+	int old = catalog.getRow(h).special;
+	if (r.special != -1 && specialRefs[r.special] >= 0) {
+		++specialRefs[r.special];
+	}
+	catalog.setRow(h, r);
+	releaseSpecial(old);
+}
+
+const Special* Inventory::getSpecial(int i) const {
+	//the special whose terms are in slot i, nullptr if none
+	std::lock_guard<std::mutex> lock(writeLock);
+	return i < 0 || i >= (int) specials.size() ? nullptr : specials[i].get();
+}
+
+int Inventory::getSpecialSlots() const {
+	//catalog special slots held by a special now
+	std::lock_guard<std::mutex> lock(writeLock);
+	return specials.size() - freeSpecials.size();
+}
+
+void Inventory::refresh(int h) {
+	//called by a product after a change
+	std::lock_guard<std::mutex> lock(writeLock);
+	storePricing(h);
+}
+
+void Inventory::storePricing(int h) {
+	//copies the product's pricing fields into its row, with writeLock held
+	setRow(h, rowOf(*products[h]));
+}
+
+PriceRow Inventory::rowOf(const Product& p) {
+	PriceRow r;
+	r.price = p.getPrice();
+	r.markdown = p.getMarkdown();
+	r.byWeight = p.getByWeight();
+	r.special = internSpecial(p.getSpecial());
+	return r;
+}
+
+Product* Inventory::load(int h) {
+	//builds the product object for a row of a mapped catalog or a row
+	//added by insertRow
+	PriceRow r = catalog.getRow(h);
+	shared_ptr<Product> p = std::make_shared<Product>(catalog.getName(h), r.price, r.byWeight != 0);
+	p->markdown = r.markdown;
+	if (r.special != -1) {
+		p->special = specials[r.special];
+	}
+	p->attach(this, h);
+	products[h] = p;
+	return p.get();
+}
+
+unsigned long Inventory::publish() {
+	//builds a new version off to the side and swaps it in with one pointer
+	//store; registers which pinned an older version keep it alive until
+	//their basket is reset
+	std::lock_guard<std::mutex> lock(writeLock);
+	shared_ptr<const InventorySnapshot> next = std::make_shared<InventorySnapshot>(catalog, ++version);
+	std::atomic_store(&published, next);
+	return version;
+}
+
+shared_ptr<const InventorySnapshot> Inventory::snapshot() {
+	//the latest published version, publishing the first one if needed
+	shared_ptr<const InventorySnapshot> current = std::atomic_load(&published);
+	if (!current) {
+		publish();
+		current = std::atomic_load(&published);
+	}
+	return current;
+}
+
+bool Inventory::save(const string& path) const {
+	//writes the products, markdowns and specials in the format read by mapFile
+	std::lock_guard<std::mutex> lock(writeLock);
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f) {
+		return false;
+	}
+	FileHeader header;
+	memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+	header.version = CATALOG_VERSION;
+	header.specialCount = specials.size();
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	for (size_t i = 0; ok && i < specials.size(); ++i) {
+		//a retired slot is written as SPECIAL_NONE, so the slots keep their indexes
+		SpecialTerms t = specials[i] ? catalog.getSpecial(i) : SpecialTerms();
+		SpecialRecord rec;
+		rec.type = t.kind;
+		rec.purchaseQuantity = t.purchaseQuantity;
+		rec.discountQuantity = t.discountQuantity;
+		rec.discountPercentage = t.discountPercentage;
+		rec.discountPrice = t.discountPrice;
+		rec.limit = t.limit;
+		ok = fwrite(&rec, sizeof(rec), 1, f) == 1;
+	}
+	ok = ok && catalog.write(f);
+	return fclose(f) == 0 && ok;
+}
+
+bool Inventory::mapFile(const string& path) {
+	//serves lookups straight from a file written by save, without reading
+	//it in; only an empty inventory can be mapped. the specials are small
+	//and are created up front
+	std::lock_guard<std::mutex> lock(writeLock);
+	if (catalog.size() != 0 || mapBase) {
+		return false;
+	}
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	void* base = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		base = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	size_t len = st.st_size;
+	const char* data = (const char*) base;
+	FileHeader header;
+	size_t specialBytes = 0;
+	bool ok = len >= sizeof(header);
+	if (ok) {
+		memcpy(&header, data, sizeof(header));
+		specialBytes = (size_t) header.specialCount * sizeof(SpecialRecord);
+		ok = memcmp(header.magic, CATALOG_MAGIC, sizeof(header.magic)) == 0
+			&& header.version == CATALOG_VERSION
+			&& len >= sizeof(header) + specialBytes;
+	}
+	vector<shared_ptr<Special>> read;
+	vector<SpecialTerms> terms;
+	const SpecialRecord* records = (const SpecialRecord*) (data + sizeof(header));
+	for (uint32_t i = 0; ok && i < header.specialCount; ++i) {
+		const SpecialRecord& rec = records[i];
+		if (rec.type == SPECIAL_BOGO) {
+			read.push_back(std::make_shared<SpecialBogo>(rec.purchaseQuantity, rec.discountQuantity, rec.discountPercentage, rec.limit));
+		}
+		else if (rec.type == SPECIAL_BULK) {
+			read.push_back(std::make_shared<SpecialBulk>(rec.purchaseQuantity, rec.discountPrice, rec.limit));
+		}
+		else if (rec.type == SPECIAL_MIX) {
+			read.push_back(std::make_shared<SpecialMix>(rec.purchaseQuantity, rec.discountPrice, rec.limit));
+		}
+		else if (rec.type == SPECIAL_NONE) {
+			read.push_back(nullptr); //retired
+		}
+		else {
+			ok = false;
+			break;
+		}
+		terms.push_back(read.back() ? read.back()->getTerms() : SpecialTerms());
+	}
+	ok = ok && catalog.map(data + sizeof(header) + specialBytes, len - sizeof(header) - specialBytes, terms) != 0;
+	if (!ok) {
+		munmap(base, len);
+		return false;
+	}
+	mapBase = base;
+	mapLength = len;
+	for (uint32_t i = 0; i < header.specialCount; ++i) {
+		specials.push_back(read[i]);
+		specialRefs.push_back(read[i] ? -1 : 0);
+		if (read[i]) {
+			read[i]->attach(this);
+			specialIndex.emplace(read[i].get(), i);
+		}
+		else {
+			freeSpecials.push_back(i);
+		}
+	}
+	products.assign(catalog.size(), nullptr);
+	return true;
+}
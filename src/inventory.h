@@ -1,23 +1,117 @@
 #ifndef _INVENTORY_H_
 #define _INVENTORY_H_
 
+#include "catalog.h"
 #include "product.h"
 
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 using std::shared_ptr;
 using std::string;
 using std::unordered_map;
+using std::vector;
 
+//one change in a batch passed to Inventory::apply
+struct PriceDelta {
+	enum Op { UPSERT, PRICE, MARKDOWN, SPECIAL, ERASE };
+	Op op;
+	string name;
+	int price = 0; //UPSERT and PRICE
+	int byWeight = 0; //UPSERT
+	int markdown = 0; //UPSERT and MARKDOWN, 0 clears the markdown
+	shared_ptr<Special> special = nullptr; //SPECIAL, nullptr detaches the special
+};
+
+//an immutable copy of an inventory's catalog, specials' terms included, at
+//one version, which registers can price a whole basket against
+class InventorySnapshot {
+private:
+	Catalog catalog;
+	unsigned long version;
+public:
+	InventorySnapshot(const Catalog&, unsigned long);
+	inline const Catalog& getCatalog() const { return catalog; }
+	inline unsigned long getVersion() const { return version; }
+};
+
+//an inventory may be shared by registers on many threads: getHandle,
+//pricing and size never lock and can run alongside one thread making
+//changes, either through the inventory or through its products. the
+//remaining calls take a lock
+//
+//a special's slot in the catalog lasts while some row, erased or not, refers
+//to it; the slot is then retired, dropping the inventory's hold on the
+//special, and reused for the next new one, so changing specials over a long
+//running store doesn't grow the catalog. specials read from a mapped file
+//keep their slots, since counting the rows using them would read the whole
+//file in, until their terms change
 class Inventory {
 private:
-	unordered_map<string, shared_ptr<Product>> productList;
+	Catalog catalog; //name index, pricing rows and specials, handles are
+		//assigned densely from 0 in insertion order
+	vector<shared_ptr<Product>> products; //indexed by handle
+		//rows added by insertRow or mapped from a file get their product on first use
+	vector<shared_ptr<Product>> erasedProducts; //erased products whose handle went to a new one
+		//of the same name, kept so borrowed pointers to them stay valid
+	vector<shared_ptr<Special>> specials; //by catalog special slot, the special it holds the terms of,
+		//nullptr once retired
+	unordered_map<const Special*, int> specialIndex;
+	vector<int> specialRefs; //by slot, rows referring to it, -1 for slots read from a mapped file
+	vector<int> freeSpecials; //retired slots
+	mutable std::mutex writeLock; //guards products, specials and changes to catalog
+	shared_ptr<const InventorySnapshot> published = nullptr; //read and replaced with atomic_load and atomic_store
+	unsigned long version = 0;
+	void* mapBase = nullptr; //catalog file mapping, if any
+	size_t mapLength = 0;
+
+	int internSpecial(const shared_ptr<Special>&);
+	void releaseSpecial(int);
+	int insertLocked(const char*, size_t, const PriceRow&, const shared_ptr<Product>&);
+	void setRow(int, const PriceRow&);
+	void refresh(int);
+	void storePricing(int);
+	PriceRow rowOf(const Product&);
+	void change(int, const PriceRow&, const shared_ptr<Special>&);
+	const char* applyLocked(const PriceDelta&);
+	Product* load(int);
+	shared_ptr<Product> product(int) const;
+	void restate(const Special*);
+	friend class Product;
+	friend class Special;
 public:
-	bool contains(string);
+	Inventory() = default;
+	Inventory(const Inventory&) = delete;
+	Inventory& operator=(const Inventory&) = delete;
+	~Inventory();
+	bool contains(const string&) const;
 	bool insert(shared_ptr<Product>);
-	shared_ptr<Product> retrieve(string);
+	int insertRow(const char*, size_t, const PriceRow&, const shared_ptr<Special>&);
+	void reserve(int);
+	bool erase(const string&);
+	int apply(const vector<PriceDelta>&, vector<const char*>* = nullptr);
+	shared_ptr<Product> retrieve(const string&) const;
+	shared_ptr<Product> retrieve(int) const;
+	inline int getHandle(const string& n) const { return catalog.find(n); }
+	inline int getHandle(const char* n, size_t len) const { return catalog.find(n, len); }
+	Product* find(const string&, int* = nullptr) const;
+	Product* get(int) const;
+		//find and get return a borrowed pointer which stays valid for the
+		//lifetime of the inventory, without touching the product's refcount
+	inline int size() const { return catalog.size(); }
+	inline PriceRow pricing(int h) const { return catalog.getRow(h); }
+	const Special* getSpecial(int) const;
+	int getSpecialSlots() const;
+	inline const Catalog& getCatalog() const { return catalog; }
+	unsigned long publish();
+	shared_ptr<const InventorySnapshot> snapshot();
+	bool save(const string&) const;
+	bool mapFile(const string&);
+	inline bool isMapped() const { return mapBase != nullptr; }
 };
 
 #endif
@@ -0,0 +1,163 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char JOURNAL_MAGIC[8] = {'R', 'E', 'G', 'J', 'R', 'N', 'L', '1'};
+
+off_t readRecords(int fd, vector<JournalRecord>* out) {
+	//reads the records of the journal open at fd from its start, up to its
+	//end or the first record which was torn by a crash mid write, into out
+	//if given; returns the length of the journal up to that point, 0 if
+	//the file is empty or its header torn, or -1 if it isn't a journal
+	char magic[sizeof(JOURNAL_MAGIC)];
+	ssize_t got = pread(fd, magic, sizeof(magic), 0);
+	if (got < 0) {
+		return -1;
+	}
+	if (got < (ssize_t) sizeof(magic)) {
+		return std::equal(magic, magic + got, JOURNAL_MAGIC) ? 0 : -1;
+	}
+	if (!std::equal(magic, magic + sizeof(magic), JOURNAL_MAGIC)) {
+		return -1;
+	}
+	off_t end = sizeof(magic);
+	JournalRecord chunk[1024];
+	size_t carry = 0;
+	for (;;) {
+		ssize_t n = pread(fd, (char*) chunk + carry, sizeof(chunk) - carry, end + carry);
+		if (n <= 0) {
+			return end;
+		}
+		size_t bytes = carry + n;
+		size_t whole = bytes / sizeof(JournalRecord);
+		for (size_t i = 0; i < whole; ++i) {
+			if (Journal::checksum(chunk[i]) != chunk[i].check) {
+				return end;
+			}
+			if (out) {
+				out->push_back(chunk[i]);
+			}
+			end += sizeof(JournalRecord);
+		}
+		carry = bytes % sizeof(JournalRecord);
+		if (carry) {
+			memmove(chunk, (char*) chunk + whole * sizeof(JournalRecord), carry);
+		}
+	}
+}
+
+}
+
+Journal::Journal(int c, int s) {
+	commitEvery = c > 0 ? c : 1;
+	syncEvery = s > 0 ? s : 0;
+	buffer.reserve(commitEvery);
+}
+
+Journal::~Journal() {
+	close();
+}
+
+bool Journal::open(const string& path, bool truncate) {
+	//appends to the journal at path, creating it if needed; truncate starts
+	//it over. a record torn at the end by a crash is cut off first, so the
+	//records appended after it can be read back. false if path is some
+	//other kind of file
+	close();
+	failed = false;
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	off_t end = fstat(fd, &st) == 0 ? readRecords(fd, nullptr) : -1;
+	if (end == -1 || (end < st.st_size && ftruncate(fd, end) != 0)) {
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	if (end == 0 && write(fd, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != (ssize_t) sizeof(JOURNAL_MAGIC)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool Journal::close() {
+	//commits and syncs what is buffered, then closes the file
+	if (fd == -1) {
+		buffer.clear();
+		return !failed;
+	}
+	bool ok = commit() && (syncEvery == 0 || sync());
+	ok = ::close(fd) == 0 && ok;
+	fd = -1;
+	return ok;
+}
+
+bool Journal::commit() {
+	//writes the buffered records in one call
+	if (buffer.empty()) {
+		return !failed;
+	}
+	if (fd == -1) {
+		buffer.clear();
+		return false;
+	}
+	size_t bytes = buffer.size() * sizeof(JournalRecord);
+	const char* p = (const char*) buffer.data();
+	while (bytes > 0) {
+		ssize_t n = write(fd, p, bytes);
+		if (n <= 0) {
+			failed = true;
+			break;
+		}
+		p += n;
+		bytes -= n;
+	}
+	buffer.clear();
+	if (syncEvery != 0 && ++unsynced >= syncEvery) {
+		sync();
+	}
+	return !failed;
+}
+
+bool Journal::sync() {
+	if (fd == -1) {
+		return false;
+	}
+	unsynced = 0;
+	++syncs;
+	if (fdatasync(fd) != 0) {
+		failed = true;
+	}
+	return !failed;
+}
+
+uint16_t Journal::checksum(const JournalRecord& r) {
+	uint32_t h = 2166136261u;
+	const int32_t fields[4] = {r.handle, r.amount, r.total, r.op};
+	for (int32_t f : fields) {
+		h = (h ^ (uint32_t) f) * 16777619u;
+	}
+	return (uint16_t) (h ^ (h >> 16));
+}
+
+bool Journal::read(const string& path, vector<JournalRecord>& out) {
+	//reads the records of a journal up to its end or the first record which
+	//was torn by a crash mid write; false if it can't be opened or isn't a journal
+	out.clear();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	off_t end = readRecords(fd, &out);
+	::close(fd);
+	return end >= (off_t) sizeof(JOURNAL_MAGIC);
+}
@@ -0,0 +1,74 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+const int JOURNAL_SCAN = 1;
+const int JOURNAL_REMOVE = 2;
+const int JOURNAL_RESET = 3;
+
+//one change to a basket: the product's handle, the change to its quantity
+//and the register's total after it
+struct JournalRecord {
+	int32_t handle;
+	int32_t amount; //units, or hundredths of a pound if priced by weight
+	int32_t total;
+	uint16_t op; //a JOURNAL_ constant
+	uint16_t check; //over the other fields, so a torn write at the end is detected
+};
+
+static_assert(sizeof(JournalRecord) == 16, "journal file layout");
+
+//an append-only file of a register's scans and removals, so the basket in
+//progress can be rebuilt if the lane process dies. records are buffered and
+//group committed, commitEvery at a time in one write, and every syncEvery
+//commits are also flushed to disk (never if 0). a process crash loses at
+//most the records not yet committed; a power loss those not yet synced
+class Journal {
+private:
+	int fd = -1;
+	int commitEvery;
+	int syncEvery;
+	int unsynced = 0; //commits since the last sync
+	vector<JournalRecord> buffer;
+	long long records = 0;
+	long long syncs = 0;
+	bool failed = false;
+public:
+	Journal(int = 32, int = 1);
+	Journal(const Journal&) = delete;
+	Journal& operator=(const Journal&) = delete;
+	~Journal();
+	bool open(const string&, bool = false);
+	bool close();
+	inline void append(int, int, int, int);
+	bool commit();
+	bool sync();
+	inline bool isOpen() const { return fd != -1; }
+	inline bool getFailed() const { return failed; }
+	inline long long getRecords() const { return records; }
+	inline long long getSyncs() const { return syncs; }
+	static uint16_t checksum(const JournalRecord&);
+	static bool read(const string&, vector<JournalRecord>&);
+};
+
+void Journal::append(int op, int h, int amount, int total) {
+	JournalRecord r;
+	r.handle = h;
+	r.amount = amount;
+	r.total = total;
+	r.op = op;
+	r.check = checksum(r);
+	buffer.push_back(r);
+	++records;
+	if ((int) buffer.size() >= commitEvery) {
+		commit();
+	}
+}
+
+#endif
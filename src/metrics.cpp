@@ -0,0 +1,127 @@
+#include "metrics.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+thread_local ThreadMetrics* localMetrics = nullptr;
+
+namespace {
+
+std::mutex registryLock;
+std::vector<std::unique_ptr<ThreadMetrics>>& registry() {
+	//every block handed out, kept after its thread exits so its counts stay
+	//in snapshots
+	static std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+	return blocks;
+}
+
+}
+
+ThreadMetrics::ThreadMetrics() {
+	for (std::atomic<uint64_t>& c : counters) {
+		c.store(0, std::memory_order_relaxed);
+	}
+	for (auto& op : buckets) {
+		for (std::atomic<uint64_t>& b : op) {
+			b.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+ThreadMetrics* Metrics::attach() {
+	//gives the calling thread its block, on its first recording
+	std::lock_guard<std::mutex> guard(registryLock);
+	registry().emplace_back(new ThreadMetrics());
+	localMetrics = registry().back().get();
+	return localMetrics;
+}
+
+MetricsSnapshot Metrics::snapshot() {
+	//sums every thread's block; recordings made meanwhile may or may not be included
+	MetricsSnapshot s;
+	for (uint64_t& c : s.counters) {
+		c = 0;
+	}
+	for (auto& op : s.buckets) {
+		for (uint64_t& b : op) {
+			b = 0;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(registryLock);
+		for (const std::unique_ptr<ThreadMetrics>& m : registry()) {
+			for (int c = 0; c < METRIC_COUNTERS; ++c) {
+				s.counters[c] += m->counters[c].load(std::memory_order_relaxed);
+			}
+			for (int op = 0; op < METRIC_OPS; ++op) {
+				for (int b = 0; b < METRIC_BUCKETS; ++b) {
+					s.buckets[op][b] += m->buckets[op][b].load(std::memory_order_relaxed);
+				}
+			}
+		}
+	}
+	s.ticksPerNs = ticksPerNs();
+	return s;
+}
+
+void Metrics::reset() {
+	//zeroes every block; a recording racing with this may survive it
+	std::lock_guard<std::mutex> guard(registryLock);
+	for (const std::unique_ptr<ThreadMetrics>& m : registry()) {
+		for (std::atomic<uint64_t>& c : m->counters) {
+			c.store(0, std::memory_order_relaxed);
+		}
+		for (auto& op : m->buckets) {
+			for (std::atomic<uint64_t>& b : op) {
+				b.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+double Metrics::ticksPerNs() {
+	//the cycle counter's rate, measured once against the steady clock
+	static double rate = [] {
+		auto start = std::chrono::steady_clock::now();
+		uint64_t ticks = now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		double r = (now() - ticks) / ns;
+		return r > 0 ? r : 1;
+	}();
+	return rate;
+}
+
+uint64_t MetricsSnapshot::getOps(int op) const {
+	uint64_t n = 0;
+	for (int b = 0; b < METRIC_BUCKETS; ++b) {
+		n += buckets[op][b];
+	}
+	return n;
+}
+
+uint64_t MetricsSnapshot::percentileTicks(int op, double q) const {
+	//the middle of the bucket holding the q quantile of op's latencies, 0 if
+	//none were recorded
+	uint64_t n = getOps(op);
+	if (n == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t) (q * n);
+	if (rank >= n) {
+		rank = n - 1;
+	}
+	uint64_t seen = 0;
+	for (int b = 0; b < METRIC_BUCKETS; ++b) {
+		seen += buckets[op][b];
+		if (seen > rank) {
+			uint64_t low = Metrics::bucketStart(b);
+			uint64_t high = b + 1 < METRIC_BUCKETS ? Metrics::bucketStart(b + 1) : low;
+			return low + (high - low) / 2;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,143 @@
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+//timed operations
+const int METRIC_SCAN = 0; //Register::scanItem, scanItems
+const int METRIC_REMOVE = 1; //Register::removeItem, removeItems
+const int METRIC_RETRIEVE = 2; //Inventory::retrieve
+const int METRIC_SCAN_BATCH = 3; //Register::scanBatch, a whole batch
+const int METRIC_REMOVE_BATCH = 4; //Register::removeBatch, a whole batch
+const int METRIC_OPS = 5;
+
+//counted outcomes, for batch calls one per entry
+const int COUNT_SCANNED = 0;
+const int COUNT_SCAN_UNKNOWN = 1; //no such product, or no inventory
+const int COUNT_SCAN_ERASED = 2;
+const int COUNT_SCAN_NO_WEIGHT = 3; //weighed product scanned without a weight
+const int COUNT_REMOVED = 4;
+const int COUNT_REMOVE_UNKNOWN = 5;
+const int COUNT_REMOVE_NO_WEIGHT = 6;
+const int COUNT_REMOVE_NOT_SCANNED = 7; //more removed than the basket holds
+const int COUNT_RETRIEVE_HIT = 8;
+const int COUNT_RETRIEVE_MISS = 9;
+const int METRIC_COUNTERS = 10;
+
+//latencies are kept in ticks of the cycle counter, in buckets four to each
+//power of two, so a percentile is within 25% of the true value
+const int METRIC_BUCKETS = 252;
+
+//one operation in this many is timed on each thread, since reading the cycle
+//counter costs more than a scan itself on some virtual machines. counters
+//count every operation
+#ifndef REGISTER_METRICS_SAMPLE
+#define REGISTER_METRICS_SAMPLE 8
+#endif
+
+//one thread's counters and histograms. only the owning thread writes them,
+//with plain relaxed stores, so recording takes no locks and no atomic read
+//modify writes; a snapshot may read them at any time
+struct ThreadMetrics {
+	std::atomic<uint64_t> counters[METRIC_COUNTERS];
+	std::atomic<uint64_t> buckets[METRIC_OPS][METRIC_BUCKETS];
+	unsigned countdown = 1; //operations until the next one timed
+	ThreadMetrics();
+	inline void bump(std::atomic<uint64_t>& a) { a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+};
+
+//every thread's metrics merged at one moment. operation counts and
+//percentiles come from the sampled operations
+class MetricsSnapshot {
+private:
+	uint64_t counters[METRIC_COUNTERS];
+	uint64_t buckets[METRIC_OPS][METRIC_BUCKETS];
+	double ticksPerNs;
+	friend class Metrics;
+public:
+	inline uint64_t getCount(int c) const { return counters[c]; }
+	uint64_t getOps(int) const;
+	uint64_t percentileTicks(int, double) const;
+	inline double percentile(int op, double q) const { return percentileTicks(op, q) / ticksPerNs; } //in ns
+	inline double getTicksPerNs() const { return ticksPerNs; }
+};
+
+//process wide registry of per thread metrics. each thread gets its block on
+//first use and keeps it for the life of the process
+class Metrics {
+private:
+	static ThreadMetrics* attach();
+public:
+	static inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+	static inline int bucketOf(uint64_t);
+	static inline uint64_t bucketStart(int);
+	static inline ThreadMetrics& local();
+	static inline void count(int c) { ThreadMetrics& m = local(); m.bump(m.counters[c]); }
+	static inline void add(int op, uint64_t ticks) { ThreadMetrics& m = local(); m.bump(m.buckets[op][bucketOf(ticks)]); }
+	static inline void record(int op, uint64_t start) { add(op, now() - start); }
+	static inline uint64_t sample();
+	static MetricsSnapshot snapshot();
+	static void reset();
+	static double ticksPerNs();
+};
+
+extern thread_local ThreadMetrics* localMetrics;
+
+int Metrics::bucketOf(uint64_t t) {
+	//t itself below 4, else four buckets per power of two
+	if (t < 4) {
+		return (int) t;
+	}
+	int e = 63 - __builtin_clzll(t);
+	return (e - 1) * 4 + (int) ((t >> (e - 2)) & 3);
+}
+
+uint64_t Metrics::bucketStart(int b) {
+	if (b < 4) {
+		return b;
+	}
+	return (uint64_t) (4 + b % 4) << (b / 4 - 1);
+}
+
+ThreadMetrics& Metrics::local() {
+	ThreadMetrics* m = localMetrics;
+	return m ? *m : *attach();
+}
+
+uint64_t Metrics::sample() {
+	//the time now if this operation is one of those sampled, else 0
+	ThreadMetrics& m = local();
+	if (--m.countdown != 0) {
+		return 0;
+	}
+	m.countdown = REGISTER_METRICS_SAMPLE;
+	return now();
+}
+
+//hooks for Register and Inventory, compiled in only when REGISTER_METRICS is
+//defined and otherwise gone entirely
+#ifdef REGISTER_METRICS
+#define METRIC_START(t) uint64_t t = Metrics::sample()
+#define METRIC_STOP(op, t) (t ? Metrics::record(op, t) : (void) 0)
+#define METRIC_COUNT(c) Metrics::count(c)
+#else
+#define METRIC_START(t) ((void) 0)
+#define METRIC_STOP(op, t) ((void) 0)
+#define METRIC_COUNT(c) ((void) 0)
+#endif
+
+#endif
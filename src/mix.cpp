@@ -0,0 +1,69 @@
+#include "mix.h"
+
+void MixPool::clear() {
+	//empties the pool, keeping its capacity
+	units.clear();
+	runs.clear();
+	sum = 0;
+	grouped = 0;
+	groups = 0;
+}
+
+int MixPool::add(int line, int price, vector<vector<int>>& positions) {
+	//adds a unit of a line at the next position; returns what that adds to
+	//the pool's value: its price, or when it completes a run within the
+	//limit, discountPrice less what the rest of the run was charged
+	int before = value();
+	int i = units.size();
+	int run = i / terms.purchaseQuantity;
+	vector<int>& mine = positions[line];
+	units.push_back(Unit{line, price, (int) mine.size()});
+	mine.push_back(i);
+	if (run == (int) runs.size()) {
+		runs.push_back(0);
+	}
+	runs[run] += price;
+	sum += price;
+	if ((i + 1) % terms.purchaseQuantity == 0 && run < maxGroups()) {
+		grouped += runs[run];
+		++groups;
+	}
+	return value() - before;
+}
+
+int MixPool::remove(int line, vector<vector<int>>& positions) {
+	//removes the line's most recently scanned unit, which must exist, and
+	//returns the change to the pool's value
+	int before = value();
+	vector<int>& mine = positions[line];
+	int i = mine.back();
+	mine.pop_back();
+	int last = units.size() - 1;
+	int lastRun = last / terms.purchaseQuantity;
+	bool lastGrouped = lastRun < groups; //the last run is complete and discounted
+	int price = units[i].price;
+	sum -= price;
+	if (i != last) {
+		//the last unit takes the removed one's position, and it is the last
+		//position that empties
+		Unit moved = units[last];
+		units[i] = moved;
+		positions[moved.line][moved.slot] = i;
+		int run = i / terms.purchaseQuantity;
+		runs[run] += moved.price - price;
+		grouped += run < groups ? moved.price - price : 0;
+		price = moved.price;
+	}
+	runs[lastRun] -= price;
+	grouped -= lastGrouped ? price : 0;
+	units.pop_back();
+	if (lastGrouped) {
+		//the last run is one short now, so its units pay their own prices
+		--groups;
+		grouped -= runs[lastRun];
+	}
+	if (units.size() % terms.purchaseQuantity == 0) {
+		runs.pop_back();
+	}
+	return value() - before;
+}
@@ -0,0 +1,83 @@
+#ifndef _MIX_H_
+#define _MIX_H_
+
+#include "special.h"
+
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+//the units of a basket under one mix and match special. units hold
+//positions 0, 1, 2... in the order they were scanned, and each run of
+//purchaseQuantity positions, once complete and within the special's limit,
+//sells for discountPrice; the units past the last complete run pay their
+//own prices. removing a unit of a line takes that line's most recently
+//scanned unit, and the pool's last unit moves into its position, so a run
+//it leaves keeps its discount if another unit is waiting to fill it
+//
+//a running price sum per run makes every scan and removal O(1), however
+//many units and products share the pool. the caller keeps, per basket line,
+//the positions of that line's units (in the line's scan order) and passes
+//them to add and remove, which keep them up to date. what the pool adds to
+//a basket is split over its units by charges, for each line's share
+class MixPool {
+public:
+	struct Unit {
+		int line;
+		int price;
+		int slot; //index of this unit's position in its line's list
+	};
+private:
+	SpecialTerms terms;
+	vector<Unit> units; //by position
+	vector<int> runs; //sum of the unit prices in each run of positions
+	long long sum = 0; //of every unit's price
+	long long grouped = 0; //of the prices of units in discounted runs
+	int groups = 0; //complete runs sold at discountPrice, always the first ones
+	bool active = false; //for the owner's bookkeeping, untouched by clear
+	uint32_t generation = 0; //likewise, which special the terms came from
+
+	inline int maxGroups() const { return terms.limit == 0 ? 0x7fffffff : terms.limit / terms.purchaseQuantity; }
+public:
+	inline void setTerms(const SpecialTerms& t) { terms = t; }
+	inline const SpecialTerms& getTerms() const { return terms; }
+	inline int size() const { return units.size(); }
+	inline const Unit& unit(int i) const { return units[i]; }
+	inline void setSlot(int i, int slot) { units[i].slot = slot; } //for restoring a pool, with the caller's positions
+	inline int getGroups() const { return groups; }
+	inline bool getActive() const { return active; }
+	inline void setActive(bool a) { active = a; }
+	inline uint32_t getGeneration() const { return generation; }
+	inline void setGeneration(uint32_t g) { generation = g; }
+	//what the pool's units add to a basket's total
+	inline int value() const { return (int) (groups * (long long) terms.discountPrice + sum - grouped); }
+	template <typename F> void charges(int, F) const;
+	void clear();
+	int add(int, int, vector<vector<int>>&);
+	int remove(int, vector<vector<int>>&);
+};
+
+template <typename F> void MixPool::charges(int run, F f) const {
+	//calls f(line, price, charge) for each unit of a run of positions: a
+	//discounted run's price is split over its units in proportion to their
+	//prices, rounding so the shares sum to it, others pay their own prices
+	int first = run * terms.purchaseQuantity;
+	int end = first + terms.purchaseQuantity < (int) units.size() ? first + terms.purchaseQuantity : units.size();
+	if (run >= groups) {
+		for (int i = first; i < end; ++i) {
+			f(units[i].line, units[i].price, units[i].price);
+		}
+		return;
+	}
+	long long upTo = 0; //prices of the run so far
+	int shared = 0;
+	for (int i = first; i < end; ++i) {
+		upTo += runs[run] != 0 ? units[i].price : 1;
+		int share = (int) (terms.discountPrice * upTo / (runs[run] != 0 ? runs[run] : terms.purchaseQuantity));
+		f(units[i].line, units[i].price, share - shared);
+		shared = share;
+	}
+}
+
+#endif
@@ -0,0 +1,656 @@
+#include "optimizer.h"
+#include "pricing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <queue>
+#include <utility>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NO_COST = INT_MAX / 2;
+const int CLOCK_EVERY = 32; //states searched between deadline checks
+const long GREEDY_FIRST = 4096; //search work past which a set's greedy price is found before
+	//searching it; below, a search takes about as long as the greedy price would
+
+//a group special within one connected set: its terms and where its digit
+//sits in the packed dynamic program state
+struct Group {
+	const SpecialTerms* terms;
+	int runs; //most runs its limit allows, -1 if unlimited
+	int size; //states of its digit: units towards the next run, times runs used if limited
+	int first; //the set's first and last items in it
+	int last;
+	int stride;
+};
+
+struct Item {
+	const vector<int>* cost;
+	int quantity;
+	vector<int> groups; //indexes into the set's groups
+};
+
+//a connected set priced with every group taking greedy runs, worked out
+//before any search so that a search cut short by the deadline costs
+//nothing more to fall back from
+struct Greedy {
+	int total;
+	int lower; //a price the best can't be below
+	vector<int> saved; //by group, what its runs saved
+	vector<vector<int>> members; //by group, its items
+	vector<int> left; //scratch, kept across sets
+	vector<bool> all;
+};
+
+uint64_t mixHash(uint64_t h, uint64_t v) {
+	//FNV-1a over the 8 bytes of v
+	for (int i = 0; i < 8; ++i, v >>= 8) {
+		h = (h ^ (v & 0xff)) * 1099511628211ULL;
+	}
+	return h;
+}
+
+void expand(const vector<Group>& groups, const Item& item, size_t g, int state, int cost, int left,
+		int base, vector<int>& next) {
+	//tries every split of the item's units over its groups from the g-th on,
+	//the rest priced by its item specials
+	if (g == item.groups.size()) {
+		int c = base + cost + (*item.cost)[left];
+		if (c < next[state]) {
+			next[state] = c;
+		}
+		return;
+	}
+	const Group& group = groups[item.groups[g]];
+	int n = group.terms->purchaseQuantity;
+	int digit = state / group.stride % group.size;
+	int toward = digit % n;
+	int used = digit / n;
+	int rest = state - digit * group.stride;
+	for (int k = 0; k <= left; ++k) {
+		int runs = (toward + k) / n;
+		if (group.runs >= 0 && used + runs > group.runs) {
+			break;
+		}
+		int d = (toward + k) % n + (group.runs >= 0 ? (used + runs) * n : 0);
+		expand(groups, item, g + 1, rest + d * group.stride, cost + runs * group.terms->discountPrice,
+			left - k, base, next);
+	}
+}
+
+long searchWork(const vector<Group>& groups, const vector<Item>& items, int budget, const vector<bool>* keep = nullptr) {
+	//how many transitions searchSet would try, or more than budget, over
+	//just the groups marked keep if given
+	long states = 1, work = 0;
+	for (size_t i = 0; i < items.size(); ++i) {
+		long splits = 1;
+		for (int g : items[i].groups) {
+			if (keep && !(*keep)[g]) {
+				continue;
+			}
+			if (groups[g].first == (int) i) {
+				states *= groups[g].size;
+			}
+			splits *= items[i].quantity + 1;
+			if (states > budget || splits > budget) {
+				return budget + 1L;
+			}
+		}
+		work += states * splits;
+		if (work > budget) {
+			return work;
+		}
+		for (int g : items[i].groups) {
+			if ((!keep || (*keep)[g]) && groups[g].last == (int) i) {
+				states /= groups[g].size;
+			}
+		}
+	}
+	return work;
+}
+
+int searchSet(vector<Group>& groups, const vector<Item>& items, Clock::time_point deadline) {
+	//the least cost of a connected set, or -1 if the deadline passes first:
+	//items taken one by one, each state holding the least cost of the items
+	//so far. a group joins the state at its first item and leaves after its
+	//last, going on only from states where it stands at a whole number of
+	//runs, so the state spans just the groups open across the current item
+	vector<int> open, kept;
+	vector<int> stride(groups.size());
+	vector<int> best(1, 0), next;
+	int states = 1;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (Clock::now() >= deadline) {
+			return -1;
+		}
+		for (int g : items[i].groups) {
+			if (groups[g].first == (int) i) {
+				groups[g].stride = states;
+				states *= groups[g].size;
+				open.push_back(g);
+			}
+		}
+		best.resize(states, NO_COST);
+		next.assign(states, NO_COST);
+		for (int s = 0; s < states; ++s) {
+			if (best[s] != NO_COST) {
+				expand(groups, items[i], 0, s, 0, items[i].quantity, best[s], next);
+			}
+			if (s % CLOCK_EVERY == CLOCK_EVERY - 1 && Clock::now() >= deadline) {
+				return -1;
+			}
+		}
+		kept.clear();
+		int left = 1;
+		for (int g : open) {
+			if (groups[g].last != (int) i) {
+				kept.push_back(g);
+				stride[g] = left;
+				left *= groups[g].size;
+			}
+		}
+		if (kept.size() == open.size()) {
+			best.swap(next);
+			continue;
+		}
+		best.assign(left, NO_COST);
+		for (int s = 0; s < states; ++s) {
+			if (next[s] == NO_COST) {
+				continue;
+			}
+			bool whole = true;
+			int to = 0;
+			for (int g : open) {
+				int digit = s / groups[g].stride % groups[g].size;
+				if (groups[g].last == (int) i) {
+					whole = whole && digit % groups[g].terms->purchaseQuantity == 0;
+				} else {
+					to += digit * stride[g];
+				}
+			}
+			if (whole && next[s] < best[to]) {
+				best[to] = next[s];
+			}
+		}
+		for (int g : kept) {
+			groups[g].stride = stride[g];
+		}
+		open.swap(kept);
+		states = left;
+	}
+	return best[0];
+}
+
+int greedyRuns(const vector<Group>& groups, const vector<Item>& items, const vector<vector<int>>& members,
+		const vector<bool>& use, vector<int>& left, vector<int>* savedBy = nullptr) {
+	//a good but not always best use of the groups marked in use: each in
+	//turn, cheapest per unit first, takes runs of the units whose removal
+	//saves most from what their items' specials would charge, while the run
+	//costs less. takes the units from left and returns what the runs cost,
+	//adding what each group's runs saved to savedBy if given
+	auto saving = [&](int i) { return (*items[i].cost)[left[i]] - (*items[i].cost)[left[i] - 1]; };
+	vector<int> order;
+	for (size_t g = 0; g < groups.size(); ++g) {
+		if (use[g]) {
+			order.push_back(g);
+		}
+	}
+	std::stable_sort(order.begin(), order.end(), [&groups](int a, int b) {
+		return (long) groups[a].terms->discountPrice * groups[b].terms->purchaseQuantity
+			< (long) groups[b].terms->discountPrice * groups[a].terms->purchaseQuantity;
+	});
+	int total = 0;
+	vector<int> taken;
+	vector<std::pair<int, int>> units;
+	for (int g : order) {
+		const SpecialTerms& t = *groups[g].terms;
+		units.clear();
+		for (int i : members[g]) {
+			if (left[i] > 0) {
+				units.push_back(std::make_pair(saving(i), i));
+			}
+		}
+		//saving of an item's next unit, item
+		std::priority_queue<std::pair<int, int>> dearest(std::less<std::pair<int, int>>(), std::move(units));
+		for (int run = 0; groups[g].runs < 0 || run < groups[g].runs; ++run) {
+			taken.clear();
+			int saved = 0;
+			while ((int) taken.size() < t.purchaseQuantity && !dearest.empty()) {
+				int i = dearest.top().second;
+				saved += dearest.top().first;
+				dearest.pop();
+				--left[i];
+				taken.push_back(i);
+				if (left[i] > 0) {
+					dearest.push(std::make_pair(saving(i), i));
+				}
+			}
+			if ((int) taken.size() < t.purchaseQuantity || saved <= t.discountPrice) {
+				for (int i : taken) {
+					++left[i];
+				}
+				break;
+			}
+			total += t.discountPrice;
+			if (savedBy) {
+				(*savedBy)[g] += saved - t.discountPrice;
+			}
+		}
+	}
+	return total;
+}
+
+void restrict(const vector<Group>& groups, const vector<Item>& items, const vector<bool>& keep,
+		const vector<int>& quantity, vector<Group>& kept, vector<Item>& out) {
+	//the set with only the groups marked keep, its items holding quantity units
+	vector<int> local(groups.size(), -1);
+	kept.clear();
+	for (size_t g = 0; g < groups.size(); ++g) {
+		if (keep[g]) {
+			local[g] = kept.size();
+			kept.push_back(groups[g]);
+			kept.back().first = -1;
+		}
+	}
+	out.resize(items.size());
+	for (size_t i = 0; i < items.size(); ++i) {
+		out[i].cost = items[i].cost;
+		out[i].quantity = quantity[i];
+		out[i].groups.clear();
+		for (int g : items[i].groups) {
+			if (local[g] >= 0) {
+				Group& group = kept[local[g]];
+				group.first = group.first < 0 ? (int) i : group.first;
+				group.last = i;
+				out[i].groups.push_back(local[g]);
+			}
+		}
+	}
+}
+
+void relax(const vector<Group>& groups, const Item& item, const vector<bool>& among, vector<int>& cost) {
+	//the item's costs with its units also free to join any group marked
+	//among at that group's price per unit, no runs to fill and no limit:
+	//never more than a real use of those groups could cost
+	int perUnit = NO_COST;
+	for (int g : item.groups) {
+		if (among[g]) {
+			perUnit = std::min(perUnit, groups[g].terms->discountPrice / groups[g].terms->purchaseQuantity);
+		}
+	}
+	cost.assign(item.cost->begin(), item.cost->begin() + item.quantity + 1);
+	if (perUnit == NO_COST) {
+		return;
+	}
+	for (int k = 1; k <= item.quantity; ++k) {
+		for (int j = 1; j <= k; ++j) {
+			cost[k] = std::min(cost[k], (*item.cost)[k - j] + j * perUnit);
+		}
+	}
+}
+
+int relaxedCost(const vector<Group>& groups, const Item& item, const vector<bool>& among) {
+	//what relax gives for all of the item's units, without the costs of
+	//fewer, so in time linear in the quantity
+	int perUnit = NO_COST;
+	for (int g : item.groups) {
+		if (among[g]) {
+			perUnit = std::min(perUnit, groups[g].terms->discountPrice / groups[g].terms->purchaseQuantity);
+		}
+	}
+	int q = item.quantity;
+	int cost = (*item.cost)[q];
+	for (int j = 1; perUnit != NO_COST && j <= q; ++j) {
+		cost = std::min(cost, (*item.cost)[q - j] + j * perUnit);
+	}
+	return cost;
+}
+
+void greedySet(const vector<Group>& groups, const vector<Item>& items, Greedy& out) {
+	//every group of the set run greedily, and the relaxed price of all of
+	//them as a bound
+	out.members.resize(groups.size());
+	for (vector<int>& m : out.members) {
+		m.clear();
+	}
+	out.left.resize(items.size());
+	for (size_t i = 0; i < items.size(); ++i) {
+		out.left[i] = items[i].quantity;
+		for (int g : items[i].groups) {
+			out.members[g].push_back(i);
+		}
+	}
+	out.all.assign(groups.size(), true);
+	out.saved.assign(groups.size(), 0);
+	out.total = greedyRuns(groups, items, out.members, out.all, out.left, &out.saved);
+	out.lower = 0;
+	for (size_t i = 0; i < items.size(); ++i) {
+		out.total += (*items[i].cost)[out.left[i]];
+		out.lower += relaxedCost(groups, items[i], out.all);
+	}
+}
+
+int boundedSet(const vector<Group>& groups, const vector<Item>& items, int budget, Clock::time_point deadline,
+		const Greedy& greedy, int& bound, bool& cut) {
+	//prices a set too tangled to search whole, starting from its greedy
+	//price. the groups that saved most are searched exactly, as many as the
+	//budget allows, over the units left after the rest take greedy runs,
+	//and the cheaper of that and the greedy price is kept. the same search
+	//with the rest relaxed as in relax gives a price the best can't be
+	//below, and bound is set to the gap between the two. cut is set if the
+	//deadline stopped either search; skipping the second because it wouldn't
+	//finish in time leaves the price as it is, so it doesn't count
+	const vector<vector<int>>& members = greedy.members;
+	const vector<int>& saved = greedy.saved;
+	vector<int> quantity(items.size()), left;
+	for (size_t i = 0; i < items.size(); ++i) {
+		quantity[i] = items[i].quantity;
+	}
+	vector<int> order(groups.size());
+	for (size_t g = 0; g < groups.size(); ++g) {
+		order[g] = g;
+	}
+	vector<bool> keep(groups.size(), false), rest(groups.size(), true);
+	int best = greedy.total;
+	int lower = greedy.lower;
+	vector<vector<int>> relaxed(items.size());
+
+	std::stable_sort(order.begin(), order.end(), [&saved](int a, int b) { return saved[a] > saved[b]; });
+	bool any = false;
+	for (int g : order) {
+		keep[g] = saved[g] > 0;
+		if (!keep[g] || searchWork(groups, items, budget, &keep) > budget) {
+			keep[g] = false;
+			break;
+		}
+		rest[g] = false;
+		any = true;
+	}
+	vector<Group> kept;
+	vector<Item> part;
+	Clock::duration perStep = Clock::duration::max();
+	cut = any && Clock::now() >= deadline;
+	if (any && !cut) {
+		left = quantity;
+		int runs = greedyRuns(groups, items, members, rest, left);
+		restrict(groups, items, keep, left, kept, part);
+		Clock::time_point start = Clock::now();
+		int mixed = searchSet(kept, part, deadline);
+		if (mixed >= 0) {
+			best = std::min(best, runs + mixed);
+			perStep = (Clock::now() - start) / std::max(1L, searchWork(kept, part, budget));
+		}
+		cut = mixed < 0;
+	}
+	if (perStep != Clock::duration::max()) {
+		//only if it should finish in time, judged by the first search's pace,
+		//since a search cut short bounds nothing
+		restrict(groups, items, keep, quantity, kept, part);
+		if (Clock::now() + perStep * searchWork(kept, part, budget) < deadline) {
+			for (size_t i = 0; i < items.size(); ++i) {
+				relax(groups, items[i], rest, relaxed[i]);
+				part[i].cost = &relaxed[i];
+			}
+			int relaxedBest = searchSet(kept, part, deadline);
+			lower = std::max(lower, relaxedBest);
+			cut = relaxedBest < 0;
+		}
+	}
+	bound = best - lower;
+	return best;
+}
+
+}
+
+BasketOptimizer::BasketOptimizer(int b, int t) : budget(b), timeLimit(t) {
+}
+
+int BasketOptimizer::addPromotion(const Promotion& p) {
+	//returns the promotion's index, or -1 if its terms can never apply
+	if ((p.terms.kind != SPECIAL_BOGO && p.terms.kind != SPECIAL_BULK && p.terms.kind != SPECIAL_MIX)
+			|| p.terms.purchaseQuantity <= 0 || p.handles.empty()) {
+		return -1;
+	}
+	int i = promotions.size();
+	promotions.push_back(p);
+	for (int h : p.handles) {
+		promotionsOf[h].push_back(i);
+	}
+	clear();
+	return i;
+}
+
+void BasketOptimizer::clear() {
+	//forgets memoized costs and results
+	items.clear();
+	results.clear();
+}
+
+const vector<int>& BasketOptimizer::itemCosts(const Catalog& c, int h, int q, uint32_t version, int rounding) {
+	//the least cost of 0 to q units of product h under its item specials
+	//alone, each special covering a chunk of units of its own. kept and
+	//extended as the product's quantity grows until its row changes
+	ItemCosts& item = items[h];
+	if (item.version == version && item.rounding == rounding && (int) item.cost.size() > q) {
+		return item.cost;
+	}
+	SpecialTerms terms;
+	PriceRow row = c.getRow(h, nullptr, &terms);
+	int price = row.price - row.markdown;
+	specials.clear();
+	if (row.special >= 0 && terms.kind != SPECIAL_MIX) {
+		specials.push_back(terms);
+	}
+	unordered_map<int, vector<int>>::const_iterator found = promotionsOf.find(h);
+	if (found != promotionsOf.end()) {
+		for (int i : found->second) {
+			if (promotions[i].terms.kind != SPECIAL_MIX) {
+				specials.push_back(promotions[i].terms);
+			}
+		}
+	}
+	item.version = version;
+	item.rounding = rounding;
+	item.cost.resize(q + 1);
+	for (int k = 0; k <= q; ++k) {
+		item.cost[k] = price * k;
+	}
+	chunk.resize(q + 1);
+	for (const SpecialTerms& t : specials) {
+		for (int k = 1; k <= q; ++k) {
+			chunk[k] = linePrice(price, false, k, &t, rounding);
+		}
+		//from the top down, so each k still sees the costs without this special
+		for (int k = q; k > 0; --k) {
+			for (int j = 1; j <= k; ++j) {
+				if (item.cost[k - j] + chunk[j] < item.cost[k]) {
+					item.cost[k] = item.cost[k - j] + chunk[j];
+				}
+			}
+		}
+	}
+	return item.cost;
+}
+
+bool BasketOptimizer::optimize(const Register& reg, OptimizedBasket& out) {
+	//prices the register's basket as cheaply as its specials and the
+	//promotions allow; false if the register has no inventory
+	Clock::time_point deadline = timeLimit == NO_TIME_LIMIT ? Clock::time_point::max()
+		: Clock::now() + std::chrono::microseconds(timeLimit);
+	const Catalog* c = reg.getCatalog();
+	if (!c) {
+		return false;
+	}
+	int rounding = reg.getRounding();
+	vector<Line> lines;
+	lines.reserve(reg.getLineCount());
+	for (int i = 0; i < reg.getLineCount(); ++i) {
+		LineItem item = reg.getLineItem(i);
+		if (item.quantity > 0) {
+			Line l;
+			l.handle = item.handle;
+			l.quantity = item.quantity;
+			c->getRow(item.handle, &l.version);
+			lines.push_back(l);
+		}
+	}
+	std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.handle < b.handle; });
+	uint64_t signature = mixHash(14695981039346656037ULL, rounding);
+	for (const Line& l : lines) {
+		signature = mixHash(mixHash(mixHash(signature, l.handle), l.quantity), l.version);
+	}
+	unordered_map<uint64_t, Result>::iterator memo = results.find(signature);
+	if (memo != results.end() && memo->second.rounding == rounding && memo->second.lines == lines
+			&& !memo->second.retry) {
+		++hits;
+		out = memo->second.basket;
+		out.cached = true;
+		return true;
+	}
+	++misses;
+
+	OptimizedBasket basket;
+	//group specials are keyed by catalog special index, or by -1 less the
+	//promotion index; each line joins the groups it may count towards
+	unordered_map<int, int> groupIndex;
+	vector<SpecialTerms> groupTerms;
+	vector<vector<int>> groupsOf(lines.size());
+	vector<bool> weighed(lines.size());
+	auto addGroup = [&](size_t i, int key, const SpecialTerms& terms) {
+		std::pair<unordered_map<int, int>::iterator, bool> added = groupIndex.insert(std::make_pair(key, (int) groupTerms.size()));
+		if (added.second) {
+			groupTerms.push_back(terms);
+		}
+		groupsOf[i].push_back(added.first->second);
+	};
+	for (size_t i = 0; i < lines.size(); ++i) {
+		SpecialTerms terms;
+		PriceRow row = c->getRow(lines[i].handle, nullptr, &terms);
+		int price = row.price - row.markdown;
+		const SpecialTerms* special = row.special >= 0 ? &terms : nullptr;
+		if (row.byWeight) {
+			basket.regular += linePrice(price, true, lines[i].quantity, nullptr, rounding);
+			basket.total += linePrice(price, true, lines[i].quantity, special, rounding);
+			weighed[i] = true;
+			continue;
+		}
+		basket.regular += price * lines[i].quantity;
+		if (special && special->kind == SPECIAL_MIX && special->purchaseQuantity > 0) {
+			addGroup(i, row.special, terms);
+		}
+		unordered_map<int, vector<int>>::const_iterator found = promotionsOf.find(lines[i].handle);
+		if (found != promotionsOf.end()) {
+			for (int p : found->second) {
+				if (promotions[p].terms.kind == SPECIAL_MIX) {
+					addGroup(i, -1 - p, promotions[p].terms);
+				}
+			}
+		}
+	}
+
+	//connected sets of groups, joined by the lines they share
+	vector<int> parent(groupTerms.size());
+	for (size_t g = 0; g < parent.size(); ++g) {
+		parent[g] = g;
+	}
+	auto root = [&parent](int g) {
+		while (parent[g] != g) {
+			g = parent[g] = parent[parent[g]];
+		}
+		return g;
+	};
+	for (size_t i = 0; i < lines.size(); ++i) {
+		for (size_t j = 1; j < groupsOf[i].size(); ++j) {
+			parent[root(groupsOf[i][j])] = root(groupsOf[i][0]);
+		}
+	}
+	vector<vector<int>> members(groupTerms.size()), setGroups(groupTerms.size()); //by root
+	for (size_t g = 0; g < groupTerms.size(); ++g) {
+		setGroups[root(g)].push_back(g);
+	}
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (weighed[i]) {
+			continue;
+		}
+		const vector<int>& cost = itemCosts(*c, lines[i].handle, lines[i].quantity, lines[i].version, rounding);
+		if (groupsOf[i].empty()) {
+			basket.total += cost[lines[i].quantity];
+		} else {
+			members[root(groupsOf[i][0])].push_back(i);
+		}
+	}
+
+	vector<int> local(groupTerms.size());
+	vector<Group> groups;
+	vector<Item> set;
+	Greedy greedy;
+	bool cut = false; //some set was priced short of what the budget allows, for want of time
+	for (size_t r = 0; r < members.size(); ++r) {
+		if (members[r].empty()) {
+			continue;
+		}
+		groups.clear();
+		for (int g : setGroups[r]) {
+			local[g] = groups.size();
+			const SpecialTerms* t = &groupTerms[g];
+			Group group;
+			group.terms = t;
+			group.runs = t->limit > 0 ? t->limit / t->purchaseQuantity : -1;
+			group.size = t->purchaseQuantity * (group.runs >= 0 ? group.runs + 1 : 1);
+			group.first = -1;
+			groups.push_back(group);
+		}
+		set.clear();
+		for (int i : members[r]) {
+			Item item;
+			item.cost = &items[lines[i].handle].cost;
+			item.quantity = lines[i].quantity;
+			for (int g : groupsOf[i]) {
+				Group& group = groups[local[g]];
+				group.first = group.first < 0 ? (int) set.size() : group.first;
+				group.last = set.size();
+				item.groups.push_back(local[g]);
+			}
+			set.push_back(item);
+		}
+		long work = searchWork(groups, set, budget);
+		bool whole = work <= budget;
+		if (work > GREEDY_FIRST) {
+			greedySet(groups, set, greedy);
+		}
+		int cost = whole ? searchSet(groups, set, deadline) : -1;
+		if (cost >= 0) {
+			basket.total += cost;
+			continue;
+		}
+		if (work <= GREEDY_FIRST) {
+			greedySet(groups, set, greedy);
+		}
+		//a whole search can only have run out of time, and then the greedy
+		//price is all there is time for
+		int bound = greedy.total - greedy.lower;
+		bool setCut = whole;
+		basket.total += whole ? greedy.total : boundedSet(groups, set, budget / 8, deadline, greedy, bound, setCut);
+		if (Clock::now() >= deadline) {
+			++timedOut;
+		}
+		cut = cut || setCut;
+		basket.bound += bound;
+		basket.optimal = false;
+		++bounded;
+	}
+
+	if (results.size() >= MAX_RESULTS) {
+		results.clear();
+	}
+	Result& kept = results[signature];
+	kept.lines.swap(lines);
+	kept.rounding = rounding;
+	kept.basket = basket;
+	kept.retry = cut;
+	out = basket;
+	return true;
+}
@@ -0,0 +1,103 @@
+#ifndef _OPTIMIZER_H_
+#define _OPTIMIZER_H_
+
+#include "register.h"
+#include "special.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using std::unordered_map;
+using std::vector;
+
+//a promotion offered alongside the catalog's specials: BOGO and BULK terms
+//apply to each listed product on its own, MIX terms to all of them together
+struct Promotion {
+	SpecialTerms terms;
+	vector<int> handles;
+};
+
+//the best price found for a basket
+struct OptimizedBasket {
+	int total = 0; //in cents
+	int regular = 0; //every unit at its own price less markdown, no specials
+	bool optimal = true; //false if part of the basket wasn't searched whole, to stay within the budgets
+	int bound = 0; //most cents total may be above the best price, 0 if optimal
+	bool cached = false; //the same basket was optimized before
+	inline int getSavings() const { return regular - total; }
+};
+
+//finds the cheapest way to apply every special a basket's products
+//qualify for: each product's catalog special plus any promotions added
+//here. each unit goes to at most one special, and a special may be left
+//unused where it costs more than it saves. weighed products are priced as
+//the register prices them
+//
+//a product's item specials (BOGO, BULK) are combined by a dynamic program
+//over its quantity, memoized by product and row version so rescanning
+//after every item reuses it. group specials (MIX) link products; each
+//connected set of them is solved by a dynamic program over the products
+//whose state is, per group open across the current product, the units
+//committed towards its next run and the runs used against its limit, so
+//chains of overlapping groups stay cheap. whole results are memoized by
+//basket signature
+//
+//a connected set whose search would take more than the work budget, or
+//runs past the time limit from the start of optimize, is priced by an exact
+//search over just the groups that can save most, with the rest taking
+//greedy runs, or greedily throughout if that is cheaper or time is up. the
+//greedy price is worked out before any search, so a search stopped by the
+//time limit falls back to it at once. the result is marked not optimal and
+//its bound says how far above the best price it may be, so every basket is
+//priced in about the time limit. a result the time limit cut short isn't
+//reused, so a later call with more time to spare can do better
+class BasketOptimizer {
+private:
+	struct ItemCosts {
+		uint32_t version = 0;
+		int rounding = -1;
+		vector<int> cost; //cost[k] is the least k units cost under item specials alone
+	};
+	struct Line {
+		int handle;
+		int quantity;
+		uint32_t version;
+		bool operator==(const Line& o) const { return handle == o.handle && quantity == o.quantity && version == o.version; }
+	};
+	struct Result {
+		vector<Line> lines;
+		int rounding;
+		OptimizedBasket basket;
+		bool retry; //the time limit cut it short, so the next call prices the basket again
+	};
+
+	vector<Promotion> promotions;
+	unordered_map<int, vector<int>> promotionsOf; //by handle, indexes into promotions
+	unordered_map<int, ItemCosts> items; //by handle
+	unordered_map<uint64_t, Result> results; //by basket signature
+	vector<SpecialTerms> specials; //scratch for itemCosts
+	vector<int> chunk;
+	int budget; //most transitions to search one connected set
+	int timeLimit; //in microseconds from the start of optimize
+	long hits = 0;
+	long misses = 0;
+	long bounded = 0;
+	long timedOut = 0;
+
+	const vector<int>& itemCosts(const Catalog&, int, int, uint32_t, int);
+public:
+	static const size_t MAX_RESULTS = 4096;
+	static const int DEFAULT_BUDGET = 400000;
+	static const int NO_TIME_LIMIT = 0;
+	BasketOptimizer(int = DEFAULT_BUDGET, int = 1000);
+	int addPromotion(const Promotion&);
+	bool optimize(const Register&, OptimizedBasket&);
+	void clear();
+	inline long getHits() const { return hits; }
+	inline long getMisses() const { return misses; }
+	inline long getBounded() const { return bounded; } //connected sets not searched whole
+	inline long getTimedOut() const { return timedOut; } //of those, the ones priced past the time limit
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "pool.h"
+
+RegisterPool::RegisterPool(shared_ptr<Inventory> inv, int count, int lines) : registers(count) {
+	//each register is sized for baskets of up to lines distinct products
+	available.reserve(count);
+	for (Register& r : registers) {
+		r.assignInventory(inv);
+		r.reserve(lines);
+		available.push_back(&r);
+	}
+}
+
+Register* RegisterPool::acquire() {
+	//returns an empty register, or nullptr if every one is in use
+	std::lock_guard<std::mutex> guard(lock);
+	if (available.empty()) {
+		return nullptr;
+	}
+	Register* r = available.back();
+	available.pop_back();
+	return r;
+}
+
+void RegisterPool::release(Register* r) {
+	//takes back a register from acquire, clearing its basket
+	r->reset();
+	std::lock_guard<std::mutex> guard(lock);
+	available.push_back(r);
+}
+
+int RegisterPool::getAvailable() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return available.size();
+}
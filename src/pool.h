@@ -0,0 +1,32 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include "inventory.h"
+#include "register.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+
+//a fixed set of registers on one inventory, warmed up front for its
+//current catalog so lanes can take a register for a basket and hand it
+//back without allocating
+class RegisterPool {
+private:
+	vector<Register> registers;
+	vector<Register*> available;
+	mutable std::mutex lock;
+public:
+	RegisterPool(shared_ptr<Inventory>, int, int = 256);
+	RegisterPool(const RegisterPool&) = delete;
+	RegisterPool& operator=(const RegisterPool&) = delete;
+	Register* acquire();
+	void release(Register*);
+	inline int size() const { return registers.size(); }
+	int getAvailable() const;
+};
+
+#endif
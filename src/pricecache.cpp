@@ -0,0 +1,26 @@
+#include "pricecache.h"
+
+PriceCache::PriceCache(int n) {
+	resize(n);
+}
+
+void PriceCache::resize(int n) {
+	//holds at least n entries, rounded up to a power of two; 0 disables the cache
+	size_t count = 0;
+	if (n > 0) {
+		count = 16;
+		while (count < (size_t) n) {
+			count *= 2;
+		}
+	}
+	entries.assign(count, Entry{-1, 0, 0, 0});
+	mask = count ? count - 1 : 0;
+	resetCounters();
+}
+
+void PriceCache::clear() {
+	//forgets every entry, keeping the counters
+	for (Entry& e : entries) {
+		e.handle = -1;
+	}
+}
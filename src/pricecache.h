@@ -0,0 +1,65 @@
+#ifndef _PRICECACHE_H_
+#define _PRICECACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+//remembers what one more unit of a product adds to a basket line, keyed on
+//the product's handle, its catalog row version and the unit's position in
+//its special's cycle (see unitPosition). a change to the product's price,
+//markdown or special advances its row version, so stale entries simply stop
+//matching; a special's terms are fixed once an inventory prices with it, so
+//new terms always come as a new special. snapshots copy row versions, so
+//the same holds across published versions. direct mapped: a colliding entry
+//replaces the one before it
+class PriceCache {
+private:
+	struct Entry {
+		int32_t handle; //-1 if empty
+		uint32_t version;
+		int32_t position;
+		int32_t price;
+	};
+	vector<Entry> entries;
+	size_t mask = 0;
+	long long hits = 0;
+	long long misses = 0;
+
+	inline size_t slotOf(int h, int pos) const { return ((unsigned) h * 2654435761u + (unsigned) pos * 40503u) & mask; }
+public:
+	PriceCache(int = 0);
+	void resize(int);
+	void clear();
+	inline bool enabled() const { return !entries.empty(); }
+	inline int size() const { return entries.size(); }
+	inline bool get(int, uint32_t, int, int&);
+	inline void put(int, uint32_t, int, int);
+	inline long long getHits() const { return hits; }
+	inline long long getMisses() const { return misses; }
+	inline double getHitRate() const { return hits + misses ? (double) hits / (hits + misses) : 0; }
+	inline void resetCounters() { hits = 0; misses = 0; }
+};
+
+bool PriceCache::get(int h, uint32_t v, int pos, int& price) {
+	const Entry& e = entries[slotOf(h, pos)];
+	if (e.handle == h && e.version == v && e.position == pos) {
+		++hits;
+		price = e.price;
+		return true;
+	}
+	++misses;
+	return false;
+}
+
+void PriceCache::put(int h, uint32_t v, int pos, int price) {
+	Entry& e = entries[slotOf(h, pos)];
+	e.handle = h;
+	e.version = v;
+	e.position = pos;
+	e.price = price;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include "pricing.h"
+
+namespace {
+
+int weightPrice(int p, int q, const SpecialTerms* t, int rounding) {
+	if (!t) {
+		return (int) roundHundredths((long long) p * q, rounding);
+	}
+	//every special on a weighed product is read as buy purchaseQuantity,
+	//get discountQuantity at discountPercentage off, in hundredths of a pound
+	int discounted = discountedUnits(specialQuantity(q, *t), *t);
+	long long cost = (long long) p * (q - discounted) + (long long) discountedPrice(p, *t, rounding) * discounted;
+	return (int) roundHundredths(cost, rounding);
+}
+
+}
+
+int linePrice(int p, bool byWeight, int q, const SpecialTerms* t, int rounding) {
+	if (q <= 0) {
+		return 0;
+	}
+	if (t && (t->kind == SPECIAL_NONE || t->kind == SPECIAL_MIX || t->purchaseQuantity <= 0)) {
+		t = nullptr;
+	}
+	if (byWeight) {
+		return weightPrice(p, q, t, rounding);
+	}
+	if (!t) {
+		return PricingKernel<SPECIAL_NONE>::units(p, q, SpecialTerms(), rounding);
+	}
+	if (t->kind == SPECIAL_BOGO) {
+		return PricingKernel<SPECIAL_BOGO>::units(p, q, *t, rounding);
+	}
+	return PricingKernel<SPECIAL_BULK>::units(p, q, *t, rounding);
+}
@@ -0,0 +1,88 @@
+#ifndef _PRICING_H_
+#define _PRICING_H_
+
+#include "special.h"
+
+//how fractions of a cent are rounded, at the two points pricing rounds: a
+//percentage discount off a price, and a price per pound times a weight
+const int ROUND_HALF_UP = 0;
+const int ROUND_HALF_EVEN = 1; //banker's rounding
+
+//prices a whole line of a basket in one step rather than unit by unit:
+//returns the cost in cents of quantity q of a product selling at p cents,
+//where q counts units, or hundredths of a pound if byWeight and p is then
+//per pound. the special, if any, applies to the first limit units or
+//hundredths of a pound (all of them if limit is 0). a mix and match special
+//spans lines, so it is priced by the register's MixPool and ignored here.
+//all arithmetic is in integer cents times hundredths
+int linePrice(int p, bool byWeight, int q, const SpecialTerms*, int = ROUND_HALF_UP);
+
+inline long long roundHundredths(long long x, int rounding) {
+	//x / 100 for non-negative x, rounded by the policy; an exact half
+	//rounded up to an odd result is taken back down for banker's rounding
+	long long q = (x + 50) / 100;
+	if (rounding == ROUND_HALF_EVEN && x % 100 == 50 && q % 2 == 1) {
+		--q;
+	}
+	return q;
+}
+
+inline int specialQuantity(int q, const SpecialTerms& t) {
+	//how much of quantity q the special covers
+	return t.limit != 0 && t.limit < q ? t.limit : q;
+}
+
+inline int discountedUnits(int q, const SpecialTerms& t) {
+	//how many of the first q units fall in the discounted part of a cycle of
+	//purchaseQuantity full price units followed by discountQuantity discounted ones
+	int cycle = t.purchaseQuantity + t.discountQuantity;
+	int rest = q % cycle - t.purchaseQuantity;
+	return q / cycle * t.discountQuantity + (rest > 0 ? rest : 0);
+}
+
+inline int discountedPrice(int p, const SpecialTerms& t, int rounding) {
+	//p less discountPercentage, rounded to a whole cent
+	return (int) roundHundredths((long long) p * (100 - t.discountPercentage), rounding);
+}
+
+inline int unitPosition(int q, const SpecialTerms* t) {
+	//where the unit after the first q falls in its special's cycle. what one
+	//unit adds to a line depends only on this, the price and the special:
+	//0 with no special, the cycle length once past the special's limit
+	if (!t || t->kind == SPECIAL_NONE || t->kind == SPECIAL_MIX || t->purchaseQuantity <= 0) {
+		return 0;
+	}
+	int cycle = t->kind == SPECIAL_BOGO ? t->purchaseQuantity + t->discountQuantity : t->purchaseQuantity;
+	if (t->limit != 0 && q >= t->limit) {
+		return cycle;
+	}
+	return q % cycle;
+}
+
+//the pricing kernel for units of a product with a special of the given
+//kind; linePrice picks one by the special's kind tag, so pricing a line
+//takes no virtual calls and no string compares
+template <int Kind>
+struct PricingKernel {
+	static inline int units(int p, int q, const SpecialTerms&, int) {
+		return p * q;
+	}
+};
+
+template <>
+struct PricingKernel<SPECIAL_BOGO> {
+	static inline int units(int p, int q, const SpecialTerms& t, int rounding) {
+		return p * q - (p - discountedPrice(p, t, rounding)) * discountedUnits(specialQuantity(q, t), t);
+	}
+};
+
+template <>
+struct PricingKernel<SPECIAL_BULK> {
+	static inline int units(int p, int q, const SpecialTerms& t, int) {
+		//each complete group of purchaseQuantity sells for discountPrice
+		int groups = specialQuantity(q, t) / t.purchaseQuantity;
+		return p * q + (t.discountPrice - p * t.purchaseQuantity) * groups;
+	}
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "product.h"
+#include "inventory.h"
 
 Product::Product(string n, int p) {
 	name = n;
@@ -11,10 +12,53 @@ Product::Product(string n, int p, bool w) {
 	byWeight = w;
 }
 
+Product::Product(const Product& o) {
+	//a copy is a new product which no inventory holds yet
+	name = o.name;
+	price = o.price;
+	byWeight = o.byWeight;
+	markdown = o.markdown;
+	special = o.special;
+}
+
+Product& Product::operator=(const Product& o) {
+	name = o.name;
+	price = o.price;
+	byWeight = o.byWeight;
+	markdown = o.markdown;
+	special = o.special;
+	notify();
+	return *this;
+}
+
 bool Product::setMarkdown(int m) {
 	if (m >= price) {
 		return false;
 	}
 	markdown = m;
+	notify();
 	return true;
 }
+
+void Product::attach(Inventory* i, int h) {
+	owners.push_back(pair<Inventory*, int>(i, h));
+}
+
+void Product::detach(Inventory* i) {
+	for (size_t k = 0; k < owners.size(); ++k) {
+		if (owners[k].first == i) {
+			owners.erase(owners.begin() + k);
+			return;
+		}
+	}
+}
+
+void Product::notify(const Inventory* skip) {
+	//keeps the pricing rows of every inventory holding this product current,
+	//except one which is already updating its own row
+	for (const pair<Inventory*, int>& o : owners) {
+		if (o.first != skip) {
+			o.first->refresh(o.second);
+		}
+	}
+}
@@ -3,10 +3,15 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+using std::pair;
 using std::shared_ptr;
 using std::string;
+using std::vector;
 
+class Inventory;
 class Special;
 
 class Product {
@@ -17,19 +22,28 @@ private:
 	bool byWeight = false;
 	int markdown = 0;
 	shared_ptr<Special> special = nullptr;
+	vector<pair<Inventory*, int>> owners; //inventories holding this product, with its handle in each
+
+	void attach(Inventory*, int);
+	void detach(Inventory*);
+	void notify(const Inventory* = nullptr);
+	friend class Inventory;
 public:
 	Product(string, int);
 	Product(string, int, bool);
-	inline string getName() const { return name; }
-	inline void setName(const string& n) { name = n; }
+	Product(const Product&);
+	Product& operator=(const Product&);
+	inline const string& getName() const { return name; }
+	inline void setName(const string& n) { name = n; } //does not rename existing inventory entries
 	inline int getPrice() const { return price; }
-	inline void setPrice(int p) { price = p; }
+	inline void setPrice(int p) { price = p; notify(); }
 	inline bool getByWeight() const { return byWeight; }
-	inline void setByWeight(bool w) { byWeight = w; }
+	inline void setByWeight(bool w) { byWeight = w; notify(); }
 	inline int getMarkdown() const { return markdown; }
 	bool setMarkdown(int);
 	inline shared_ptr<Special> getSpecial() const { return special; }
-	inline void assignSpecial(shared_ptr<Special> s) { special = s; }
+	inline Special* getSpecialPtr() const { return special.get(); } //borrowed, no refcount change
+	inline void assignSpecial(shared_ptr<Special> s) { special = s; notify(); }
 };
 
 #endif
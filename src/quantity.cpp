@@ -0,0 +1,138 @@
+#include "quantity.h"
+
+namespace {
+
+inline size_t slotOf(int h, size_t mask) {
+	return ((unsigned) h * 2654435761u) & mask;
+}
+
+}
+
+int QuantityStore::lookup(int h) const {
+	size_t mask = slots.size() - 1;
+	for (size_t k = slotOf(h, mask); slots[k] != 0; k = (k + 1) & mask) {
+		if (large[slots[k] - 1].handle == h) {
+			return slots[k] - 1;
+		}
+	}
+	return -1;
+}
+
+void QuantityStore::add(int h, int q) {
+	//appends a line for a handle not yet in the basket
+	if (!spilled && count == INLINE_LINES) {
+		spill();
+	}
+	if (!spilled) {
+		small[count++] = Line{h, q};
+		return;
+	}
+	if (count == (int) large.size()) {
+		large.resize(large.size() * 2);
+	}
+	large[count++] = Line{h, q};
+	if ((size_t) count * 2 > slots.size()) {
+		rehash(slots.size() * 2);
+	}
+	else {
+		size_t mask = slots.size() - 1;
+		size_t k = slotOf(h, mask);
+		while (slots[k] != 0) {
+			k = (k + 1) & mask;
+		}
+		slots[k] = count;
+	}
+}
+
+void QuantityStore::spill() {
+	//moves the inline lines to the heap, past the point linear search pays off
+	if (large.size() < (size_t) INLINE_LINES * 4) {
+		large.resize(INLINE_LINES * 4);
+	}
+	for (int i = 0; i < count; ++i) {
+		large[i] = small[i];
+	}
+	spilled = true;
+	rehash(slots.size() > (size_t) INLINE_LINES * 4 ? slots.size() : INLINE_LINES * 4);
+}
+
+void QuantityStore::rehash(size_t n) {
+	slots.assign(n, 0);
+	size_t mask = n - 1;
+	for (int i = 0; i < count; ++i) {
+		size_t k = slotOf(large[i].handle, mask);
+		while (slots[k] != 0) {
+			k = (k + 1) & mask;
+		}
+		slots[k] = i + 1;
+	}
+}
+
+void QuantityStore::clear() {
+	count = 0;
+	spilled = false;
+}
+
+QuantityStore::Line* QuantityStore::assign(int n) {
+	//replaces the lines with n the caller fills in through the pointer
+	//returned, then calls index before any other use
+	clear();
+	if (n > INLINE_LINES) {
+		if (large.size() < (size_t) n) {
+			large.resize(n);
+		}
+		spilled = true;
+	}
+	count = n;
+	return lines();
+}
+
+bool QuantityStore::index() {
+	//indexes lines filled in after assign; false if two share a handle, in
+	//which case the store is cleared
+	bool unique = true;
+	if (!spilled) {
+		for (int i = 1; i < count; ++i) {
+			for (int j = 0; j < i; ++j) {
+				unique &= small[i].handle != small[j].handle;
+			}
+		}
+	}
+	else {
+		size_t n = INLINE_LINES * 4;
+		while (n < 2 * (size_t) count) {
+			n *= 2;
+		}
+		slots.assign(n, 0);
+		size_t mask = n - 1;
+		for (int i = 0; i < count && unique; ++i) {
+			size_t k = slotOf(large[i].handle, mask);
+			while (slots[k] != 0) {
+				unique &= large[slots[k] - 1].handle != large[i].handle;
+				k = (k + 1) & mask;
+			}
+			slots[k] = i + 1;
+		}
+	}
+	if (!unique) {
+		clear();
+	}
+	return unique;
+}
+
+void QuantityStore::reserve(int n) {
+	//sizes the heap lines and index for baskets of n products
+	if (n <= INLINE_LINES) {
+		return;
+	}
+	if (large.size() < (size_t) n) {
+		large.resize(n);
+	}
+	size_t s = INLINE_LINES * 4;
+	while (s < 2 * (size_t) n) {
+		s *= 2;
+	}
+	if (slots.capacity() < s) {
+		slots.reserve(s);
+	}
+}
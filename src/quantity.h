@@ -0,0 +1,81 @@
+#ifndef _QUANTITY_H_
+#define _QUANTITY_H_
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+//the quantity scanned of each product in a basket, by inventory handle, in
+//the order products were first scanned. most baskets hold a few distinct
+//products, which are kept in an inline array and found by linear search;
+//past INLINE_LINES the lines move to the heap and gain an open addressing
+//index. clear keeps all capacity, so a warmed store never allocates
+class QuantityStore {
+public:
+	static const int INLINE_LINES = 16;
+	struct Line {
+		int handle;
+		int quantity; //hundredths of a pound if priced by weight, else units
+	};
+private:
+	Line small[INLINE_LINES];
+	vector<Line> large;
+	bool spilled = false; //lines are in large rather than small
+	int count = 0;
+	vector<int> slots; //when spilled, index from handle to line + 1, 0 when empty
+
+	inline const Line* lines() const { return spilled ? large.data() : small; }
+	inline Line* lines() { return spilled ? large.data() : small; }
+	inline int indexOf(int) const;
+	int lookup(int) const;
+	void add(int, int);
+	void spill();
+	void rehash(size_t);
+public:
+	inline int get(int) const;
+	inline int find(int h) const { return indexOf(h); } //the product's line, or -1
+	inline int set(int, int);
+	void clear();
+	void reserve(int);
+	Line* assign(int);
+	bool index();
+	inline int size() const { return count; }
+	inline const Line& line(int i) const { return lines()[i]; }
+	inline const Line* data() const { return lines(); }
+};
+
+int QuantityStore::indexOf(int h) const {
+	//the line for handle h, or -1; never adds one. the inline lines are
+	//compared in a full pass without an early exit, which costs less than
+	//the mispredicted branch an exit takes on nearly every lookup
+	if (spilled) {
+		return lookup(h);
+	}
+	int found = -1;
+	for (int i = 0; i < count; ++i) {
+		found = small[i].handle == h ? i : found;
+	}
+	return found;
+}
+
+int QuantityStore::get(int h) const {
+	int i = indexOf(h);
+	return i == -1 ? 0 : lines()[i].quantity;
+}
+
+int QuantityStore::set(int h, int q) {
+	//returns the product's line, or -1 if it has none because q is 0. a line
+	//brought back to 0 keeps its place in the scan order
+	int i = indexOf(h);
+	if (i != -1) {
+		lines()[i].quantity = q;
+	}
+	else if (q != 0) {
+		add(h, q);
+		i = count - 1;
+	}
+	return i;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "receipt.h"
+
+#include <cstring>
+
+namespace {
+
+const size_t NAME_WIDTH = 24;
+
+const char* specialName(int kind) {
+	return kind == SPECIAL_BOGO ? "BOGO" : kind == SPECIAL_BULK ? "BULK" : kind == SPECIAL_MIX ? "MIX" : "";
+}
+
+}
+
+ReceiptWriter::ReceiptWriter(const Register& r, int f) : reg(r), format(f) {
+}
+
+size_t ReceiptWriter::write(char* buffer, size_t length) {
+	//writes the next pieces of the receipt into buffer, returning the bytes
+	//written. 0 means the receipt is done, or that buffer can't hold even
+	//the next piece when done() is still false
+	out = buffer;
+	capacity = length;
+	used = 0;
+	int count = reg.getLineCount();
+	while (next <= count) {
+		size_t mark = used;
+		bool wasWritten = written;
+		overflow = false;
+		if (next == -1) {
+			header();
+		}
+		else if (next == count) {
+			footer();
+		}
+		else {
+			LineItem item = reg.getLineItem(next);
+			if (item.quantity != 0) {
+				line(item);
+			}
+		}
+		if (overflow) {
+			//the piece goes out whole on the next call
+			used = mark;
+			written = wasWritten;
+			break;
+		}
+		++next;
+	}
+	return used;
+}
+
+void ReceiptWriter::put(const char* s, size_t n) {
+	if (overflow || capacity - used < n) {
+		overflow = true;
+		return;
+	}
+	memcpy(out + used, s, n);
+	used += n;
+}
+
+void ReceiptWriter::put(const char* s) {
+	put(s, strlen(s));
+}
+
+void ReceiptWriter::putInt(long long v) {
+	char digits[24];
+	char* p = digits + sizeof(digits);
+	unsigned long long u = v < 0 ? -(unsigned long long) v : v;
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	if (v < 0) {
+		*--p = '-';
+	}
+	put(p, digits + sizeof(digits) - p);
+}
+
+void ReceiptWriter::putCents(long long v) {
+	//cents as dollars with two decimals
+	if (v < 0) {
+		put("-", 1);
+		v = -v;
+	}
+	putInt(v / 100);
+	char frac[3] = {'.', (char) ('0' + v % 100 / 10), (char) ('0' + v % 10)};
+	put(frac, 3);
+}
+
+void ReceiptWriter::putJsonString(const char* s, size_t n) {
+	put("\"", 1);
+	for (size_t i = 0; i < n; ++i) {
+		unsigned char c = s[i];
+		if (c == '"' || c == '\\') {
+			char escaped[2] = {'\\', (char) c};
+			put(escaped, 2);
+		}
+		else if (c < 0x20) {
+			const char* hex = "0123456789abcdef";
+			char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+			put(escaped, 6);
+		}
+		else {
+			put(s + i, 1);
+		}
+	}
+	put("\"", 1);
+}
+
+void ReceiptWriter::putPadded(const char* s, size_t n, size_t width) {
+	//s cut or padded with spaces to width
+	put(s, n < width ? n : width);
+	for (size_t i = n; i < width; ++i) {
+		put(" ", 1);
+	}
+}
+
+void ReceiptWriter::header() {
+	if (format == RECEIPT_JSON) {
+		put("{\"lines\":[");
+	}
+}
+
+void ReceiptWriter::line(const LineItem& item) {
+	Catalog::Reader pin; //keeps the name in place while it is written
+	const Catalog* c = reg.getCatalog();
+	size_t length = 0;
+	const char* name = c && item.handle < c->size() ? c->getName(item.handle, &length) : "";
+	if (format == RECEIPT_JSON) {
+		put(written ? ",{\"name\":" : "{\"name\":");
+		putJsonString(name, length);
+		put(",\"quantity\":");
+		putInt(item.quantity);
+		put(item.byWeight ? ",\"byWeight\":true,\"price\":" : ",\"byWeight\":false,\"price\":");
+		putInt(item.price);
+		put(",\"markdown\":");
+		putInt(item.markdown);
+		put(",\"special\":\"");
+		put(specialName(item.specialKind));
+		put("\",\"savings\":");
+		putInt(item.savings);
+		put(",\"amount\":");
+		putInt(item.amount);
+		put("}");
+		written = true;
+		return;
+	}
+	//name  quantity @ price  amount, then indented markdown and special savings
+	putPadded(name, length, NAME_WIDTH);
+	put(" ");
+	if (item.byWeight) {
+		putCents(item.quantity);
+		put(" lb @ ");
+	}
+	else {
+		putInt(item.quantity);
+		put(" @ ");
+	}
+	putCents(item.price);
+	put("  ");
+	putCents(item.amount);
+	put("\n");
+	if (item.markdown) {
+		put("    markdown -");
+		putCents(item.markdown);
+		put(item.byWeight ? " /lb\n" : " ea\n");
+	}
+	if (item.savings) {
+		put("    ");
+		put(specialName(item.specialKind));
+		//savings are shown as taken off, so a special that costs more than
+		//the line's own prices shows as added
+		put(item.savings > 0 ? " savings -" : " savings +");
+		putCents(item.savings > 0 ? item.savings : -(long long) item.savings);
+		put("\n");
+	}
+}
+
+void ReceiptWriter::footer() {
+	long long savings = 0;
+	for (int i = 0; i < reg.getLineCount(); ++i) {
+		savings += reg.getLineItem(i).savings;
+	}
+	if (format == RECEIPT_JSON) {
+		put("],\"savings\":");
+		putInt(savings);
+		put(",\"total\":");
+		putInt(reg.getTotal());
+		put("}\n");
+		return;
+	}
+	if (savings) {
+		put("SAVINGS ");
+		putCents(savings);
+		put("\n");
+	}
+	put("TOTAL ");
+	putCents(reg.getTotal());
+	put("\n");
+}
@@ -0,0 +1,44 @@
+#ifndef _RECEIPT_H_
+#define _RECEIPT_H_
+
+#include "register.h"
+
+#include <cstddef>
+
+const int RECEIPT_TEXT = 0;
+const int RECEIPT_JSON = 1;
+
+//streams a register's basket as a receipt, in plain text or JSON, into
+//buffers supplied by the caller. each call to write fills the buffer with
+//as many whole pieces (the header, one line item, the footer) as fit and
+//picks up where it stopped on the next call, so a receipt of any length can
+//go out through a small fixed buffer without building a string. lines
+//whose quantity was removed back to 0 are left out. the register must not
+//change until the receipt is done
+class ReceiptWriter {
+private:
+	const Register& reg;
+	int format;
+	int next = -1; //the piece to write next: -1 for the header, a line, or the line count for the footer
+	bool written = false; //whether any line has been written, for JSON's commas
+	char* out = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	bool overflow = false;
+
+	void put(const char*, size_t);
+	void put(const char*);
+	void putInt(long long);
+	void putCents(long long);
+	void putJsonString(const char*, size_t);
+	void putPadded(const char*, size_t, size_t);
+	void header();
+	void line(const LineItem&);
+	void footer();
+public:
+	ReceiptWriter(const Register&, int = RECEIPT_TEXT);
+	size_t write(char*, size_t);
+	inline bool done() const { return next > reg.getLineCount(); }
+};
+
+#endif
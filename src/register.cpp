@@ -1,154 +1,907 @@
 #include "register.h"
+#include "metrics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+//leads a suspended basket, followed by lineCount BasketLines, mixPools
+//BasketPools then mixUnits BasketUnits, all in native byte order; the
+//checksum covers everything after it
+struct BasketHeader {
+	char magic[4];
+	uint16_t format;
+	uint16_t rounding;
+	uint32_t lineCount;
+	int32_t total;
+	uint64_t catalogVersion; //snapshot the basket was pinned to, 0 if none
+	uint32_t checksum;
+	uint32_t mixUnits;
+	uint32_t mixPools;
+	uint32_t reserved;
+};
+
+struct BasketLine {
+	int32_t handle;
+	int32_t quantity;
+	int32_t price;
+	int32_t markdown;
+	int32_t amount;
+	int32_t savings;
+	int32_t flags; //special kind in the low byte, then byWeight
+};
+
+//a mix pool with the terms its runs were priced under, which its special's
+//slot may no longer hold
+struct BasketPool {
+	int32_t pool;
+	int32_t purchaseQuantity;
+	int32_t discountPrice;
+	int32_t limit;
+};
+
+//a unit in a mix pool, the pools one after another, each in position order
+struct BasketUnit {
+	int32_t pool;
+	int32_t line;
+	int32_t price;
+	int32_t slot; //the unit's place in its line's scan order
+};
+
+const char BASKET_MAGIC[4] = {'B', 'S', 'K', 'T'};
+const uint16_t BASKET_FORMAT = 2;
+const int32_t LINE_BY_WEIGHT = 0x100;
+
+static_assert(offsetof(BasketLine, quantity) == offsetof(BasketLine, handle) + sizeof(int32_t)
+	&& sizeof(QuantityStore::Line) == 2 * sizeof(int32_t), "a quantity line is copied as a handle and quantity");
+
+static_assert(sizeof(BasketHeader) == 40 && sizeof(BasketLine) == 28 && sizeof(BasketPool) == 16 && sizeof(BasketUnit) == 16,
+	"suspended basket layout");
+
+uint32_t basketChecksum(const char* p, size_t n) {
+	//a Fletcher style sum of 64 bit words: it catches any changed word or
+	//two words swapped, and costs little next to copying the basket
+	uint64_t a = n;
+	uint64_t b = 0;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		uint64_t w;
+		memcpy(&w, p + i, 8);
+		a += w;
+		b += a;
+	}
+	uint64_t w = 0;
+	memcpy(&w, p + i, n - i);
+	a += w;
+	b += a;
+	uint64_t x = a ^ (b * 0x9e3779b97f4a7c15ull);
+	return (uint32_t) (x ^ (x >> 32));
+}
+
+}
 
 void Register::assignInventory(shared_ptr<Inventory> i) {
 	productList = i;
+	pinned = nullptr;
+	prices.clear();
 }
 
-bool Register::scanItem(string s, int w) {
-	if (!this->productList) {
+void Register::reset() {
+	//starts a new basket, clearing only the lines scanned and keeping every
+	//buffer's capacity so a warmed register never allocates
+	total = 0;
+	quantity.clear();
+	lines.clear();
+	clearPools();
+	pinned = nullptr;
+	if (journal) {
+		journal->append(JOURNAL_RESET, -1, 0, 0);
+	}
+}
+
+bool Register::recover(const string& path) {
+	//rebuilds the basket in progress from the journal at path, replaying
+	//the records since its last reset; the inventory must be the one the
+	//journal was written against. nothing is journaled while replaying, but
+	//if the register has a journal the rebuilt basket is then written to it
+	//and committed, so it can be recovered again whatever the journal held
+	vector<JournalRecord> records;
+	if (!Journal::read(path, records)) {
 		return false;
 	}
-	if (this->productList->contains(s)) {
-		shared_ptr<Product> prodPtr = productList->retrieve(s);
-		if (prodPtr->getByWeight() && w == 0) {
-			//weighted object scanned without weight
+	size_t start = records.size();
+	while (start > 0 && records[start - 1].op != JOURNAL_RESET) {
+		--start;
+	}
+	total = 0;
+	quantity.clear();
+	lines.clear();
+	clearPools();
+	pinned = nullptr;
+	const Catalog* c = catalog();
+	for (size_t i = start; i < records.size(); ++i) {
+		const JournalRecord& r = records[i];
+		int q = getQuantity(r.handle);
+		if (r.handle < 0 || q + r.amount < 0) {
+			//not written by a register
 			return false;
 		}
-		if (prodPtr->getByWeight() == false) {
-			//ignore weight if product not priced by weight
-			w = 0;
+		//units in mix pools are replayed one by one, as the order they
+		//went in decides which are discounted
+		int pool = -1;
+		PriceRow row;
+		SpecialTerms terms;
+		uint32_t generation = 0;
+		const SpecialTerms* special = nullptr;
+		if (c && r.handle < c->size()) {
+			row = c->getRow(r.handle, nullptr, &terms, &generation);
+			special = row.special == -1 ? nullptr : &terms;
+			pool = poolOf(r.handle, q, row, special);
+		}
+		int line = quantity.set(r.handle, q + r.amount);
+		if (pool != -1 && r.amount != 0) {
+			if ((int) lines.size() <= line) {
+				lines.resize(line + 1);
+			}
+			if (r.amount > 0) {
+				mixAdd(line, pool, special, generation, row.price - row.markdown, r.amount);
+			}
+			else {
+				mixRemove(line, -r.amount);
+			}
+			record(line, row, special, 0, 0, pool);
 		}
-		int price = prodPtr->getPrice() - prodPtr->getMarkdown();
-		int curQuantity = getQuantity(s);
-		shared_ptr<Special> special = prodPtr->getSpecial();
-		incTotal(calcPrice(price, w, curQuantity, special));
-		incQuantity(s, w);
-		return true;
+		total = r.total;
 	}
-	return false;
+	//the journal doesn't carry line pricing, so the other lines are priced
+	//afresh against the current catalog
+	for (int i = 0; i < quantity.size(); ++i) {
+		const QuantityStore::Line& line = quantity.line(i);
+		if (!c || line.handle >= c->size()) {
+			return false;
+		}
+		if (i < (int) lines.size() && lines[i].pool != -1) {
+			continue;
+		}
+		SpecialTerms terms;
+		PriceRow row = c->getRow(line.handle, nullptr, &terms);
+		int price = row.price - row.markdown;
+		const SpecialTerms* special = row.special == -1 ? nullptr : &terms;
+		record(i, row, special, linePrice(price, row.byWeight, line.quantity, special, rounding),
+			linePrice(price, row.byWeight, line.quantity, nullptr, rounding));
+	}
+	if (journal) {
+		journalBasket();
+		journal->commit();
+	}
+	return true;
+}
+
+void Register::reserve(int n) {
+	//sizes the register for baskets of up to n distinct products, so
+	//scanning them doesn't allocate
+	quantity.reserve(n);
+	lines.reserve(n);
+	groups.reserve(n);
+	size_t slots = 16;
+	while (slots < 2 * (size_t) n) {
+		slots *= 2;
+	}
+	groupSlots.reserve(slots);
+}
+
+
+const Catalog* Register::catalog() {
+	//the catalog to price against: the live one, or in snapshot mode the
+	//version current when the basket started, so every price in a basket
+	//comes from one version even while the inventory is being updated
+	if (!this->productList) {
+		return nullptr;
+	}
+	if (!snapshotMode) {
+		return &productList->getCatalog();
+	}
+	if (!pinned) {
+		pinned = productList->snapshot();
+	}
+	return &pinned->getCatalog();
+}
+
+bool Register::scanItem(const string& s, int w) {
+	METRIC_START(start);
+	bool ok = add(handleOf(s), w, 1);
+	METRIC_STOP(METRIC_SCAN, start);
+	return ok;
+}
+
+bool Register::scanItem(int h, int w) {
+	METRIC_START(start);
+	bool ok = add(h, w, 1);
+	METRIC_STOP(METRIC_SCAN, start);
+	return ok;
+}
+
+bool Register::scanItems(const string& s, int n) {
+	METRIC_START(start);
+	bool ok = n > 0 && add(handleOf(s), 0, n);
+	METRIC_STOP(METRIC_SCAN, start);
+	return ok;
+}
+
+bool Register::scanItems(int h, int n) {
+	//scans n units of a product not priced by weight in one step
+	METRIC_START(start);
+	bool ok = n > 0 && add(h, 0, n);
+	METRIC_STOP(METRIC_SCAN, start);
+	return ok;
+}
+
+bool Register::removeItem(const string& s, int w) {
+	METRIC_START(start);
+	bool ok = subtract(handleOf(s), w, 1);
+	METRIC_STOP(METRIC_REMOVE, start);
+	return ok;
 }
 
-bool Register::removeItem(string n, int w) {
-	shared_ptr<Product> prodPtr = productList->retrieve(n);
-	if (prodPtr->getByWeight() && w > getQuantity(n)) {
-		//trying to remove more pounds than currently have
+bool Register::removeItem(int h, int w) {
+	METRIC_START(start);
+	bool ok = subtract(h, w, 1);
+	METRIC_STOP(METRIC_REMOVE, start);
+	return ok;
+}
+
+bool Register::removeItems(const string& s, int n) {
+	METRIC_START(start);
+	bool ok = n > 0 && subtract(handleOf(s), 0, n);
+	METRIC_STOP(METRIC_REMOVE, start);
+	return ok;
+}
+
+bool Register::removeItems(int h, int n) {
+	METRIC_START(start);
+	bool ok = n > 0 && subtract(h, 0, n);
+	METRIC_STOP(METRIC_REMOVE, start);
+	return ok;
+}
+
+bool Register::add(int h, int w, int n) {
+	//adds weight w of a weighed product, or n units of any other, repricing
+	//its line as a whole
+	const Catalog* c = catalog();
+	if (!c || h < 0 || h >= c->size()) {
+		METRIC_COUNT(COUNT_SCAN_UNKNOWN);
 		return false;
 	}
-	else if (getQuantity(n) == 0) {
-		//trying to remove product not currently scanned
+	uint32_t version, generation = 0;
+	SpecialTerms terms;
+	PriceRow row = c->getRow(h, &version, &terms, &generation);
+	if (row.erased) {
+		//product was removed from the inventory, though a basket may still remove it
+		METRIC_COUNT(COUNT_SCAN_ERASED);
 		return false;
 	}
-	if (prodPtr->getByWeight() && w == 0) {
-		//trying to remove weighted item without passing weight
+	if (row.byWeight && w == 0) {
+		//weighted object scanned without weight
+		METRIC_COUNT(COUNT_SCAN_NO_WEIGHT);
 		return false;
 	}
-	if (prodPtr->getByWeight() == false) {
-		w = 0;
+	if (row.byWeight) {
+		//weight replaces the unit count for weighed products
+		n = w;
+	}
+	int price = row.price - row.markdown;
+	int curQuantity = getQuantity(h);
+	const SpecialTerms* special = row.special == -1 ? nullptr : &terms;
+	int pool = poolOf(h, curQuantity, row, special);
+	int line = -1;
+	int change, plain;
+	if (pool != -1) {
+		//the pool books the change to every line whose units it repriced
+		line = quantity.set(h, curQuantity + n);
+		total += mixAdd(line, pool, special, generation, price, n);
+		change = plain = 0;
 	}
-	int price = prodPtr->getPrice() - prodPtr->getMarkdown();
-	int curQuantity = getQuantity(n);
-	shared_ptr<Special> special = prodPtr->getSpecial();
-	int dec = 1;
-	if (w != 0) { //amount to decrement from the current quantity to account for weight priced specials
-		dec = w;
+	else if (n == 1 && !row.byWeight && prices.enabled()) {
+		change = unitPrice(h, version, price, curQuantity, special);
+		plain = price;
 	}
-	decTotal(calcPrice(price, w, curQuantity - dec, special));
-	//subtract the amount of product being removed from curQuantity to calculate if the unit being removed was priced at discount
-	decQuantity(n, w);
+	else {
+		change = linePrice(price, row.byWeight, curQuantity + n, special, rounding)
+			- linePrice(price, row.byWeight, curQuantity, special, rounding);
+		plain = !special ? change : linePrice(price, row.byWeight, curQuantity + n, nullptr, rounding)
+			- linePrice(price, row.byWeight, curQuantity, nullptr, rounding);
+	}
+	total += change;
+	record(line != -1 ? line : quantity.set(h, curQuantity + n), row, special, change, plain, pool);
+	if (journal) {
+		journal->append(JOURNAL_SCAN, h, n, total);
+	}
+	METRIC_COUNT(COUNT_SCANNED);
 	return true;
 }
 
-int Register::calcPrice(int p, int w, int q, shared_ptr<Special> s) {
-	int total = 0;
-	int overLimit = 0; //used for weight priced specials
-	if (w && s && s->getLimit() != 0) {
-		overLimit = w + q - s->getLimit();
-		overLimit = overLimit > 0 ? overLimit : 0;
-		w -= overLimit;
-	}
-	if (w && s) { //special for weighted item
-		int purchaseQuantity = s->getPurchaseQuantity();
-		int discountQuantity = s->getDiscountQuantity();
-		int discountPercentage = s->getDiscountPercentage();
-		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
-		int discountPrice = (int) (p * ((100 - discountPercentage) / 100.0) + .5); //cents per lb
-		int price = 0;
-		int fullCycles = w / totalSpecialQuantity; //amount of sets of max full price and discount price quantities
-		w = w % totalSpecialQuantity; //amount left over after taking out full sets
-		price += ((int) ((fullCycles * discountPrice * discountQuantity / 100.0) + (fullCycles * p * purchaseQuantity / 100.0) + .5)); //adding the total of max full and discount price quantities
-		int margin = q % totalSpecialQuantity; //amount of product towards next cycle previously scanned
-		if (margin / purchaseQuantity) { //already in discount price
-			int discPriceQuantity = totalSpecialQuantity - margin; //calculate how much quantity to add until out of discount price range and add
-			discPriceQuantity = discPriceQuantity < w ? discPriceQuantity : w; //check if enough weight to cover dpq range
-			price += ((int) (discountPrice * (discPriceQuantity / 100.0) + .5));
-			w -= discPriceQuantity;
-			price += ((int) (p * (w / 100.0) + .5)); //dump rest into full price
-		}
-		else { //have some way to go in full price
-			int fullPriceQuantity = purchaseQuantity - margin; //calculate how much quantity to add in full price range and add
-			fullPriceQuantity = fullPriceQuantity < w ? fullPriceQuantity : w; //check if enough weight to cover fPQ
-			w -= fullPriceQuantity;
-			price += ((int) (p * (fullPriceQuantity / 100.0) + .5));
-			price += ((int) (discountPrice * (w / 100.0) + .5)); //dump rest into disc price
-		}
-		w = overLimit;
-		total = price;
-	}
-	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BOGO") {
-		int purchaseQuantity = s->getPurchaseQuantity();
-		int discountQuantity = s->getDiscountQuantity();
-		int discountPercentage = s->getDiscountPercentage();
-		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
-		if (q % totalSpecialQuantity >= purchaseQuantity) {
-			double discountPrice = 100 - discountPercentage;
-			discountPrice /= 100.0;
-			discountPrice *= p;
-			discountPrice += .5; //for rounding
-			p = (int) discountPrice;
-		}
-	}
-	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BULK") {
-		int purchaseQuantity = s->getPurchaseQuantity();
-		int discountPrice = s->getDiscountPrice();
-		if (q % purchaseQuantity == purchaseQuantity - 1) {
-			p = discountPrice - (p * (purchaseQuantity - 1));
-		}
-	}
-	if (w != 0) { //multiply price per pound by quantity in
-		//hundredths of a pound
-		double lbScanned = w / 100.0;
-		double cost = lbScanned * p;
-		cost += .5; //for rounding
-		total += (int) cost;
-	}
-	if (total) { //for weight priced items
-		p = total;
-	}
-	return p;
-}
-
-void Register::incTotal(int p) {
-	total += p;
-}
-
-void Register::decTotal(int p) {
-	total -= p;
-}
-
-void Register::incQuantity(string n, int w) {
-	if (w == 0) {
-		++quantity[n];
+bool Register::subtract(int h, int w, int n) {
+	const Catalog* c = catalog();
+	if (!c || h < 0 || h >= c->size()) {
+		METRIC_COUNT(COUNT_REMOVE_UNKNOWN);
+		return false;
+	}
+	uint32_t version;
+	SpecialTerms terms;
+	PriceRow row = c->getRow(h, &version, &terms);
+	if (row.byWeight && w == 0) {
+		//trying to remove weighted item without passing weight
+		METRIC_COUNT(COUNT_REMOVE_NO_WEIGHT);
+		return false;
+	}
+	if (row.byWeight) {
+		n = w;
+	}
+	int curQuantity = getQuantity(h);
+	if (curQuantity == 0 || n > curQuantity) {
+		//trying to remove product not currently scanned, or more than was scanned
+		METRIC_COUNT(COUNT_REMOVE_NOT_SCANNED);
+		return false;
+	}
+	int price = row.price - row.markdown;
+	const SpecialTerms* special = row.special == -1 ? nullptr : &terms;
+	int pool = poolOf(h, curQuantity, row, special);
+	int change, plain;
+	if (pool != -1) {
+		total -= mixRemove(quantity.find(h), n);
+		change = plain = 0;
+	}
+	else if (n == 1 && !row.byWeight && prices.enabled()) {
+		change = unitPrice(h, version, price, curQuantity - 1, special);
+		plain = price;
 	}
 	else {
-		quantity[n] += w;
+		change = linePrice(price, row.byWeight, curQuantity, special, rounding)
+			- linePrice(price, row.byWeight, curQuantity - n, special, rounding);
+		plain = !special ? change : linePrice(price, row.byWeight, curQuantity, nullptr, rounding)
+			- linePrice(price, row.byWeight, curQuantity - n, nullptr, rounding);
+	}
+	total -= change;
+	record(quantity.set(h, curQuantity - n), row, special, -change, -plain, pool);
+	if (journal) {
+		journal->append(JOURNAL_REMOVE, h, -n, total);
 	}
+	METRIC_COUNT(COUNT_REMOVED);
+	return true;
 }
 
-void Register::decQuantity(string n, int w) {
-	if (w == 0) {
-		--quantity[n];
+int Register::scanBatch(const ScanEntry* e, size_t n, bool* status) {
+	//scans a burst of items at once; returns how many were scanned and
+	//optionally whether each was
+	METRIC_START(start);
+	int done = batch(e, n, status, true);
+	METRIC_STOP(METRIC_SCAN_BATCH, start);
+	return done;
+}
+
+int Register::removeBatch(const ScanEntry* e, size_t n, bool* status) {
+	METRIC_START(start);
+	int done = batch(e, n, status, false);
+	METRIC_STOP(METRIC_REMOVE_BATCH, start);
+	return done;
+}
+
+int Register::batch(const ScanEntry* e, size_t n, bool* status, bool adding) {
+	//resolves each distinct product in the batch once and prices it once for
+	//the combined change to its line; each entry succeeds or fails exactly
+	//as the same scanItem or removeItem calls made in order would
+	const Catalog* c = catalog();
+	groups.clear();
+	size_t slots = 16;
+	while (slots < 2 * n) {
+		slots *= 2;
 	}
-	else {
-		quantity[n] -= w;
+	groupSlots.assign(slots, 0);
+	int rows = c ? c->size() : 0;
+	int h = -1;
+	int g = -1;
+	int done = 0;
+	for (size_t i = 0; i < n; ++i) {
+		//runs of the same item, as a conveyor sends them, are looked up once
+		int prev = h;
+		if (e[i].handle != -1 || !e[i].name) {
+			h = e[i].handle;
+		}
+		else if (i == 0 || !e[i - 1].name || e[i - 1].handle != -1 || e[i - 1].length != e[i].length
+			|| (e[i - 1].name != e[i].name && memcmp(e[i - 1].name, e[i].name, e[i].length) != 0)) {
+			h = rows ? c->find(e[i].name, e[i].length) : -1;
+		}
+		bool ok = false;
+		if (h >= 0 && h < rows) {
+			if (h != prev || g == -1) {
+				g = groupOf(h, c);
+			}
+			BatchGroup& b = groups[g];
+			int k = b.row.byWeight ? e[i].weight : 1;
+			if (b.mix) {
+				//which units a mix and match run discounts depends on the
+				//order they go into its pool, so they go in as they come
+				ok = adding ? add(h, e[i].weight, 1) : subtract(h, e[i].weight, 1);
+			}
+			else if (b.row.byWeight && k == 0) {
+				//weighted object scanned or removed without weight
+				ok = false;
+				METRIC_COUNT(adding ? COUNT_SCAN_NO_WEIGHT : COUNT_REMOVE_NO_WEIGHT);
+			}
+			else if (adding) {
+				ok = !b.row.erased;
+				b.after += ok ? k : 0;
+				METRIC_COUNT(ok ? COUNT_SCANNED : COUNT_SCAN_ERASED);
+			}
+			else {
+				ok = b.after > 0 && k <= b.after;
+				b.after -= ok ? k : 0;
+				METRIC_COUNT(ok ? COUNT_REMOVED : COUNT_REMOVE_NOT_SCANNED);
+			}
+		}
+		else {
+			g = -1;
+			METRIC_COUNT(adding ? COUNT_SCAN_UNKNOWN : COUNT_REMOVE_UNKNOWN);
+		}
+		if (status) {
+			status[i] = ok;
+		}
+		done += ok;
+	}
+	for (const BatchGroup& b : groups) {
+		if (b.after == b.before) {
+			continue;
+		}
+		int price = b.row.price - b.row.markdown;
+		const SpecialTerms* special = b.row.special == -1 ? nullptr : &b.terms;
+		int change = linePrice(price, b.row.byWeight, b.after, special, rounding)
+			- linePrice(price, b.row.byWeight, b.before, special, rounding);
+		int plain = !special ? change : linePrice(price, b.row.byWeight, b.after, nullptr, rounding)
+			- linePrice(price, b.row.byWeight, b.before, nullptr, rounding);
+		total += change;
+		record(quantity.set(b.handle, b.after), b.row, special, change, plain);
+		if (journal) {
+			journal->append(adding ? JOURNAL_SCAN : JOURNAL_REMOVE, b.handle, b.after - b.before, total);
+		}
+	}
+	return done;
+}
+
+int Register::unitPrice(int h, uint32_t version, int p, int q, const SpecialTerms* special) {
+	//what unit q + 1 of a product not priced by weight adds to its line,
+	//from the price cache when the same product at the same row version was
+	//priced at the same point in its special's cycle before
+	int pos = unitPosition(q, special);
+	int unit;
+	if (!prices.get(h, version, pos, unit)) {
+		unit = linePrice(p, false, q + 1, special, rounding) - linePrice(p, false, q, special, rounding);
+		prices.put(h, version, pos, unit);
+	}
+	return unit;
+}
+
+int Register::poolOf(int h, int q, const PriceRow& row, const SpecialTerms* special) const {
+	//the mix pool the next units of a product with q in the basket go to:
+	//the one its line already has units in, else its mix and match
+	//special's if it has one, or -1 if the line is priced on its own. a
+	//basket which hasn't used a pool doesn't need to look for the line
+	if (q > 0) {
+		int line = activePools.empty() ? -1 : quantity.find(h);
+		return line != -1 && line < (int) lines.size() ? lines[line].pool : -1;
+	}
+	return special && special->kind == SPECIAL_MIX && special->purchaseQuantity > 0 && !row.byWeight ? row.special : -1;
+}
+
+int Register::mixAdd(int line, int pool, const SpecialTerms* special, uint32_t generation, int price, int n) {
+	//adds n units of a line at price each to a pool, which takes its terms
+	//from the special while it is empty; returns the change to the total,
+	//having booked it to the lines of the units repriced. a line joining
+	//the pool of a catalog slot since given to another special moves the
+	//old special's units to a pool of their own first
+	if ((int) pools.size() <= pool) {
+		pools.resize(pool + 1);
+	}
+	if ((int) mixPositions.size() <= line) {
+		mixPositions.resize(line + 1);
+	}
+	if ((int) lines.size() <= line) {
+		lines.resize(line + 1);
+	}
+	if (pools[pool].size() != 0 && mixPositions[line].empty() && pools[pool].getGeneration() != generation) {
+		movePool(pool);
+	}
+	MixPool& p = pools[pool];
+	if (p.size() == 0) {
+		p.setTerms(*special);
+		p.setGeneration(generation);
+		if (!p.getActive()) {
+			p.setActive(true);
+			activePools.push_back(pool);
+		}
+	}
+	int change = 0;
+	for (int i = 0; i < n; ++i) {
+		int groups = p.getGroups();
+		change += p.add(line, price, mixPositions);
+		lines[line].amount += price;
+		if (p.getGroups() != groups) {
+			//the unit completed a discounted run, whose units paid their own
+			//prices until now
+			p.charges((p.size() - 1) / p.getTerms().purchaseQuantity, [this](int l, int own, int charge) {
+				lines[l].amount += charge - own;
+				lines[l].savings += own - charge;
+			});
+		}
+	}
+	return change;
+}
+
+void Register::movePool(int pool) {
+	//moves a pool and its lines to an unused index, leaving pool empty and
+	//inactive. generations are never reused, so the moved pool can't be
+	//joined by mistake should its new index become a slot later
+	int to = pools.size() - 1;
+	while (to >= 0 && pools[to].getActive()) {
+		--to;
+	}
+	if (to < 0) {
+		to = pools.size();
+		pools.resize(to + 1);
+	}
+	std::swap(pools[to], pools[pool]);
+	for (LineRecord& l : lines) {
+		if (l.pool == pool) {
+			l.pool = to;
+		}
+	}
+	for (int& active : activePools) {
+		if (active == pool) {
+			active = to;
+		}
+	}
+}
+
+int Register::mixRemove(int line, int n) {
+	//takes n of a line's units out of its pool, latest first; returns what
+	//that takes off the total, having booked it to the lines of the units
+	//repriced: those in the removed unit's run and in the last run, whose
+	//unit takes its place
+	MixPool& p = pools[lines[line].pool];
+	int q = p.getTerms().purchaseQuantity;
+	int change = 0;
+	for (int i = 0; i < n; ++i) {
+		int run = mixPositions[line].back() / q;
+		int last = (p.size() - 1) / q;
+		bookRun(p, run, -1);
+		if (last != run) {
+			bookRun(p, last, -1);
+		}
+		lines[line].savings -= p.unit(mixPositions[line].back()).price;
+		change -= p.remove(line, mixPositions);
+		bookRun(p, run, 1);
+		if (last != run) {
+			bookRun(p, last, 1);
+		}
+	}
+	return change;
+}
+
+void Register::bookRun(const MixPool& p, int run, int sign) {
+	//adds what a run's units are charged to their lines, or with sign -1
+	//takes it off
+	p.charges(run, [this, sign](int line, int, int charge) {
+		lines[line].amount += sign * charge;
+		lines[line].savings -= sign * charge;
+	});
+}
+
+void Register::clearPools() {
+	if (activePools.empty()) {
+		return;
+	}
+	for (int pool : activePools) {
+		pools[pool].clear();
+		pools[pool].setActive(false);
+	}
+	activePools.clear();
+	for (vector<int>& positions : mixPositions) {
+		positions.clear();
+	}
+}
+
+void Register::record(int i, const PriceRow& row, const SpecialTerms* special, int change, int plain, int pool) {
+	//notes how line i was just priced: change is what it added to the total
+	//and plain what it would have added without the special, and the mix
+	//pool its units are in if any
+	if (i == (int) lines.size()) {
+		lines.push_back(LineRecord());
+	}
+	LineRecord& l = lines[i];
+	l.price = row.price;
+	l.markdown = row.markdown;
+	l.specialKind = pool != -1 ? SPECIAL_MIX : special ? special->kind : SPECIAL_NONE;
+	l.pool = pool;
+	l.byWeight = row.byWeight != 0;
+	l.amount += change;
+	l.savings += plain - change;
+}
+
+size_t Register::suspendedSize() const {
+	size_t units = 0;
+	for (int pool : activePools) {
+		units += pools[pool].size();
+	}
+	return sizeof(BasketHeader) + quantity.size() * sizeof(BasketLine) + activePools.size() * sizeof(BasketPool)
+		+ units * sizeof(BasketUnit);
+}
+
+size_t Register::suspend(char* out, size_t length) const {
+	//writes the basket, with its line pricing, total and pinned catalog
+	//version, to out as a versioned and checksummed blob for resume; returns
+	//the bytes written, or 0 if it needs more than length
+	size_t size = suspendedSize();
+	if (size > length) {
+		return 0;
+	}
+	BasketHeader header;
+	memcpy(header.magic, BASKET_MAGIC, sizeof(header.magic));
+	header.format = BASKET_FORMAT;
+	header.rounding = rounding;
+	header.lineCount = quantity.size();
+	header.total = total;
+	header.catalogVersion = getSnapshotVersion();
+	header.mixPools = activePools.size();
+	header.mixUnits = (size - sizeof(header) - quantity.size() * sizeof(BasketLine) - activePools.size() * sizeof(BasketPool))
+		/ sizeof(BasketUnit);
+	header.reserved = 0;
+	const QuantityStore::Line* q = quantity.data();
+	const LineRecord* l = lines.data();
+	char* p = out + sizeof(header);
+	for (int i = 0, n = quantity.size(); i < n; ++i, p += sizeof(BasketLine)) {
+		//field by field, since a whole BasketLine built on the stack and
+		//copied out reads back stores the CPU can't forward
+		int32_t flags = l[i].specialKind | (l[i].byWeight ? LINE_BY_WEIGHT : 0);
+		memcpy(p + offsetof(BasketLine, handle), &q[i], sizeof(QuantityStore::Line));
+		memcpy(p + offsetof(BasketLine, price), &l[i].price, sizeof(int32_t));
+		memcpy(p + offsetof(BasketLine, markdown), &l[i].markdown, sizeof(int32_t));
+		memcpy(p + offsetof(BasketLine, amount), &l[i].amount, sizeof(int32_t));
+		memcpy(p + offsetof(BasketLine, savings), &l[i].savings, sizeof(int32_t));
+		memcpy(p + offsetof(BasketLine, flags), &flags, sizeof(int32_t));
+	}
+	for (int pool : activePools) {
+		const SpecialTerms& t = pools[pool].getTerms();
+		BasketPool b = {pool, t.purchaseQuantity, t.discountPrice, t.limit};
+		memcpy(p, &b, sizeof(b));
+		p += sizeof(b);
+	}
+	for (int pool : activePools) {
+		const MixPool& m = pools[pool];
+		for (int i = 0; i < m.size(); ++i, p += sizeof(BasketUnit)) {
+			memcpy(p + offsetof(BasketUnit, pool), &pool, sizeof(int32_t));
+			memcpy(p + offsetof(BasketUnit, line), &m.unit(i).line, sizeof(int32_t));
+			memcpy(p + offsetof(BasketUnit, price), &m.unit(i).price, sizeof(int32_t));
+			memcpy(p + offsetof(BasketUnit, slot), &m.unit(i).slot, sizeof(int32_t));
+		}
+	}
+	header.checksum = basketChecksum(out + sizeof(header), size - sizeof(header));
+	memcpy(out, &header, sizeof(header));
+	return size;
+}
+
+bool Register::resume(const char* in, size_t length) {
+	//replaces the basket with one written by suspend, on this or another
+	//register over the same inventory; false if the blob is malformed or
+	//from another format version, leaving the basket as it was if that shows
+	//in the header and empty otherwise. lines keep the prices they were
+	//scanned at. in snapshot mode the basket is pinned to its old catalog
+	//version if that is still the latest published, else to the latest at
+	//its next scan
+	BasketHeader header;
+	if (length < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, in, sizeof(header));
+	if (memcmp(header.magic, BASKET_MAGIC, sizeof(header.magic)) != 0 || header.format != BASKET_FORMAT
+		|| length != sizeof(header) + (size_t) header.lineCount * sizeof(BasketLine) + (size_t) header.mixPools * sizeof(BasketPool)
+			+ (size_t) header.mixUnits * sizeof(BasketUnit)
+		|| header.checksum != basketChecksum(in + sizeof(header), length - sizeof(header))) {
+		return false;
+	}
+	pinned = nullptr;
+	if (snapshotMode && header.catalogVersion != 0 && productList) {
+		shared_ptr<const InventorySnapshot> latest = productList->snapshot();
+		if (latest->getVersion() == header.catalogVersion) {
+			pinned = latest;
+		}
+	}
+	if (rounding != header.rounding) {
+		setRounding(header.rounding);
+	}
+	clearPools();
+	//each line is copied straight into place, then the store indexed once
+	int n = header.lineCount;
+	QuantityStore::Line* q = quantity.assign(n);
+	lines.resize(n);
+	const char* p = in + sizeof(header);
+	bool valid = true;
+	LineRecord* l = lines.data();
+	for (int i = 0; i < n; ++i, p += sizeof(BasketLine)) {
+		int32_t flags;
+		memcpy(&q[i], p + offsetof(BasketLine, handle), sizeof(QuantityStore::Line));
+		memcpy(&l[i].price, p + offsetof(BasketLine, price), sizeof(int32_t));
+		memcpy(&l[i].markdown, p + offsetof(BasketLine, markdown), sizeof(int32_t));
+		memcpy(&l[i].amount, p + offsetof(BasketLine, amount), sizeof(int32_t));
+		memcpy(&l[i].savings, p + offsetof(BasketLine, savings), sizeof(int32_t));
+		memcpy(&flags, p + offsetof(BasketLine, flags), sizeof(int32_t));
+		l[i].specialKind = flags & 0xff;
+		l[i].byWeight = (flags & LINE_BY_WEIGHT) != 0;
+		l[i].pool = -1;
+		valid &= q[i].handle >= 0 && q[i].quantity >= 0;
+	}
+	//then the mix pools are set up with the terms they had, refilled in
+	//their old order, so the same units stay discounted, and each line's
+	//units put back in its scan order, so removals take back the same ones.
+	//a pool whose slot still holds its terms can be joined by new lines.
+	//each mix line must have all its units back
+	const Catalog* c = getCatalog();
+	int slots = c ? c->specialsSize() : 0;
+	for (uint32_t i = 0; valid && i < header.mixPools; ++i, p += sizeof(BasketPool)) {
+		BasketPool b;
+		memcpy(&b, p, sizeof(b));
+		valid = b.pool >= 0 && b.pool < slots + (int) header.mixPools && b.purchaseQuantity > 0
+			&& ((int) pools.size() <= b.pool || !pools[b.pool].getActive());
+		if (valid) {
+			SpecialTerms t;
+			t.kind = SPECIAL_MIX;
+			t.purchaseQuantity = b.purchaseQuantity;
+			t.discountPrice = b.discountPrice;
+			t.limit = b.limit;
+			uint32_t generation = 0;
+			SpecialTerms now;
+			if (b.pool < slots) {
+				now = c->getSpecial(b.pool, &generation);
+			}
+			if (now.kind != SPECIAL_MIX || now.purchaseQuantity != t.purchaseQuantity || now.discountPrice != t.discountPrice
+				|| now.limit != t.limit) {
+				generation = 0; //never given to a slot
+			}
+			if ((int) pools.size() <= b.pool) {
+				pools.resize(b.pool + 1);
+			}
+			pools[b.pool].setTerms(t);
+			pools[b.pool].setGeneration(generation);
+			pools[b.pool].setActive(true);
+			activePools.push_back(b.pool);
+		}
+	}
+	for (uint32_t i = 0; valid && i < header.mixUnits; ++i, p += sizeof(BasketUnit)) {
+		BasketUnit u;
+		memcpy(&u.pool, p + offsetof(BasketUnit, pool), sizeof(int32_t));
+		memcpy(&u.line, p + offsetof(BasketUnit, line), sizeof(int32_t));
+		memcpy(&u.price, p + offsetof(BasketUnit, price), sizeof(int32_t));
+		memcpy(&u.slot, p + offsetof(BasketUnit, slot), sizeof(int32_t));
+		valid = u.pool >= 0 && u.pool < (int) pools.size() && pools[u.pool].getActive() && u.line >= 0 && u.line < n
+			&& (l[u.line].pool == -1 || l[u.line].pool == u.pool);
+		if (valid) {
+			if (l[u.line].pool == -1) {
+				//booked afresh as its units go back in
+				l[u.line].amount = 0;
+				l[u.line].savings = 0;
+			}
+			const MixPool& m = pools[u.pool];
+			mixAdd(u.line, u.pool, &m.getTerms(), m.getGeneration(), u.price, 1);
+			pools[u.pool].setSlot(pools[u.pool].size() - 1, u.slot);
+			l[u.line].pool = u.pool;
+		}
+	}
+	for (int i = 0; valid && i < n; ++i) {
+		valid = l[i].pool == -1 || (int) mixPositions[i].size() == q[i].quantity;
+	}
+	for (size_t k = 0; valid && k < activePools.size(); ++k) {
+		const MixPool& m = pools[activePools[k]];
+		for (int i = 0; valid && i < m.size(); ++i) {
+			const MixPool::Unit& u = m.unit(i);
+			valid = u.slot >= 0 && u.slot < (int) mixPositions[u.line].size();
+			if (valid) {
+				mixPositions[u.line][u.slot] = i;
+			}
+		}
+	}
+	for (size_t k = 0; valid && k < activePools.size(); ++k) {
+		//no two units claimed the same slot
+		const MixPool& m = pools[activePools[k]];
+		for (int i = 0; valid && i < m.size(); ++i) {
+			valid = mixPositions[m.unit(i).line][m.unit(i).slot] == i;
+		}
+	}
+	if (!valid || !quantity.index()) {
+		reset();
+		return false;
+	}
+	total = header.total;
+	if (journal) {
+		journalBasket();
+	}
+	return true;
+}
+
+void Register::journalBasket() {
+	//journals the basket as a new one holding its lines, for a basket not
+	//built by the scans already in the journal
+	journal->append(JOURNAL_RESET, -1, 0, 0);
+	int running = 0;
+	for (int i = 0; i < quantity.size(); ++i) {
+		const QuantityStore::Line& q = quantity.line(i);
+		if (lines[i].pool != -1) {
+			continue;
+		}
+		running += lines[i].amount;
+		if (q.quantity != 0) {
+			journal->append(JOURNAL_SCAN, q.handle, q.quantity, running);
+		}
+	}
+	//mix pool units one at a time in pool order, which recover replays
+	//into the same runs; which unit a later removal takes back may differ
+	for (int pool : activePools) {
+		const MixPool& m = pools[pool];
+		for (int i = 0; i < m.size(); ++i) {
+			journal->append(JOURNAL_SCAN, quantity.line(m.unit(i).line).handle, 1, total);
+		}
+	}
+}
+
+LineItem Register::getLineItem(int i) const {
+	//line i of the basket in the order products were first scanned
+	const QuantityStore::Line& q = quantity.line(i);
+	const LineRecord& l = lines[i];
+	LineItem item;
+	item.handle = q.handle;
+	item.quantity = q.quantity;
+	item.byWeight = l.byWeight;
+	item.price = l.price;
+	item.markdown = l.markdown;
+	item.specialKind = l.specialKind;
+	item.amount = l.amount;
+	item.savings = l.savings;
+	return item;
+}
+
+const Catalog* Register::getCatalog() const {
+	//the catalog the basket is priced against, for looking up names; unlike
+	//pricing this never pins a snapshot
+	if (pinned) {
+		return &pinned->getCatalog();
+	}
+	return productList ? &productList->getCatalog() : nullptr;
+}
+
+int Register::groupOf(int h, const Catalog* c) {
+	//the batch group for handle h, reading its row when first seen
+	size_t mask = groupSlots.size() - 1;
+	size_t k = ((unsigned) h * 2654435761u) & mask;
+	while (groupSlots[k] != 0 && groups[groupSlots[k] - 1].handle != h) {
+		k = (k + 1) & mask;
+	}
+	if (groupSlots[k] == 0) {
+		int q = getQuantity(h);
+		BatchGroup b;
+		b.handle = h;
+		b.row = c->getRow(h, nullptr, &b.terms);
+		b.before = q;
+		b.after = q;
+		b.mix = poolOf(h, q, b.row, b.row.special == -1 ? nullptr : &b.terms) != -1;
+		groups.push_back(b);
+		groupSlots[k] = groups.size();
+	}
+	return groupSlots[k] - 1;
+}
+
+int Register::handleOf(const string& s) {
+	const Catalog* c = catalog();
+	if (!c) {
+		return -1;
 	}
+	return c->find(s);
 }
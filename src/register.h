@@ -2,36 +2,135 @@
 #define _REGISTER_H_
 
 #include "inventory.h"
+#include "journal.h"
+#include "mix.h"
+#include "pricecache.h"
+#include "pricing.h"
+#include "quantity.h"
 #include "special.h"
 
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 using std::shared_ptr;
 using std::string;
-using std::unordered_map;
+using std::vector;
+
+//one item in a batch passed to Register::scanBatch or removeBatch, naming
+//its product by inventory handle, or when the handle is -1 by a name it
+//borrows from the caller
+struct ScanEntry {
+	const char* name;
+	size_t length;
+	int handle;
+	int weight; //as passed to scanItem, ignored unless the product is priced by weight
+	ScanEntry(int h = -1, int w = 0) : name(nullptr), length(0), handle(h), weight(w) { }
+	ScanEntry(const string& n, int w = 0) : name(n.data()), length(n.size()), handle(-1), weight(w) { }
+};
+
+//one line of a basket, for a receipt: a product, how much of it was
+//scanned and how it was priced when last scanned or removed
+struct LineItem {
+	int handle;
+	int quantity; //hundredths of a pound if byWeight, else units; 0 if all were removed
+	bool byWeight;
+	int price; //per unit or per pound, before markdown
+	int markdown;
+	int specialKind; //SPECIAL_NONE if the product had no special
+	int amount; //what the line adds to the register's total, in cents
+	int savings; //what the special took off the line, in cents
+};
 
 class Register {
 private:
-	int total = 0; //total cost of scanned items in cents
-	unordered_map<string, int> quantity; //stores quantity of scanned items
+	//pricing of a basket line, kept in step with the quantity store's lines
+	struct LineRecord {
+		int price;
+		int markdown;
+		int specialKind;
+		bool byWeight;
+		int amount = 0;
+		int savings = 0;
+		int pool = -1; //the mix pool holding the line's units, -1 if it is priced on its own
+	};
+	//the entries of a batch for one product, which is priced once
+	struct BatchGroup {
+		int handle;
+		PriceRow row;
+		SpecialTerms terms; //of the row's special, if it has one
+		int before; //quantity before the batch
+		int after;
+		bool mix; //in a mix pool, so its entries are priced one by one
+	};
+
+	int total = 0; //total cost of scanned items in cents, the sum of each line's linePrice
+	QuantityStore quantity; //stores quantity of scanned items by inventory handle
 		//if product is priced by weight, stores hundredths of a pound
 		//otherwise, stores number of units
 	shared_ptr<Inventory> productList = nullptr;
+	int rounding = ROUND_HALF_UP;
+	bool snapshotMode = false;
+	shared_ptr<const InventorySnapshot> pinned = nullptr; //in snapshot mode, the version
+		//this basket is priced against, pinned at its first scan
+	vector<int> groupSlots; //scratch for batches, kept between them: open addressing
+		//index from handle to group + 1
+	vector<BatchGroup> groups;
+	vector<LineRecord> lines; //by quantity store line
+	PriceCache prices; //what the next unit of a product adds to its line, off unless enabled
+	Journal* journal = nullptr; //borrowed, records every change to the basket if set
+	vector<MixPool> pools; //by catalog special index, for mix and match specials
+	vector<int> activePools; //indexes of the pools this basket has used
+	vector<vector<int>> mixPositions; //by line, the positions of its units in its pool
 
-	int calcPrice(int, int, int, shared_ptr<Special>);
-	void incTotal(int);
-	void decTotal(int);
-	void incQuantity(string, int = 0);
-	void decQuantity(string, int = 0);
+	bool add(int, int, int);
+	bool subtract(int, int, int);
+	int batch(const ScanEntry*, size_t, bool*, bool);
+	int groupOf(int, const Catalog*);
+	int unitPrice(int, uint32_t, int, int, const SpecialTerms*);
+	void record(int, const PriceRow&, const SpecialTerms*, int, int, int = -1);
+	int poolOf(int, int, const PriceRow&, const SpecialTerms*) const;
+	int mixAdd(int, int, const SpecialTerms*, uint32_t, int, int);
+	int mixRemove(int, int);
+	void bookRun(const MixPool&, int, int);
+	void movePool(int);
+	void clearPools();
+	void journalBasket();
+	int handleOf(const string&);
+	const Catalog* catalog();
 public:
 	inline int getTotal() const { return total; }
 	inline shared_ptr<Inventory> getInventory() { return productList; }
 	void assignInventory(shared_ptr<Inventory>);
-	inline int getQuantity(string s) { return quantity[s]; }
-	bool scanItem(string, int = 0);
-	bool removeItem(string, int = 0);
+	inline int getRounding() const { return rounding; }
+	inline void setRounding(int r) { rounding = r; prices.clear(); } //applies to later scans and removals
+	inline void setPriceCache(int n) { prices.resize(n); }
+	inline const PriceCache& getPriceCache() const { return prices; }
+	inline void setSnapshotMode(bool m) { snapshotMode = m; pinned = nullptr; }
+	inline unsigned long getSnapshotVersion() const { return pinned ? pinned->getVersion() : 0; }
+	inline void setJournal(Journal* j) { journal = j; }
+	inline Journal* getJournal() const { return journal; }
+	bool recover(const string&);
+	void reset();
+	void reserve(int);
+	inline int getQuantity(int h) const { return quantity.get(h); }
+	inline int getQuantity(const string& s) { return getQuantity(handleOf(s)); }
+	size_t suspendedSize() const;
+	size_t suspend(char*, size_t) const;
+	bool resume(const char*, size_t);
+	inline int getLineCount() const { return quantity.size(); }
+	LineItem getLineItem(int) const;
+	const Catalog* getCatalog() const;
+	bool scanItem(const string&, int = 0);
+	bool scanItem(int, int = 0);
+	bool removeItem(const string&, int = 0);
+	bool removeItem(int, int = 0);
+	bool scanItems(const string&, int);
+	bool scanItems(int, int);
+	bool removeItems(const string&, int);
+	bool removeItems(int, int);
+	int scanBatch(const ScanEntry*, size_t, bool* = nullptr);
+	int removeBatch(const ScanEntry*, size_t, bool* = nullptr);
 };
 
 #endif
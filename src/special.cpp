@@ -1,25 +1,97 @@
 #include "special.h"
+#include "inventory.h"
+
+void Special::setPurchaseQuantity(int p) {
+	terms.purchaseQuantity = p;
+	notify();
+}
+
+void Special::setLimit(int l) {
+	terms.limit = l;
+	notify();
+}
+
+void Special::attach(Inventory* i) {
+	for (Inventory* o : owners) {
+		if (o == i) {
+			return;
+		}
+	}
+	owners.push_back(i);
+}
+
+void Special::detach(Inventory* i) {
+	for (size_t k = 0; k < owners.size(); ++k) {
+		if (owners[k] == i) {
+			owners.erase(owners.begin() + k);
+			return;
+		}
+	}
+}
+
+void Special::notify() {
+	//has every inventory holding the special republish its terms; one may
+	//let go of it while doing so
+	vector<Inventory*> held = owners;
+	for (Inventory* o : held) {
+		o->restate(this);
+	}
+}
 
 SpecialBogo::SpecialBogo(int pq, int dq, int dp, int l) {
-	type = "BOGO";
-	purchaseQuantity = pq;
-	discountQuantity = dq;
-	discountPercentage = dp;
-	limit = l;
+	terms.kind = SPECIAL_BOGO;
+	terms.purchaseQuantity = pq;
+	terms.discountQuantity = dq;
+	terms.discountPercentage = dp;
+	terms.limit = l;
+}
+
+void SpecialBogo::setDiscountQuantity(int d) {
+	terms.discountQuantity = d;
+	notify();
 }
 
 bool SpecialBogo::setDiscountPercentage(int d) {
 	if (d > 100 || d < 0) {
 		return false;
 	}
-	discountPercentage = d;
-
+	terms.discountPercentage = d;
+	notify();
 	return true;
 }
 
+shared_ptr<Special> SpecialBogo::clone() const {
+	return std::make_shared<SpecialBogo>(*this);
+}
+
 SpecialBulk::SpecialBulk(int pq, int dp, int l) {
-	type = "BULK";
-	purchaseQuantity = pq;
-	discountPrice = dp;
-	limit = l;
+	terms.kind = SPECIAL_BULK;
+	terms.purchaseQuantity = pq;
+	terms.discountPrice = dp;
+	terms.limit = l;
+}
+
+void SpecialBulk::setDiscountPrice(int d) {
+	terms.discountPrice = d;
+	notify();
+}
+
+shared_ptr<Special> SpecialBulk::clone() const {
+	return std::make_shared<SpecialBulk>(*this);
+}
+
+SpecialMix::SpecialMix(int pq, int dp, int l) {
+	terms.kind = SPECIAL_MIX;
+	terms.purchaseQuantity = pq;
+	terms.discountPrice = dp;
+	terms.limit = l;
+}
+
+void SpecialMix::setDiscountPrice(int d) {
+	terms.discountPrice = d;
+	notify();
+}
+
+shared_ptr<Special> SpecialMix::clone() const {
+	return std::make_shared<SpecialMix>(*this);
 }
@@ -1,48 +1,91 @@
 #ifndef _SPECIAL_H_
-#define _SPECIAL_H
+#define _SPECIAL_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
+using std::shared_ptr;
 using std::string;
+using std::vector;
 
+class Inventory;
+
+const int SPECIAL_NONE = 0;
+const int SPECIAL_BOGO = 1;
+const int SPECIAL_BULK = 2;
+const int SPECIAL_MIX = 3;
+
+//the pricing terms of a special as plain data, read by the pricing kernels
+//without virtual calls; fields a kind doesn't use are 0
+struct SpecialTerms {
+	int kind = SPECIAL_NONE;
+	int purchaseQuantity = 0;
+	int discountQuantity = 0; //BOGO
+	int discountPercentage = 0; //BOGO, represents percent off, from 0 to 100
+	int discountPrice = 0; //BULK and MIX
+	int limit = 0;
+};
+
+//scans read a special's terms from an inventory's catalog slot without
+//locking, so a slot's terms never change while a row refers to it. a
+//setter called once inventories price with the special has each of them
+//republish it: its rows move to a new slot holding the new terms, as they
+//would to a changed clone assigned to its products
 class Special {
+private:
+	vector<Inventory*> owners; //inventories holding its terms in a catalog slot
+
+	void attach(Inventory*);
+	void detach(Inventory*);
+	friend class Inventory;
 protected:
-	string type;
-	int purchaseQuantity;
-	int limit;
+	SpecialTerms terms;
+	void notify();
 public:
-	inline string getSpecialType() const { return type; }
-	inline int getPurchaseQuantity() const { return purchaseQuantity; }
-	inline void setPurchaseQuantity(int p) { purchaseQuantity = p; }
-	inline int getLimit() const { return limit; }
-	inline void setLimit(int l) { limit = l; }
-	virtual inline int getDiscountQuantity() const { return 0; }
+	Special() = default;
+	Special(const Special& o) : terms(o.terms) { } //a copy is held by no inventory
+	Special& operator=(const Special&) = delete;
+	virtual ~Special() { }
+	inline const SpecialTerms& getTerms() const { return terms; }
+	inline bool getAttached() const { return !owners.empty(); }
+	inline string getSpecialType() const { return terms.kind == SPECIAL_BOGO ? "BOGO" : terms.kind == SPECIAL_BULK ? "BULK" : "MIX"; }
+	inline int getPurchaseQuantity() const { return terms.purchaseQuantity; }
+	void setPurchaseQuantity(int);
+	inline int getLimit() const { return terms.limit; }
+	void setLimit(int);
+	inline int getDiscountQuantity() const { return terms.discountQuantity; }
 	virtual inline void setDiscountQuantity(int) { }
-	virtual inline int getDiscountPercentage() const { return 0; }
+	inline int getDiscountPercentage() const { return terms.discountPercentage; }
 	virtual inline bool setDiscountPercentage(int) { return false; }
-	virtual inline int getDiscountPrice() const { return 0; }
+	inline int getDiscountPrice() const { return terms.discountPrice; }
 	virtual inline void setDiscountPrice(int) { }
+	virtual shared_ptr<Special> clone() const = 0;
 };
 
 class SpecialBogo : public Special {
-private:
-	int discountQuantity = 0;
-	int discountPercentage = 0; //represents percent off, from 0 to 100
 public:
 	SpecialBogo(int, int, int, int = 0);
-	inline int getDiscountQuantity() const override { return discountQuantity; }
-	inline void setDiscountQuantity(int d) override { discountQuantity = d; }
-	inline int getDiscountPercentage() const override { return discountPercentage; }
+	void setDiscountQuantity(int) override;
 	bool setDiscountPercentage(int) override;
+	shared_ptr<Special> clone() const override;
 };
 
 class SpecialBulk : public Special {
-private:
-	int discountPrice = 0;
 public:
 	SpecialBulk(int, int, int = 0);
-	inline int getDiscountPrice() const override { return discountPrice; }
-	inline void setDiscountPrice(int d) override { discountPrice = d; }
+	void setDiscountPrice(int) override;
+	shared_ptr<Special> clone() const override;
+};
+
+//mix and match: any purchaseQuantity units of the products this one special
+//object is assigned to sell for discountPrice, whichever products they are.
+//a register counts them in one pool per special (see MixPool)
+class SpecialMix : public Special {
+public:
+	SpecialMix(int, int, int = 0);
+	void setDiscountPrice(int) override;
+	shared_ptr<Special> clone() const override;
 };
 
 #endif
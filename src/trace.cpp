@@ -0,0 +1,250 @@
+#include "trace.h"
+#include "fields.h"
+#include "register.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace {
+
+struct Scan {
+	int product;
+	int weight;
+};
+
+}
+
+TraceGenerator::TraceGenerator(const TraceConfig& c) : config(c) {
+}
+
+string TraceGenerator::productName(int i) {
+	return "sku" + std::to_string(i);
+}
+
+bool TraceGenerator::write(const string& pricePath, const string& tracePath) {
+	//writes the price file then the sessions; false if either can't be written
+	std::mt19937 rng(config.seed);
+	std::uniform_real_distribution<double> unit(0, 1);
+	int skus = std::max(config.skus, 1);
+
+	FILE* prices = fopen(pricePath.c_str(), "w");
+	if (!prices) {
+		return false;
+	}
+	vector<bool> byWeight(skus);
+	fprintf(prices, "name,price,byWeight,markdown,special\n");
+	for (int i = 0; i < skus; ++i) {
+		byWeight[i] = unit(rng) < config.weightedRatio;
+		int price = 49 + rng() % 1950;
+		int markdown = rng() % 10 == 0 ? price / 10 : 0;
+		fprintf(prices, "%s,%d,%d,%d", productName(i).c_str(), price, byWeight[i] ? 1 : 0, markdown);
+		if (unit(rng) < config.specialRatio) {
+			int limit = rng() % 4 == 0 ? (byWeight[i] ? 500 : 6) : 0;
+			if (byWeight[i] || rng() % 2 == 0) {
+				fprintf(prices, ",BOGO,%d,1,%d,%d", 1 + (int) (rng() % 3), 25 * (1 + (int) (rng() % 4)), limit);
+			}
+			else {
+				int quantity = 2 + rng() % 4;
+				fprintf(prices, ",BULK,%d,%d,%d", quantity, (price - markdown) * quantity * 3 / 4, limit);
+			}
+		}
+		fputc('\n', prices);
+	}
+	bool ok = fclose(prices) == 0;
+
+	//popularity ranks are scattered over the catalog so popular products
+	//aren't neighbours in it
+	vector<double> cdf(skus);
+	double sum = 0;
+	for (int r = 0; r < skus; ++r) {
+		sum += 1 / std::pow(r + 1, config.zipfSkew);
+		cdf[r] = sum;
+	}
+	vector<int> rankToProduct(skus);
+	for (int i = 0; i < skus; ++i) {
+		rankToProduct[i] = i;
+	}
+	std::shuffle(rankToProduct.begin(), rankToProduct.end(), rng);
+	std::uniform_real_distribution<double> popularity(0, sum);
+	std::geometric_distribution<int> basketSize(1.0 / std::max(config.basketMean, 1));
+	std::uniform_int_distribution<int> weight(10, 500);
+
+	FILE* trace = fopen(tracePath.c_str(), "w");
+	if (!trace) {
+		return false;
+	}
+	vector<Scan> basket;
+	for (int s = 0; s < config.sessions; ++s) {
+		fputs("B\n", trace);
+		basket.clear();
+		int items = std::min(1 + basketSize(rng), std::max(config.basketMax, 1));
+		for (int k = 0; k < items; ++k) {
+			int p = rankToProduct[std::lower_bound(cdf.begin(), cdf.end(), popularity(rng)) - cdf.begin()];
+			Scan scan = {p, byWeight[p] ? weight(rng) : 0};
+			basket.push_back(scan);
+			if (scan.weight) {
+				fprintf(trace, "S,%s,%d\n", productName(p).c_str(), scan.weight);
+			}
+			else {
+				fprintf(trace, "S,%s\n", productName(p).c_str());
+			}
+			if (unit(rng) < config.removalRate) {
+				//the customer changes their mind about something already scanned
+				size_t i = rng() % basket.size();
+				Scan removed = basket[i];
+				basket[i] = basket.back();
+				basket.pop_back();
+				if (removed.weight) {
+					fprintf(trace, "R,%s,%d\n", productName(removed.product).c_str(), removed.weight);
+				}
+				else {
+					fprintf(trace, "R,%s\n", productName(removed.product).c_str());
+				}
+			}
+		}
+		fputs("E\n", trace);
+	}
+	return fclose(trace) == 0 && ok;
+}
+
+TraceReplay::TraceReplay(shared_ptr<Inventory> inv) : inventory(inv) {
+}
+
+bool TraceReplay::load(const string& path) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	vector<char> buffer;
+	char chunk[1 << 16];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		buffer.insert(buffer.end(), chunk, chunk + n);
+	}
+	bool ok = !ferror(f);
+	fclose(f);
+	parse(buffer.data(), buffer.size());
+	return ok;
+}
+
+void TraceReplay::parse(const char* data, size_t length) {
+	//appends the sessions in a trace, resolving product names to handles
+	//once up front so a replay measures only the registers. events outside
+	//a B ... E pair and lines that can't be read are counted as malformed
+	const char* end = data + length;
+	bool open = false;
+	for (const char* p = data; p < end; ) {
+		const char* eol = (const char*) memchr(p, '\n', end - p);
+		if (!eol) {
+			eol = end;
+		}
+		const char* line = p;
+		p = eol + 1;
+		if (line == eol) {
+			continue;
+		}
+		if (*line == 'B' && line + 1 == eol) {
+			if (open) {
+				++malformed;
+				events.resize(sessionStarts.back());
+			}
+			if (sessionStarts.empty()) {
+				sessionStarts.push_back(0);
+			}
+			open = true;
+			continue;
+		}
+		if (*line == 'E' && line + 1 == eol && open) {
+			sessionStarts.push_back(events.size());
+			open = false;
+			continue;
+		}
+		if (!open || (*line != 'S' && *line != 'R') || line + 2 > eol || line[1] != ',') {
+			++malformed;
+			continue;
+		}
+		const char* name = line + 2;
+		const char* comma = (const char*) memchr(name, ',', eol - name);
+		const char* nameEnd = comma ? comma : eol;
+		Event e;
+		e.op = *line;
+		e.handle = inventory->getHandle(name, nameEnd - name);
+		e.weight = 0;
+		const char* q = nameEnd;
+		if (comma && (!parseField(q, eol, e.weight) || q != eol)) {
+			++malformed;
+			continue;
+		}
+		events.push_back(e);
+	}
+	if (open) {
+		//a trace cut off mid session
+		++malformed;
+		events.resize(sessionStarts.back());
+	}
+}
+
+ReplayResult TraceReplay::run(int threads) const {
+	//plays every session on the given number of threads, each with its own
+	//register, and reports throughput, session latency and totals
+	ReplayResult result;
+	size_t sessions = getSessions();
+	result.sessions = sessions;
+	result.events = events.size();
+	result.totals.assign(sessions, 0);
+	threads = std::max(threads, 1);
+	std::atomic<size_t> next(0);
+	std::atomic<long long> rejected(0);
+	vector<vector<double>> latencies(threads);
+	auto start = std::chrono::steady_clock::now();
+	vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			Register reg;
+			reg.assignInventory(inventory);
+			reg.reserve(256);
+			long long refused = 0;
+			for (size_t s = next++; s < sessions; s = next++) {
+				auto begin = std::chrono::steady_clock::now();
+				reg.reset();
+				for (size_t i = sessionStarts[s]; i < sessionStarts[s + 1]; ++i) {
+					const Event& e = events[i];
+					bool ok = e.op == 'S' ? reg.scanItem(e.handle, e.weight) : reg.removeItem(e.handle, e.weight);
+					refused += !ok;
+				}
+				result.totals[s] = reg.getTotal();
+				latencies[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+			}
+			rejected += refused;
+		});
+	}
+	for (std::thread& w : workers) {
+		w.join();
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.rejected = rejected;
+
+	vector<double> all;
+	for (const vector<double>& l : latencies) {
+		all.insert(all.end(), l.begin(), l.end());
+	}
+	std::sort(all.begin(), all.end());
+	if (!all.empty()) {
+		result.sessionP50 = all[(size_t) (0.5 * (all.size() - 1))];
+		result.sessionP99 = all[(size_t) (0.99 * (all.size() - 1))];
+		result.sessionP999 = all[(size_t) (0.999 * (all.size() - 1))];
+	}
+	uint64_t h = 14695981039346656037ull;
+	for (int total : result.totals) {
+		result.totalCents += total;
+		h = (h ^ (uint32_t) total) * 1099511628211ull;
+	}
+	result.checksum = h;
+	return result;
+}
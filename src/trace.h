@@ -0,0 +1,83 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include "inventory.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+//shape of the synthetic store traffic written by TraceGenerator
+struct TraceConfig {
+	int skus = 10000;
+	int sessions = 10000;
+	double zipfSkew = 1.0; //product of popularity rank r is picked with probability proportional to 1 / r^zipfSkew
+	double weightedRatio = 0.1; //share of products sold by weight
+	double specialRatio = 0.2; //share of products with a BOGO or BULK special
+	double removalRate = 0.03; //chance each scan is followed by removing an item already in the basket
+	int basketMean = 30; //basket sizes in items follow a geometric distribution with this mean,
+	int basketMax = 200; //capped here
+	unsigned seed = 1;
+};
+
+//writes a price file in the CsvImporter format and a trace of basket
+//sessions against it, one event per line:
+//	B			start a basket
+//	S,name[,weight]		scan an item, weight in hundredths of a pound for weighed products
+//	R,name[,weight]		remove an item
+//	E			check out
+//the same config and seed always give the same files
+class TraceGenerator {
+private:
+	TraceConfig config;
+public:
+	TraceGenerator(const TraceConfig&);
+	bool write(const string&, const string&);
+	static string productName(int);
+};
+
+//what a replay measured. totals are per session in trace order, whatever
+//the number of threads, so two engines can be compared line for line
+struct ReplayResult {
+	long long sessions = 0;
+	long long events = 0;
+	long long rejected = 0; //events the register refused
+	double seconds = 0;
+	double sessionP50 = 0; //microseconds per session
+	double sessionP99 = 0;
+	double sessionP999 = 0;
+	long long totalCents = 0;
+	uint64_t checksum = 0; //over the session totals in trace order
+	vector<int> totals;
+	inline double getEventsPerSecond() const { return seconds > 0 ? events / seconds : 0; }
+};
+
+//loads a trace against an inventory and plays its sessions through one
+//Register per thread, sessions handed out to whichever thread is free
+class TraceReplay {
+private:
+	struct Event {
+		int op; //'S' or 'R'
+		int handle; //-1 if the trace names a product the inventory doesn't have
+		int weight;
+	};
+	shared_ptr<Inventory> inventory;
+	vector<Event> events;
+	vector<size_t> sessionStarts; //session i is events[sessionStarts[i], sessionStarts[i + 1])
+	long malformed = 0;
+public:
+	TraceReplay(shared_ptr<Inventory>);
+	bool load(const string&);
+	void parse(const char*, size_t);
+	inline size_t getSessions() const { return sessionStarts.empty() ? 0 : sessionStarts.size() - 1; }
+	inline size_t getEvents() const { return events.size(); }
+	inline long getMalformed() const { return malformed; }
+	ReplayResult run(int) const;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "catch.hpp"
+#include "catalog.h"
+
+#include <string>
+
+using std::string;
+using std::to_string;
+
+TEST_CASE("catalog maps product names to dense handles with an open addressing index", "[catalog]") {
+	Catalog testCatalog;
+	PriceRow row;
+	row.price = 129;
+	row.markdown = 20;
+
+	SECTION("insert returns handles assigned densely from 0 and find returns the handle for a name") {
+		REQUIRE(testCatalog.insert("apple", row) == 0);
+		REQUIRE(testCatalog.insert("pear", row) == 1);
+
+		REQUIRE(testCatalog.find("apple") == 0);
+		REQUIRE(testCatalog.find("pear") == 1);
+		REQUIRE(testCatalog.size() == 2);
+	}
+	SECTION("insert returns -1 and leaves the catalog unchanged when the name is already present") {
+		testCatalog.insert("apple", row);
+
+		REQUIRE(testCatalog.insert("apple", PriceRow()) == -1);
+		REQUIRE(testCatalog.size() == 1);
+		REQUIRE(testCatalog.getRow(0).price == 129);
+	}
+	SECTION("find returns -1 for a name that isn't in the catalog, including prefixes of present names") {
+		testCatalog.insert("apple", row);
+
+		REQUIRE(testCatalog.find("app") == -1);
+		REQUIRE(testCatalog.find("apples") == -1);
+		REQUIRE(testCatalog.find("") == -1);
+	}
+	SECTION("find accepts a pointer and length without requiring a string object") {
+		testCatalog.insert("kiwi", row);
+		const char* buffer = "kiwi fruit";
+
+		REQUIRE(testCatalog.find(buffer, 4) == 0);
+		REQUIRE(testCatalog.find(buffer, 10) == -1);
+	}
+	SECTION("rows and names are stored by handle and rows can be updated in place") {
+		int h = testCatalog.insert("plum", row);
+		PriceRow updated = testCatalog.getRow(h);
+		updated.price = 99;
+		testCatalog.setRow(h, updated);
+
+		REQUIRE(testCatalog.getName(h) == "plum");
+		REQUIRE(testCatalog.getRow(h).price == 99);
+		REQUIRE(testCatalog.getRow(h).markdown == 20);
+		REQUIRE(testCatalog.getRow(h).special == -1);
+	}
+	SECTION("erase stops a name resolving and marks its row erased, and the handle goes back only to the same name") {
+		testCatalog.insert("fig", row);
+		testCatalog.insert("date", row);
+		testCatalog.erase(0);
+
+		REQUIRE(testCatalog.find("fig") == -1);
+		REQUIRE(testCatalog.find("date") == 1);
+		REQUIRE(testCatalog.getRow(0).erased);
+		REQUIRE(testCatalog.getRow(0).price == 129);
+		REQUIRE_FALSE(testCatalog.erase(0));
+		REQUIRE(testCatalog.insert("plum", row) == 2);
+
+		PriceRow replaced;
+		row.price = 99;
+
+		REQUIRE(testCatalog.insert("fig", row, &replaced) == 0);
+		REQUIRE(replaced.erased);
+		REQUIRE(replaced.price == 129);
+		REQUIRE(testCatalog.find("fig") == 0);
+		REQUIRE_FALSE(testCatalog.getRow(0).erased);
+		REQUIRE(testCatalog.getRow(0).price == 99);
+		REQUIRE(testCatalog.size() == 3);
+	}
+	SECTION("erasing and inserting the same names again doesn't grow the catalog") {
+		for (int i = 0; i < 100; ++i) {
+			testCatalog.insert("sku" + to_string(i), row);
+		}
+		for (int round = 0; round < 200; ++round) {
+			for (int i = round % 2; i < 100; i += 2) {
+				testCatalog.erase(testCatalog.find("sku" + to_string(i)));
+			}
+			for (int i = round % 2; i < 100; i += 2) {
+				row.price = round;
+				testCatalog.insert("sku" + to_string(i), row);
+			}
+		}
+		bool allFound = true;
+		for (int i = 0; i < 100; ++i) {
+			int h = testCatalog.find("sku" + to_string(i));
+			allFound = allFound && h == i && testCatalog.getRow(h).price == (i % 2 ? 199 : 198);
+		}
+
+		REQUIRE(allFound);
+		REQUIRE(testCatalog.size() == 100);
+	}
+	SECTION("every name stays reachable after the index grows") {
+		for (int i = 0; i < 5000; ++i) {
+			row.price = i;
+			testCatalog.insert("sku" + to_string(i), row);
+		}
+		bool allFound = true;
+		for (int i = 0; i < 5000; ++i) {
+			int h = testCatalog.find("sku" + to_string(i));
+			allFound = allFound && h == i && testCatalog.getRow(h).price == i;
+		}
+
+		REQUIRE(allFound);
+		REQUIRE(testCatalog.find("sku5000") == -1);
+
+		for (int i = 0; i < 5000; i += 2) {
+			testCatalog.erase(i);
+		}
+		for (int i = 0; i < 3000; ++i) {
+			testCatalog.insert("new" + to_string(i), row);
+		}
+		allFound = true;
+		for (int i = 0; i < 5000; ++i) {
+			allFound = allFound && testCatalog.find("sku" + to_string(i)) == (i % 2 == 0 ? -1 : i);
+		}
+
+		REQUIRE(allFound);
+		REQUIRE(testCatalog.find("new2999") == 7999);
+	}
+}
+
+TEST_CASE("a replaced table is freed once no reader that began before the replacement is still reading", "[catalog]") {
+	Catalog testCatalog;
+	PriceRow row;
+	row.price = 250;
+	testCatalog.insert("oat", row);
+
+	SECTION("with no reader running, growing frees the old table at once") {
+		for (int i = 0; i < 1000; ++i) {
+			testCatalog.insert("sku" + to_string(i), row);
+		}
+
+		REQUIRE(testCatalog.retiredTables() == 0);
+	}
+	SECTION("a reader keeps the tables it may hold, and the next change after it ends frees them") {
+		size_t length;
+		const char* name;
+		{
+			Catalog::Reader pin;
+			name = testCatalog.getName(0, &length);
+			for (int i = 0; i < 1000; ++i) {
+				testCatalog.insert("sku" + to_string(i), row);
+			}
+
+			REQUIRE(testCatalog.retiredTables() > 0);
+			REQUIRE(string(name, length) == "oat");
+		}
+		testCatalog.setRow(0, row);
+
+		REQUIRE(testCatalog.retiredTables() == 0);
+		REQUIRE(testCatalog.getName(0) == "oat");
+	}
+	SECTION("a reader beginning after a replacement doesn't hold back the table it replaced") {
+		testCatalog.reserve(100);
+		Catalog::Reader pin;
+
+		REQUIRE(testCatalog.retiredTables() == 0);
+
+		testCatalog.reserve(1000);
+
+		REQUIRE(testCatalog.retiredTables() == 1);
+		REQUIRE(testCatalog.getRow(testCatalog.find("oat")).price == 250);
+	}
+}
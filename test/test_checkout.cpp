@@ -0,0 +1,124 @@
+#include "catch.hpp"
+#include "checkout.h"
+#include "inventory.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+shared_ptr<Inventory> checkoutInventory() {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	for (int i = 0; i < 40; ++i) {
+		shared_ptr<Product> p = make_shared<Product>("item " + std::to_string(i), 100 + 7 * i, i % 8 == 0);
+		if (i % 5 == 1) {
+			p->assignSpecial(make_shared<SpecialBogo>(2, 1, 50));
+		}
+		else if (i % 5 == 2) {
+			p->assignSpecial(make_shared<SpecialBulk>(3, 250 + i));
+		}
+		inv->insert(p);
+	}
+	return inv;
+}
+
+vector<CheckoutEvent> laneEvents(int seed, int n) {
+	//scans and removals whose outcome depends on their order, with the odd reset
+	std::mt19937 rng(seed);
+	vector<CheckoutEvent> events;
+	for (int i = 0; i < n; ++i) {
+		int h = rng() % 40;
+		int w = h % 8 == 0 ? 50 + rng() % 100 : 0;
+		int r = rng() % 20;
+		events.push_back(CheckoutEvent(r == 0 ? CHECKOUT_RESET : r < 7 ? CHECKOUT_REMOVE : CHECKOUT_SCAN, h, w));
+	}
+	return events;
+}
+
+}
+
+TEST_CASE("CheckoutEngine applies each lane's events in order, giving the same baskets as one register per lane", "[checkout]") {
+	shared_ptr<Inventory> inv = checkoutInventory();
+	int laneCount = 24;
+	CheckoutEngine engine(inv, laneCount, 4);
+	vector<vector<CheckoutEvent>> events;
+	for (int l = 0; l < laneCount; ++l) {
+		events.push_back(laneEvents(l, 500));
+	}
+
+	//lanes are fed by several threads at once, each in small bursts
+	vector<std::thread> feeders;
+	for (int f = 0; f < 3; ++f) {
+		feeders.emplace_back([&, f] {
+			for (size_t i = 0; i < 500; i += 5) {
+				for (int l = f; l < laneCount; l += 3) {
+					engine.submit(l, &events[l][i], 5);
+				}
+			}
+		});
+	}
+	for (std::thread& t : feeders) {
+		t.join();
+	}
+	engine.drain();
+
+	REQUIRE(engine.getApplied() == laneCount * 500);
+	for (int l = 0; l < laneCount; ++l) {
+		Register expected;
+		expected.assignInventory(inv);
+		long long rejected = 0;
+		for (const CheckoutEvent& e : events[l]) {
+			if (e.op == CHECKOUT_SCAN) {
+				rejected += !expected.scanItem(e.handle, e.weight);
+			}
+			else if (e.op == CHECKOUT_REMOVE) {
+				rejected += !expected.removeItem(e.handle, e.weight);
+			}
+			else {
+				expected.reset();
+			}
+		}
+
+		REQUIRE(engine.getRegister(l).getTotal() == expected.getTotal());
+		REQUIRE(engine.getRejected(l) == rejected);
+		for (int h = 0; h < 40; ++h) {
+			REQUIRE(engine.getRegister(l).getQuantity(h) == expected.getQuantity(h));
+		}
+	}
+}
+
+TEST_CASE("CheckoutEngine refuses events for lanes it doesn't have and can be drained repeatedly", "[checkout]") {
+	shared_ptr<Inventory> inv = checkoutInventory();
+	CheckoutEngine engine(inv, 2, 2);
+
+	REQUIRE(engine.getLanes() == 2);
+	REQUIRE(engine.getWorkers() == 2);
+	REQUIRE(engine.submit(2, CheckoutEvent(CHECKOUT_SCAN, 1)) == false);
+	REQUIRE(engine.submit(-1, CheckoutEvent(CHECKOUT_SCAN, 1)) == false);
+
+	engine.drain();
+	engine.submit(0, CheckoutEvent(CHECKOUT_SCAN, 3));
+	engine.submit(0, CheckoutEvent(CHECKOUT_REMOVE, 4));
+	engine.drain();
+
+	REQUIRE(engine.getRegister(0).getTotal() == 121);
+	REQUIRE(engine.getRejected(0) == 1);
+
+	engine.submit(0, CheckoutEvent(CHECKOUT_RESET));
+	engine.submit(1, CheckoutEvent(CHECKOUT_SCAN, 3));
+	engine.drain();
+
+	REQUIRE(engine.getRegister(0).getTotal() == 0);
+	REQUIRE(engine.getRegister(1).getTotal() == 121);
+}
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+#include "delta.h"
+#include "inventory.h"
+#include "product.h"
+#include "register.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::to_string;
+using std::vector;
+
+TEST_CASE("DeltaApplier applies a feed of price changes to an inventory and reports rejected lines with their line numbers", "[delta]") {
+	Inventory testInventory;
+	testInventory.insert(make_shared<Product>("coffee", 899));
+	testInventory.insert(make_shared<Product>("tea", 499));
+	DeltaApplier applier(2);
+	string feed =
+		"U,cocoa,599,0,0\n"
+		"P,coffee,949\r\n"
+		"M,coffee,100\n"
+		"\n"
+		"S,tea,BOGO,2,1,50\n"
+		"S,cocoa,BULK,3,1500,6\n"
+		"M,tea,499\n"
+		"P,matcha,1299\n"
+		"Q,tea\n"
+		"P,tea,abc\n"
+		"U,chai,399,2,0\n"
+		"D,tea\n"
+		"X,cocoa\n";
+	applier.parse(feed.data(), feed.size(), testInventory);
+
+	SECTION("accepted changes are applied in feed order") {
+		REQUIRE(applier.getApplied() == 7);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("coffee")).price == 949);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("coffee")).markdown == 100);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("cocoa")).price == 599);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("cocoa")).special == -1);
+		REQUIRE(testInventory.getHandle("tea") == -1);
+	}
+	SECTION("rejected lines are reported in feed order with 1 based line numbers and a reason") {
+		const vector<ImportReject>& rejects = applier.getRejects();
+
+		REQUIRE(rejects.size() == 5);
+		REQUIRE(rejects[0].line == 7);
+		REQUIRE(rejects[0].reason == "markdown must be less than price");
+		REQUIRE(rejects[1].line == 8);
+		REQUIRE(rejects[1].reason == "unknown product");
+		REQUIRE(rejects[2].line == 9);
+		REQUIRE(rejects[2].reason == "unknown change type");
+		REQUIRE(rejects[3].line == 10);
+		REQUIRE(rejects[4].line == 11);
+		REQUIRE(rejects[4].reason == "byWeight must be 0 or 1");
+	}
+}
+
+TEST_CASE("DeltaApplier shares one special object between identical special definitions and within a MIX group", "[delta]") {
+	Inventory testInventory;
+	testInventory.insert(make_shared<Product>("pasta", 199));
+	testInventory.insert(make_shared<Product>("sauce", 349));
+	DeltaApplier applier;
+	string feed = "S,pasta,BULK,2,300\nS,sauce,BULK,2,300\n";
+	applier.parse(feed.data(), feed.size(), testInventory);
+
+	REQUIRE(testInventory.retrieve("pasta")->getSpecial() == testInventory.retrieve("sauce")->getSpecial());
+	REQUIRE(testInventory.retrieve("pasta")->getSpecial()->getDiscountPrice() == 300);
+
+	testInventory.insert(make_shared<Product>("pesto", 449));
+	feed = "S,pasta,MIX,1,2,500\nS,sauce,MIX,2,2,500\nS,pesto,MIX,1,2,500\nS,sauce,MIX,1,3,500\n";
+	applier.parse(feed.data(), feed.size(), testInventory);
+
+	REQUIRE(testInventory.retrieve("pasta")->getSpecial() == testInventory.retrieve("pesto")->getSpecial());
+	REQUIRE(testInventory.retrieve("pasta")->getSpecial() != testInventory.retrieve("sauce")->getSpecial());
+	REQUIRE(applier.getRejects().size() == 1);
+	REQUIRE(applier.getRejects()[0].line == 4);
+	REQUIRE(applier.getRejects()[0].reason == "MIX group listed with other terms");
+}
+
+TEST_CASE("DeltaApplier load reads a feed from disk", "[delta]") {
+	Inventory testInventory;
+	string path = "test_delta_feed.tmp";
+	FILE* f = fopen(path.c_str(), "w");
+	fputs("U,salt,99,0,0\nU,pepper,299,0,0\n", f);
+	fclose(f);
+	DeltaApplier applier;
+
+	REQUIRE(applier.load(path, testInventory) == true);
+	REQUIRE(testInventory.size() == 2);
+	REQUIRE(applier.load("no_such_feed.tmp", testInventory) == false);
+	remove(path.c_str());
+}
+
+TEST_CASE("registers scanning on other threads see every applied price change whole while a feed is applied", "[delta][register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	for (int i = 0; i < 100; ++i) {
+		testInventoryPtr->insert(make_shared<Product>("item" + to_string(i), 1000));
+	}
+	std::atomic<bool> done(false);
+	std::atomic<int> torn(0);
+	vector<std::thread> scanners;
+	for (int t = 0; t < 4; ++t) {
+		scanners.push_back(std::thread([&testInventoryPtr, &done, &torn, t]() {
+			//every update below keeps price - markdown at 900
+			Register r;
+			r.assignInventory(testInventoryPtr);
+			int i = t;
+			while (!done.load()) {
+				r.reset();
+				r.scanItem(i % 100);
+				if (r.getTotal() != 900 && r.getTotal() != 1000) {
+					++torn;
+				}
+				++i;
+			}
+		}));
+	}
+	string feed;
+	for (int i = 0; i < 100; ++i) {
+		feed += "M,item" + to_string(i) + ",100\n";
+	}
+	DeltaApplier applier(16);
+	applier.parse(feed.data(), feed.size(), *testInventoryPtr);
+	for (int round = 0; round < 50; ++round) {
+		feed.clear();
+		for (int i = 0; i < 100; ++i) {
+			int price = 1000 + round * 10 + i;
+			feed += "U,item" + to_string(i) + "," + to_string(price) + ",0," + to_string(price - 900) + "\n";
+		}
+		applier.parse(feed.data(), feed.size(), *testInventoryPtr);
+	}
+	done = true;
+	for (std::thread& s : scanners) {
+		s.join();
+	}
+
+	REQUIRE(applier.getRejects().empty());
+	REQUIRE(applier.getApplied() == 5100);
+	REQUIRE(torn == 0);
+}
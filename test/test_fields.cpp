@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "fields.h"
+
+#include <cstring>
+#include <string>
+
+using std::string;
+
+TEST_CASE("parseInt and parseField read comma separated integers, stopping at the next comma", "[fields]") {
+	const char* text = "42,-7,x,99999999999";
+	const char* end = text + strlen(text);
+	const char* p = text;
+	int v = 0;
+
+	REQUIRE(parseInt(p, end, v) == true);
+	REQUIRE(v == 42);
+	REQUIRE(parseField(p, end, v) == true);
+	REQUIRE(v == -7);
+	REQUIRE(parseField(p, end, v) == false);
+	p = text + 8;
+	REQUIRE(parseField(p, end, v) == false);
+	REQUIRE(parseField(p, p, v) == false);
+}
+
+TEST_CASE("parseSpecial reads a BOGO, BULK or MIX definition and returns the reason one is rejected", "[fields]") {
+	SpecialTerms s;
+	int group = -1;
+	string line = ",BOGO,2,1,50,6";
+	const char* p = line.data();
+
+	REQUIRE(parseSpecial(p, line.data() + line.size(), s, group) == nullptr);
+	REQUIRE(s.kind == SPECIAL_BOGO);
+	REQUIRE(s.purchaseQuantity == 2);
+	REQUIRE(s.discountQuantity == 1);
+	REQUIRE(s.discountPercentage == 50);
+	REQUIRE(s.limit == 6);
+
+	line = ",BULK,3,500";
+	p = line.data();
+
+	REQUIRE(parseSpecial(p, line.data() + line.size(), s, group) == nullptr);
+	REQUIRE(s.kind == SPECIAL_BULK);
+	REQUIRE(s.discountPrice == 500);
+	REQUIRE(s.limit == 0);
+	REQUIRE(group == 0);
+
+	line = ",MIX,7,3,500,6";
+	p = line.data();
+
+	REQUIRE(parseSpecial(p, line.data() + line.size(), s, group) == nullptr);
+	REQUIRE(s.kind == SPECIAL_MIX);
+	REQUIRE(group == 7);
+	REQUIRE(s.purchaseQuantity == 3);
+	REQUIRE(s.discountPrice == 500);
+	REQUIRE(s.limit == 6);
+
+	line = ",MIX,-1,3,500";
+	p = line.data();
+
+	REQUIRE(string(parseSpecial(p, line.data() + line.size(), s, group)) == "negative MIX group");
+
+	line = ",BOGO,1,1,101";
+	p = line.data();
+
+	REQUIRE(string(parseSpecial(p, line.data() + line.size(), s, group)) == "discountPercentage must be between 0 and 100");
+
+	line = ",BULK,3,500,2,1";
+	p = line.data();
+
+	REQUIRE(string(parseSpecial(p, line.data() + line.size(), s, group)) == "unexpected trailing fields");
+}
+
+TEST_CASE("SpecialFactory hands out one shared special per distinct definition and one per MIX group", "[fields]") {
+	SpecialFactory factory;
+	SpecialTerms bulk;
+	bulk.kind = SPECIAL_BULK;
+	bulk.purchaseQuantity = 3;
+	bulk.discountPrice = 500;
+	SpecialTerms other = bulk;
+	other.limit = 6;
+
+	REQUIRE(factory.make(SpecialTerms()) == nullptr);
+	REQUIRE(factory.make(bulk) == factory.make(bulk));
+	REQUIRE(factory.make(bulk) != factory.make(other));
+	REQUIRE(factory.make(other)->getSpecialType() == "BULK");
+	REQUIRE(factory.make(other)->getLimit() == 6);
+
+	SpecialTerms mix;
+	mix.kind = SPECIAL_MIX;
+	mix.purchaseQuantity = 3;
+	mix.discountPrice = 500;
+
+	REQUIRE(factory.make(mix, 1) == factory.make(mix, 1));
+	REQUIRE(factory.make(mix, 1) != factory.make(mix, 2));
+	mix.limit = 6;
+	REQUIRE(factory.make(mix, 1) == nullptr);
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "fuzz.h"
+#include "pricing.h"
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+FuzzProduct fuzzProduct(int price, bool byWeight = false) {
+	FuzzProduct p;
+	p.price = price;
+	p.markdown = 0;
+	p.byWeight = byWeight;
+	return p;
+}
+
+void forgetsLimits(const FuzzCase& c, vector<int>& totals) {
+	//an engine with a bug to find: it ignores every special's limit
+	FuzzCase unlimited = c;
+	for (FuzzProduct& p : unlimited.products) {
+		p.terms.limit = 0;
+	}
+	PricingFuzzer::reference(unlimited, totals);
+}
+
+}
+
+TEST_CASE("the fuzzing reference prices baskets as the register's documented rules do", "[fuzz]") {
+	FuzzCase c;
+	c.products.push_back(fuzzProduct(399));
+	c.products[0].terms.kind = SPECIAL_BOGO;
+	c.products[0].terms.purchaseQuantity = 1;
+	c.products[0].terms.discountQuantity = 1;
+	c.products[0].terms.discountPercentage = 50;
+	c.products[0].terms.limit = 2;
+	c.products.push_back(fuzzProduct(249, true));
+	c.products.push_back(fuzzProduct(100));
+	c.products[2].terms.kind = SPECIAL_BULK;
+	c.products[2].terms.purchaseQuantity = 3;
+	c.products[2].terms.discountPrice = 250;
+	c.ops = {
+		{FUZZ_SCAN, 0, 0}, {FUZZ_SCAN, 0, 0}, {FUZZ_SCAN, 0, 0},
+		{FUZZ_SCAN, 1, 0}, {FUZZ_SCAN, 1, 150},
+		{FUZZ_SCAN_N, 2, 4}, {FUZZ_REMOVE_N, 2, 5}, {FUZZ_REMOVE, 2, 0},
+		{FUZZ_SCAN, 3, 0}, {FUZZ_REMOVE, 1, 151}
+	};
+	vector<int> totals;
+	PricingFuzzer::reference(c, totals);
+	//half of 399 is 199.5 and 1.5 lb at 2.49 is 373.5, both rounding up
+	REQUIRE(totals == vector<int>({399, 599, 998, 998, 1372, 1722, 1722, 1622, 1622, 1622}));
+	c.rounding = ROUND_HALF_EVEN;
+	totals.clear();
+	PricingFuzzer::reference(c, totals);
+	//and still up under banker's rounding, as 199 and 373 are odd
+	REQUIRE(totals[4] == 1372);
+	c.products[1].price = 248;
+	c.products[1].markdown = 1;
+	c.products[0].markdown = 2;
+	totals.clear();
+	PricingFuzzer::reference(c, totals);
+	//198.5 and 370.5 now round down to the even cent
+	REQUIRE(totals[1] == 397 + 198);
+	REQUIRE(totals[4] - totals[3] == 370);
+	//the original calcPrice rounds half a cent up whatever the mode, which
+	//the reference puts right for the units it discounts
+	FuzzCase penny;
+	penny.rounding = ROUND_HALF_EVEN;
+	penny.products.push_back(fuzzProduct(1));
+	penny.products[0].terms = c.products[0].terms;
+	penny.products[0].terms.limit = 0;
+	penny.ops = {{FUZZ_SCAN, 0, 0}, {FUZZ_SCAN, 0, 0}, {FUZZ_SCAN, 0, 0}};
+	totals.clear();
+	PricingFuzzer::reference(penny, totals);
+	REQUIRE(totals == vector<int>({1, 1, 2}));
+}
+
+TEST_CASE("the register's pricing paths agree with the fuzzing reference on generated baskets", "[fuzz]") {
+	PricingFuzzer fuzzer(7);
+	fuzzer.addRegisterEngines();
+	REQUIRE(fuzzer.getEngines() == 4);
+	FuzzMismatch m;
+	bool agreed = fuzzer.run(3000, m);
+	INFO(m.engine << "\n" << PricingFuzzer::describe(m.minimal));
+	REQUIRE(agreed);
+	REQUIRE(fuzzer.getCases() == 3000);
+}
+
+TEST_CASE("a PricingFuzzer flags an engine that disagrees and shrinks the failing case", "[fuzz]") {
+	PricingFuzzer fuzzer(1);
+	fuzzer.addEngine("no limits", forgetsLimits);
+	FuzzMismatch m;
+	REQUIRE_FALSE(fuzzer.run(100000, m));
+	REQUIRE(m.engine == "no limits");
+	REQUIRE(m.minimal.ops.size() <= m.failing.ops.size());
+	REQUIRE(m.minimal.products.size() == 1);
+	REQUIRE(m.minimal.products[0].terms.limit != 0);
+	REQUIRE(m.minimal.products[0].markdown == 0);
+	for (const FuzzOp& o : m.minimal.ops) {
+		REQUIRE(o.product == 0);
+	}
+	REQUIRE(m.actual != m.expected);
+	REQUIRE(m.op == m.minimal.ops.size() - 1);
+
+	//dropping any one op of the minimal case makes it pass
+	for (size_t i = 0; i < m.minimal.ops.size(); ++i) {
+		FuzzCase smaller = m.minimal;
+		smaller.ops.erase(smaller.ops.begin() + i);
+		vector<int> expected, actual;
+		PricingFuzzer::reference(smaller, expected);
+		forgetsLimits(smaller, actual);
+		REQUIRE(expected == actual);
+	}
+	string text = PricingFuzzer::describe(m.minimal);
+	REQUIRE(text.find("p0: ") != string::npos);
+	REQUIRE(text.find("limit ") != string::npos);
+}
@@ -0,0 +1,151 @@
+#include "catch.hpp"
+#include "importer.h"
+#include "inventory.h"
+#include "register.h"
+#include "special.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::to_string;
+
+TEST_CASE("CsvImporter builds an inventory from price file rows and reports rejected rows with their line numbers", "[importer]") {
+	Inventory testInventory;
+	CsvImporter importer(3, 64);
+	string csv =
+		"name,price,byWeight,markdown,special\n"
+		"milk,399,0,0\n"
+		"bananas,69,1,10\r\n"
+		"yogurt,129,0,0,BOGO,2,1,50,6\n"
+		"\n"
+		"soda,199,0,0,BULK,6,999\n"
+		"chips,299,0,299\n"
+		"milk,100,0,0\n"
+		"cookies,349,0,0,BOGO,1,1,150\n"
+		"crackers,abc,0,0\n"
+		"gum,99,0,0,BULK,0,100\n"
+		"cheese,599,0,0,PROMO,1\n"
+		"apples,149,1,0,BOGO,200,100,25,400\n";
+	importer.parse(csv.data(), csv.size(), testInventory);
+
+	SECTION("valid rows are inserted with their prices, markdowns, byWeight and specials") {
+		REQUIRE(importer.getImported() == 5);
+		REQUIRE(testInventory.size() == 5);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("milk")).price == 399);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("bananas")).markdown == 10);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("bananas")).byWeight);
+
+		shared_ptr<Product> yogurt = testInventory.retrieve("yogurt");
+
+		REQUIRE(yogurt->getPrice() == 129);
+		REQUIRE(yogurt->getSpecial()->getSpecialType() == "BOGO");
+		REQUIRE(yogurt->getSpecial()->getPurchaseQuantity() == 2);
+		REQUIRE(yogurt->getSpecial()->getDiscountQuantity() == 1);
+		REQUIRE(yogurt->getSpecial()->getDiscountPercentage() == 50);
+		REQUIRE(yogurt->getSpecial()->getLimit() == 6);
+		REQUIRE(testInventory.retrieve("soda")->getSpecial()->getDiscountPrice() == 999);
+		REQUIRE(testInventory.retrieve("apples")->getSpecial()->getLimit() == 400);
+	}
+	SECTION("rejected rows are reported in file order with 1 based line numbers and a reason") {
+		const vector<ImportReject>& rejects = importer.getRejects();
+
+		REQUIRE(rejects.size() == 6);
+		REQUIRE(rejects[0].line == 7);
+		REQUIRE(rejects[0].reason == "markdown must be less than price");
+		REQUIRE(rejects[1].line == 8);
+		REQUIRE(rejects[1].reason == "duplicate product name");
+		REQUIRE(rejects[2].line == 9);
+		REQUIRE(rejects[2].reason == "discountPercentage must be between 0 and 100");
+		REQUIRE(rejects[3].line == 10);
+		REQUIRE(rejects[4].line == 11);
+		REQUIRE(rejects[4].reason == "purchaseQuantity must be positive");
+		REQUIRE(rejects[5].line == 12);
+		REQUIRE(rejects[5].reason == "unknown special type");
+	}
+	SECTION("a rejected duplicate leaves the first row in place") {
+		REQUIRE(testInventory.pricing(testInventory.getHandle("milk")).price == 399);
+	}
+}
+
+TEST_CASE("CsvImporter gives the same result for any thread count and block size", "[importer]") {
+	string csv;
+	for (int i = 0; i < 2000; ++i) {
+		csv += "item" + to_string(i) + "," + to_string(100 + i) + ",0," + to_string(i % 7 == 0 ? 200 + i : 0);
+		csv += i % 5 == 0 ? ",BULK,3,250\n" : "\n";
+	}
+	Inventory single;
+	CsvImporter oneThread(1);
+	oneThread.parse(csv.data(), csv.size(), single);
+	Inventory parallel;
+	CsvImporter manyThreads(4, 1000);
+	manyThreads.parse(csv.data(), csv.size(), parallel);
+
+	REQUIRE(oneThread.getImported() == manyThreads.getImported());
+	REQUIRE(oneThread.getRejects().size() == manyThreads.getRejects().size());
+	REQUIRE(manyThreads.getRejects().front().line == 1);
+	REQUIRE(manyThreads.getRejects().back().line == 1996);
+
+	bool same = single.size() == parallel.size();
+	for (int h = 0; same && h < single.size(); ++h) {
+		same = parallel.getHandle(single.retrieve(h)->getName()) == h
+			&& parallel.pricing(h).price == single.pricing(h).price
+			&& parallel.pricing(h).special == single.pricing(h).special;
+	}
+
+	REQUIRE(same);
+}
+
+TEST_CASE("CsvImporter gives each MIX group its own pool, even when two groups have equal terms", "[importer][mix]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	CsvImporter importer;
+	string csv =
+		"peach,199,0,0,MIX,1,2,300\n"
+		"soap,249,0,0,MIX,2,2,300\n"
+		"cherry,199,0,0,MIX,1,2,300\n"
+		"shampoo,249,0,0,MIX,2,2,300\n"
+		"plum,199,0,0,MIX,1,3,300\n";
+	importer.parse(csv.data(), csv.size(), *inv);
+
+	REQUIRE(importer.getImported() == 4);
+	REQUIRE(importer.getRejects().size() == 1);
+	REQUIRE(importer.getRejects()[0].line == 5);
+	REQUIRE(importer.getRejects()[0].reason == "MIX group listed with other terms");
+	REQUIRE(inv->retrieve("peach")->getSpecial() == inv->retrieve("cherry")->getSpecial());
+	REQUIRE(inv->retrieve("soap")->getSpecial() == inv->retrieve("shampoo")->getSpecial());
+	REQUIRE(inv->retrieve("peach")->getSpecial() != inv->retrieve("soap")->getSpecial());
+
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("peach");
+	reg.scanItem("soap");
+
+	REQUIRE(reg.getTotal() == 199 + 249);
+
+	reg.scanItem("cherry");
+
+	REQUIRE(reg.getTotal() == 300 + 249);
+
+	reg.scanItem("shampoo");
+
+	REQUIRE(reg.getTotal() == 300 + 300);
+}
+
+TEST_CASE("CsvImporter load reads a price file from disk", "[importer]") {
+	const char* path = "test_importer.csv";
+	FILE* f = fopen(path, "w");
+	fputs("rice,298,0,0\nbeans,149,0,20\n", f);
+	fclose(f);
+	Inventory testInventory;
+	CsvImporter importer;
+
+	REQUIRE(importer.load(path, testInventory) == true);
+	REQUIRE(importer.getImported() == 2);
+	REQUIRE(testInventory.pricing(testInventory.getHandle("beans")).markdown == 20);
+	REQUIRE(importer.load("no_such_file.csv", testInventory) == false);
+
+	std::remove(path);
+}
@@ -1,11 +1,21 @@
 #include "catch.hpp"
 #include "inventory.h"
 #include "product.h"
+#include "register.h"
+#include "special.h"
 
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 using std::make_shared;
 using std::shared_ptr;
+using std::string;
+using std::vector;
 
 TEST_CASE("contains returns a value based on the state of productList", "[inventory]") {
 	Inventory testInventory;
@@ -56,3 +66,557 @@ TEST_CASE("retrieve takes a string and returns a pointer to a product with that
 		REQUIRE(testProductPtr == nullptr);
 	}
 }
+
+TEST_CASE("getHandle returns the dense integer handle assigned to a product when it was inserted, else returns -1", "[inventory]") {
+	Inventory testInventory;
+	testInventory.insert(make_shared<Product>("flour", 349));
+	testInventory.insert(make_shared<Product>("salt", 99));
+
+	SECTION("handles are assigned in insertion order starting from 0") {
+		REQUIRE(testInventory.getHandle("flour") == 0);
+		REQUIRE(testInventory.getHandle("salt") == 1);
+		REQUIRE(testInventory.size() == 2);
+	}
+	SECTION("getHandle returns -1 when passed a string that isn't a product name in the inventory") {
+		REQUIRE(testInventory.getHandle("yeast") == -1);
+	}
+	SECTION("a failed insert does not consume a handle") {
+		testInventory.insert(make_shared<Product>("flour", 299));
+		testInventory.insert(make_shared<Product>("yeast", 150));
+
+		REQUIRE(testInventory.getHandle("yeast") == 2);
+	}
+	SECTION("retrieve returns the product for a valid handle and nullptr for an invalid one") {
+		REQUIRE(testInventory.retrieve(1)->getName() == "salt");
+		REQUIRE(testInventory.retrieve(2) == nullptr);
+		REQUIRE(testInventory.retrieve(-1) == nullptr);
+	}
+}
+
+TEST_CASE("find takes a product name and returns a borrowed pointer to the product and optionally its handle, else returns nullptr", "[inventory]") {
+	Inventory testInventory;
+	shared_ptr<Product> testProductPtr = make_shared<Product>("honey", 649);
+	testInventory.insert(make_shared<Product>("jam", 399));
+	testInventory.insert(testProductPtr);
+
+	SECTION("find returns the same product object held by the inventory without taking ownership") {
+		long useCount = testProductPtr.use_count();
+		Product* found = testInventory.find("honey");
+
+		REQUIRE(found == testProductPtr.get());
+		REQUIRE(testProductPtr.use_count() == useCount);
+	}
+	SECTION("find reports the handle of the found product through its optional second parameter") {
+		int h = -1;
+		testInventory.find("honey", &h);
+
+		REQUIRE(h == 1);
+		REQUIRE(testInventory.get(h) == testProductPtr.get());
+	}
+	SECTION("find returns nullptr and a handle of -1 when passed a string that isn't a product name in the inventory") {
+		int h = 0;
+
+		REQUIRE(testInventory.find("syrup", &h) == nullptr);
+		REQUIRE(h == -1);
+		REQUIRE(testInventory.get(5) == nullptr);
+	}
+}
+
+TEST_CASE("pricing returns the pricing row for a handle, which tracks later changes made through the product", "[inventory]") {
+	Inventory testInventory;
+	shared_ptr<Product> testProductPtr = make_shared<Product>("ground coffee", 899);
+	testInventory.insert(testProductPtr);
+	int h = testInventory.getHandle("ground coffee");
+
+	REQUIRE(testInventory.pricing(h).price == 899);
+	REQUIRE(testInventory.pricing(h).special == -1);
+
+	SECTION("setPrice, setMarkdown and setByWeight on an inserted product update its pricing row") {
+		testProductPtr->setPrice(999);
+		testProductPtr->setMarkdown(150);
+		testProductPtr->setByWeight(true);
+
+		REQUIRE(testInventory.pricing(h).price == 999);
+		REQUIRE(testInventory.pricing(h).markdown == 150);
+		REQUIRE(testInventory.pricing(h).byWeight);
+	}
+	SECTION("assignSpecial on an inserted product points its pricing row at the special") {
+		shared_ptr<Special> specPtr = make_shared<SpecialBulk>(2, 1500);
+		testProductPtr->assignSpecial(specPtr);
+
+		REQUIRE(testInventory.getSpecial(testInventory.pricing(h).special) == specPtr.get());
+
+		testProductPtr->assignSpecial(nullptr);
+
+		REQUIRE(testInventory.getSpecial(testInventory.pricing(h).special) == nullptr);
+	}
+	SECTION("a change to a special's terms through its setters moves the rows pricing with it to a new slot holding them") {
+		shared_ptr<Special> specPtr = make_shared<SpecialBulk>(2, 1500);
+		specPtr->setDiscountPrice(1400);
+		testProductPtr->assignSpecial(specPtr);
+		int slot = testInventory.pricing(h).special;
+		uint32_t before, after;
+		testInventory.getCatalog().getRow(h, &before);
+
+		REQUIRE(specPtr->getAttached());
+		REQUIRE(testInventory.getCatalog().getSpecial(slot).discountPrice == 1400);
+
+		specPtr->setDiscountPrice(1200);
+		testInventory.getCatalog().getRow(h, &after);
+
+		REQUIRE(testInventory.pricing(h).special != slot);
+		REQUIRE(after != before);
+		REQUIRE(testInventory.getCatalog().getSpecial(testInventory.pricing(h).special).discountPrice == 1200);
+
+		specPtr->setLimit(4);
+
+		REQUIRE(testInventory.getCatalog().getSpecial(testInventory.pricing(h).special).limit == 4);
+		REQUIRE(testInventory.getSpecial(testInventory.pricing(h).special) == specPtr.get());
+		REQUIRE(testInventory.getSpecialSlots() == 1);
+
+		testProductPtr->assignSpecial(nullptr);
+
+		REQUIRE_FALSE(specPtr->getAttached());
+	}
+	SECTION("a product outliving its inventory can still be changed safely") {
+		shared_ptr<Special> specPtr = make_shared<SpecialBulk>(2, 1500);
+		testProductPtr->assignSpecial(specPtr);
+		Inventory* shortLived = new Inventory();
+		shortLived->insert(testProductPtr);
+		delete shortLived;
+		testProductPtr->setPrice(100);
+		specPtr->setDiscountPrice(1300);
+
+		REQUIRE(testInventory.getCatalog().getSpecial(testInventory.pricing(h).special).discountPrice == 1300);
+
+		REQUIRE(testInventory.pricing(h).price == 100);
+	}
+}
+
+TEST_CASE("erase removes a product by name so it can no longer be found, leaving existing product objects valid", "[inventory]") {
+	Inventory testInventory;
+	shared_ptr<Product> prodPtr = make_shared<Product>("tofu", 249);
+	testInventory.insert(prodPtr);
+	testInventory.insert(make_shared<Product>("tempeh", 349));
+	int tofu = testInventory.getHandle("tofu");
+
+	REQUIRE(testInventory.erase("tofu") == true);
+	REQUIRE(testInventory.erase("tofu") == false);
+	REQUIRE(testInventory.erase("seitan") == false);
+	REQUIRE(testInventory.getHandle("tofu") == -1);
+	REQUIRE(testInventory.retrieve("tofu") == nullptr);
+	REQUIRE(testInventory.get(tofu) == nullptr);
+	REQUIRE(testInventory.pricing(tofu).erased);
+	REQUIRE(testInventory.getHandle("tempeh") == 1);
+
+	SECTION("the erased product no longer updates the inventory when changed") {
+		prodPtr->setPrice(100);
+
+		REQUIRE(testInventory.pricing(tofu).price == 249);
+	}
+	SECTION("the name can be inserted again and gets its old handle back") {
+		Product* borrowed = testInventory.find("tempeh");
+		testInventory.erase("tempeh");
+		shared_ptr<Product> again = make_shared<Product>("tempeh", 199);
+
+		REQUIRE(testInventory.insert(again) == true);
+		REQUIRE(testInventory.getHandle("tempeh") == 1);
+		REQUIRE(testInventory.get(1) == again.get());
+		REQUIRE(testInventory.pricing(1).price == 199);
+		REQUIRE(borrowed->getPrice() == 349);
+		REQUIRE(testInventory.size() == 2);
+	}
+	SECTION("a name erased with a special and inserted again without one releases the special's slot") {
+		shared_ptr<Product> deal = make_shared<Product>("miso", 500);
+		deal->assignSpecial(make_shared<SpecialBulk>(2, 900));
+		testInventory.insert(deal);
+		testInventory.erase("miso");
+
+		REQUIRE(testInventory.getSpecialSlots() == 1);
+
+		vector<PriceDelta> batch(1);
+		batch[0].op = PriceDelta::UPSERT;
+		batch[0].name = "miso";
+		batch[0].price = 450;
+
+		REQUIRE(testInventory.apply(batch) == 1);
+		REQUIRE(testInventory.getHandle("miso") == 2);
+		REQUIRE(testInventory.getSpecialSlots() == 0);
+		REQUIRE(testInventory.retrieve("miso")->getPrice() == 450);
+		REQUIRE(testInventory.retrieve("miso") != deal);
+	}
+}
+
+TEST_CASE("apply makes a batch of changes in order and reports why any were rejected", "[inventory]") {
+	Inventory testInventory;
+	shared_ptr<Product> prodPtr = make_shared<Product>("rice", 399);
+	testInventory.insert(prodPtr);
+	Inventory otherInventory;
+	otherInventory.insert(prodPtr);
+	shared_ptr<Special> specialPtr = make_shared<SpecialBulk>(2, 700);
+	vector<PriceDelta> batch(6);
+	batch[0].op = PriceDelta::UPSERT;
+	batch[0].name = "beans";
+	batch[0].price = 149;
+	batch[1].op = PriceDelta::PRICE;
+	batch[1].name = "rice";
+	batch[1].price = 449;
+	batch[2].op = PriceDelta::MARKDOWN;
+	batch[2].name = "rice";
+	batch[2].markdown = 500;
+	batch[3].op = PriceDelta::SPECIAL;
+	batch[3].name = "rice";
+	batch[3].special = specialPtr;
+	batch[4].op = PriceDelta::PRICE;
+	batch[4].name = "lentils";
+	batch[5].op = PriceDelta::MARKDOWN;
+	batch[5].name = "beans";
+	batch[5].markdown = 20;
+	vector<const char*> reasons;
+
+	REQUIRE(testInventory.apply(batch, &reasons) == 4);
+	REQUIRE(reasons[0] == nullptr);
+	REQUIRE(string(reasons[2]) == "markdown must be less than price");
+	REQUIRE(string(reasons[4]) == "unknown product");
+	REQUIRE(testInventory.pricing(testInventory.getHandle("beans")).price == 149);
+	REQUIRE(testInventory.pricing(testInventory.getHandle("beans")).markdown == 20);
+	REQUIRE(testInventory.retrieve("beans")->getMarkdown() == 20);
+
+	SECTION("changes to a product object held by the inventory are made to the object and every inventory holding it") {
+		REQUIRE(prodPtr->getPrice() == 449);
+		REQUIRE(prodPtr->getSpecial() == specialPtr);
+		REQUIRE(otherInventory.pricing(0).price == 449);
+		REQUIRE(otherInventory.getSpecial(otherInventory.pricing(0).special) == specialPtr.get());
+	}
+	SECTION("an upsert of an existing product keeps its special and a special change with no special detaches it") {
+		batch.resize(2);
+		batch[0].op = PriceDelta::UPSERT;
+		batch[0].name = "rice";
+		batch[0].price = 299;
+		batch[0].byWeight = 1;
+		batch[1].op = PriceDelta::SPECIAL;
+		batch[1].name = "beans";
+		batch[1].special = specialPtr;
+		testInventory.apply(batch);
+
+		REQUIRE(prodPtr->getPrice() == 299);
+		REQUIRE(prodPtr->getByWeight() == true);
+		REQUIRE(prodPtr->getSpecial() == specialPtr);
+		REQUIRE(testInventory.retrieve("beans")->getSpecial() == specialPtr);
+
+		batch.erase(batch.begin());
+		batch[0].special = nullptr;
+		testInventory.apply(batch);
+
+		REQUIRE(testInventory.retrieve("beans")->getSpecial() == nullptr);
+		REQUIRE(testInventory.pricing(testInventory.getHandle("beans")).special == -1);
+	}
+}
+
+TEST_CASE("save writes the inventory to a catalog file which mapFile serves lookups from without reading it in", "[inventory]") {
+	const char* path = "test_inventory.catalog";
+	shared_ptr<Inventory> saved = make_shared<Inventory>();
+	saved->insert(make_shared<Product>("oats", 349));
+	shared_ptr<Product> prodPtr = make_shared<Product>("pecans", 1099, true);
+	prodPtr->setMarkdown(200);
+	saved->insert(prodPtr);
+	prodPtr = make_shared<Product>("yogurt", 129);
+	prodPtr->assignSpecial(make_shared<SpecialBogo>(2, 1, 50, 6));
+	saved->insert(prodPtr);
+	prodPtr = make_shared<Product>("seltzer", 99);
+	prodPtr->assignSpecial(make_shared<SpecialBulk>(8, 600));
+	saved->insert(prodPtr);
+
+	REQUIRE(saved->save(path) == true);
+
+	shared_ptr<Inventory> mapped = make_shared<Inventory>();
+
+	REQUIRE(mapped->mapFile(path) == true);
+	REQUIRE(mapped->isMapped() == true);
+
+	SECTION("a mapped inventory keeps the handles, prices, markdowns and byWeight of the saved one") {
+		REQUIRE(mapped->size() == 4);
+		REQUIRE(mapped->getHandle("pecans") == saved->getHandle("pecans"));
+		REQUIRE(mapped->pricing(mapped->getHandle("pecans")).price == 1099);
+		REQUIRE(mapped->pricing(mapped->getHandle("pecans")).markdown == 200);
+		REQUIRE(mapped->pricing(mapped->getHandle("pecans")).byWeight);
+		REQUIRE(mapped->contains("walnuts") == false);
+	}
+	SECTION("retrieve on a mapped inventory builds a product with the saved fields and special parameters") {
+		shared_ptr<Product> yogurt = mapped->retrieve("yogurt");
+
+		REQUIRE(yogurt->getName() == "yogurt");
+		REQUIRE(yogurt->getPrice() == 129);
+		REQUIRE(yogurt->getSpecial()->getSpecialType() == "BOGO");
+		REQUIRE(yogurt->getSpecial()->getPurchaseQuantity() == 2);
+		REQUIRE(yogurt->getSpecial()->getDiscountQuantity() == 1);
+		REQUIRE(yogurt->getSpecial()->getDiscountPercentage() == 50);
+		REQUIRE(yogurt->getSpecial()->getLimit() == 6);
+		REQUIRE(mapped->retrieve("yogurt") == yogurt);
+
+		shared_ptr<Product> seltzer = mapped->retrieve("seltzer");
+
+		REQUIRE(seltzer->getSpecial()->getSpecialType() == "BULK");
+		REQUIRE(seltzer->getSpecial()->getPurchaseQuantity() == 8);
+		REQUIRE(seltzer->getSpecial()->getDiscountPrice() == 600);
+	}
+	SECTION("a mapped inventory accepts inserts and product changes") {
+		mapped->retrieve("oats")->setPrice(399);
+
+		REQUIRE(mapped->insert(make_shared<Product>("raisins", 279)) == true);
+		REQUIRE(mapped->insert(make_shared<Product>("oats", 100)) == false);
+		REQUIRE(mapped->pricing(mapped->getHandle("oats")).price == 399);
+		REQUIRE(mapped->pricing(mapped->getHandle("raisins")).price == 279);
+		REQUIRE(mapped->getHandle("yogurt") == 2);
+	}
+	SECTION("mapFile returns false for a missing file, a file which isn't a catalog, or an inventory which isn't empty") {
+		Inventory empty;
+
+		REQUIRE(empty.mapFile("no_such_file.catalog") == false);
+		REQUIRE(empty.mapFile("Makefile") == false);
+		REQUIRE(saved->mapFile(path) == false);
+	}
+
+	mapped = nullptr;
+	std::remove(path);
+}
+
+TEST_CASE("mapFile refuses a catalog file with an index out of its bounds instead of reading past them", "[inventory]") {
+	const char* path = "test_inventory_bad.catalog";
+	Inventory saved;
+	saved.insert(make_shared<Product>("oats", 349));
+	shared_ptr<Product> yogurt = make_shared<Product>("yogurt", 129);
+	yogurt->assignSpecial(make_shared<SpecialBogo>(2, 1, 50));
+	saved.insert(yogurt);
+	REQUIRE(saved.save(path));
+	FILE* f = fopen(path, "rb");
+	string good;
+	char buffer[4096];
+	for (size_t n; (n = fread(buffer, 1, sizeof(buffer), f)) > 0; ) {
+		good.append(buffer, n);
+	}
+	fclose(f);
+	//the file header and one special record, then the catalog section
+	//header, slots, rows of 16 bytes and name offsets
+	size_t section = 16 + 24;
+	uint32_t rowCount, slotCount;
+	memcpy(&rowCount, &good[section], 4);
+	memcpy(&slotCount, &good[section + 4], 4);
+	size_t slots = section + 16;
+	size_t rows = slots + slotCount * 8;
+	size_t offsets = rows + rowCount * 16;
+	REQUIRE(rowCount == 2);
+	auto mapsWith = [&](size_t at, uint32_t value, size_t length) {
+		string bad = good.substr(0, length);
+		if (at < length) {
+			memcpy(&bad[at], &value, 4);
+		}
+		FILE* out = fopen(path, "wb");
+		fwrite(bad.data(), 1, bad.size(), out);
+		fclose(out);
+		Inventory mapped;
+		return mapped.mapFile(path);
+	};
+	size_t filled = slots;
+	while (good[filled] == 0 && good[filled + 1] == 0 && good[filled + 2] == 0 && good[filled + 3] == 0) {
+		filled += 8;
+	}
+
+	REQUIRE(mapsWith(good.size(), 0, good.size()));
+	REQUIRE_FALSE(mapsWith(filled, rowCount + 5, good.size())); //a slot naming a row past the last
+	REQUIRE_FALSE(mapsWith(rows + 16 + 12, 7, good.size())); //a row referring to a special past the last
+	REQUIRE_FALSE(mapsWith(rows + 16, 1, good.size())); //a row torn mid change
+	REQUIRE_FALSE(mapsWith(offsets + 4, 1000, good.size())); //names out of order
+	REQUIRE_FALSE(mapsWith(16, 9, good.size())); //a special of no known kind
+	REQUIRE_FALSE(mapsWith(good.size(), 0, offsets + 4)); //truncated
+
+	std::remove(path);
+}
+
+TEST_CASE("a special slot no product refers to any more is reused, so changing specials doesn't grow the catalog", "[inventory]") {
+	const char* path = "test_inventory_slots.catalog";
+	Inventory testInventory;
+	shared_ptr<Product> oats = make_shared<Product>("oats", 349);
+	testInventory.insert(oats);
+	testInventory.insert(make_shared<Product>("bran", 299));
+	for (int i = 1; i <= 100; ++i) {
+		oats->assignSpecial(make_shared<SpecialBulk>(2, 600 - i));
+	}
+	vector<PriceDelta> batch(100);
+	for (int i = 0; i < 100; ++i) {
+		batch[i].op = PriceDelta::SPECIAL;
+		batch[i].name = "bran";
+		batch[i].special = make_shared<SpecialBogo>(1, 1, i + 1);
+	}
+
+	REQUIRE(testInventory.apply(batch) == 100);
+	REQUIRE(testInventory.getSpecialSlots() == 2);
+	REQUIRE(testInventory.getCatalog().specialsSize() <= 4);
+	REQUIRE(testInventory.getCatalog().getSpecial(testInventory.pricing(0).special).discountPrice == 500);
+	REQUIRE(testInventory.getCatalog().getSpecial(testInventory.pricing(1).special).discountPercentage == 100);
+
+	SECTION("an erased product keeps its special, which removals still price with") {
+		REQUIRE(testInventory.erase("bran"));
+
+		oats->assignSpecial(nullptr);
+
+		REQUIRE(testInventory.getSpecialSlots() == 1);
+		REQUIRE(testInventory.getSpecial(testInventory.pricing(1).special) == batch[99].special.get());
+	}
+	SECTION("a catalog file keeps the slot indexes, and the freed ones are reused once mapped") {
+		int specials = testInventory.getCatalog().specialsSize();
+		oats->assignSpecial(nullptr);
+
+		REQUIRE(testInventory.save(path));
+
+		Inventory mapped;
+
+		REQUIRE(mapped.mapFile(path));
+		REQUIRE(mapped.getSpecialSlots() == 1);
+		REQUIRE(mapped.getCatalog().getSpecial(mapped.pricing(1).special).discountPercentage == 100);
+		REQUIRE(mapped.retrieve("bran")->getSpecial()->getDiscountPercentage() == 100);
+
+		mapped.retrieve("bran")->getSpecial()->setDiscountPercentage(60);
+
+		REQUIRE(mapped.getCatalog().getSpecial(mapped.pricing(1).special).discountPercentage == 60);
+		REQUIRE(mapped.getSpecialSlots() == 1);
+
+		mapped.retrieve("oats")->assignSpecial(make_shared<SpecialBulk>(3, 800));
+
+		REQUIRE(mapped.getSpecialSlots() == 2);
+		REQUIRE(mapped.getCatalog().specialsSize() == specials);
+		REQUIRE(mapped.getCatalog().getSpecial(mapped.pricing(0).special).discountPrice == 800);
+	}
+
+	std::remove(path);
+}
+
+TEST_CASE("publish builds an immutable snapshot of the inventory which later changes don't affect", "[inventory]") {
+	Inventory testInventory;
+	shared_ptr<Product> prodPtr = make_shared<Product>("granola", 499);
+	shared_ptr<Special> specPtr = make_shared<SpecialBulk>(2, 800);
+	prodPtr->assignSpecial(specPtr);
+	testInventory.insert(prodPtr);
+
+	REQUIRE(testInventory.publish() == 1);
+
+	shared_ptr<const InventorySnapshot> first = testInventory.snapshot();
+
+	SECTION("a snapshot keeps the prices, specials and products of the version it was published at") {
+		prodPtr->setPrice(549);
+		prodPtr->assignSpecial(make_shared<SpecialBulk>(2, 900));
+		testInventory.insert(make_shared<Product>("muesli", 399));
+		int h = first->getCatalog().find("granola");
+
+		REQUIRE(first->getVersion() == 1);
+		REQUIRE(first->getCatalog().getRow(h).price == 499);
+		REQUIRE(first->getCatalog().getSpecial(first->getCatalog().getRow(h).special).discountPrice == 800);
+		REQUIRE(first->getCatalog().find("muesli") == -1);
+		REQUIRE(testInventory.pricing(h).price == 549);
+	}
+	SECTION("snapshot returns the latest published version, and older versions are freed once nothing holds them") {
+		prodPtr->setPrice(549);
+		std::weak_ptr<const InventorySnapshot> old = first;
+		testInventory.publish();
+		shared_ptr<const InventorySnapshot> second = testInventory.snapshot();
+
+		REQUIRE(second->getVersion() == 2);
+		REQUIRE(second->getCatalog().getRow(0).price == 549);
+		REQUIRE(old.expired() == false);
+
+		first = nullptr;
+
+		REQUIRE(old.expired() == true);
+	}
+}
+
+TEST_CASE("registers on many threads can scan against a shared inventory while another thread inserts products and changes prices and specials", "[inventory][register]") {
+	const int scanners = 32;
+	const int scansPerThread = 4000;
+	const int products = 200;
+	shared_ptr<Inventory> sharedInventory = make_shared<Inventory>();
+	vector<shared_ptr<Product>> catalog;
+	for (int i = 0; i < products; ++i) {
+		//every product, old or new, always sells for exactly 100 after markdown
+		shared_ptr<Product> p = make_shared<Product>("item" + std::to_string(i), 100 + i);
+		p->setMarkdown(i);
+		sharedInventory->insert(p);
+		catalog.push_back(p);
+	}
+	vector<shared_ptr<Product>> deals;
+	for (int i = 0; i < 20; ++i) {
+		//deal products sell for 100 a unit under every special they are given
+		shared_ptr<Product> p = make_shared<Product>("deal" + std::to_string(i), 100);
+		p->assignSpecial(make_shared<SpecialBulk>(2, 200));
+		sharedInventory->insert(p);
+		deals.push_back(p);
+	}
+	std::atomic<int> running(scanners);
+	std::atomic<int> inserted(0);
+	std::thread writer([&]() {
+		unsigned k = 0;
+		while (running.load() > 0) {
+			++k;
+			//a new special's terms replace the old ones whole, and a scan
+			//mixing the two would price a unit at other than 100
+			int q = 2 + k % 7;
+			shared_ptr<Product> deal = deals[k % deals.size()];
+			if (k % 3 == 0) {
+				deal->assignSpecial(make_shared<SpecialMix>(q, 100 * q, k % 2 ? 0 : 100 * q));
+			}
+			else {
+				deal->assignSpecial(make_shared<SpecialBulk>(q, 100 * q, k % 2 ? 0 : 2 * q));
+			}
+			//and a special's terms changed in place keep a unit at 100
+			deals[(k + 7) % deals.size()]->getSpecial()->setLimit(k % 5 == 0 ? 0 : 100 * (k % 9));
+			Product repriced("", 100 + k % 5000);
+			repriced.setMarkdown(k % 5000);
+			shared_ptr<Product> target = catalog[k % products];
+			repriced.setName(target->getName());
+			*target = repriced; //price and markdown change in one publish
+			if (k % 4 == 0 && inserted.load() < 20000) {
+				int n = inserted.load();
+				shared_ptr<Product> added = make_shared<Product>("new" + std::to_string(n), 100 + n);
+				added->setMarkdown(n);
+				sharedInventory->insert(added);
+				inserted.store(n + 1);
+			}
+		}
+	});
+	vector<int> scanned(scanners, 0);
+	vector<int> totals(scanners, 0);
+	vector<std::thread> lanes;
+	for (int t = 0; t < scanners; ++t) {
+		lanes.push_back(std::thread([&, t]() {
+			Register lane;
+			lane.assignInventory(sharedInventory);
+			unsigned seed = t * 7919 + 1;
+			for (int i = 0; i < scansPerThread; ++i) {
+				seed = seed * 1103515245 + 12345;
+				string name = (i % 3 == 0) ? "new" + std::to_string(seed % (inserted.load() + 1))
+					: (i % 3 == 1 && seed % 2) ? "deal" + std::to_string(seed % deals.size()) : "item" + std::to_string(seed % products);
+				if (lane.scanItem(name)) {
+					++scanned[t];
+				}
+			}
+			totals[t] = lane.getTotal();
+			--running;
+		}));
+	}
+	for (std::thread& lane : lanes) {
+		lane.join();
+	}
+	writer.join();
+
+	bool everyScanPricedAtOneRow = true;
+	int totalScanned = 0;
+	for (int t = 0; t < scanners; ++t) {
+		everyScanPricedAtOneRow = everyScanPricedAtOneRow && totals[t] == 100 * scanned[t];
+		totalScanned += scanned[t];
+	}
+
+	REQUIRE(everyScanPricedAtOneRow);
+	REQUIRE(totalScanned >= scanners * scansPerThread * 2 / 3);
+	REQUIRE(sharedInventory->size() == products + (int) deals.size() + inserted.load());
+	REQUIRE(sharedInventory->getSpecialSlots() <= (int) deals.size());
+}
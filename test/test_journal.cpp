@@ -0,0 +1,251 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "journal.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+shared_ptr<Inventory> journalInventory() {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->insert(make_shared<Product>("soup", 189));
+	inv->insert(make_shared<Product>("bananas", 249, true));
+	shared_ptr<Product> bread = make_shared<Product>("bread", 399);
+	bread->assignSpecial(make_shared<SpecialBogo>(1, 1, 100));
+	inv->insert(bread);
+	shared_ptr<Product> cans = make_shared<Product>("cans", 99);
+	cans->assignSpecial(make_shared<SpecialBulk>(3, 250));
+	inv->insert(cans);
+	return inv;
+}
+
+string journalPath(const char* name) {
+	return string("/tmp/test_journal_") + std::to_string(getpid()) + "_" + name;
+}
+
+}
+
+TEST_CASE("a Journal reads back the records appended to it, in order", "[journal]") {
+	string path = journalPath("records");
+	{
+		Journal journal(4, 0);
+		REQUIRE(journal.open(path, true));
+		for (int i = 0; i < 10; ++i) {
+			journal.append(JOURNAL_SCAN, i, i + 1, i * 100);
+		}
+		REQUIRE(journal.getRecords() == 10);
+	}
+	vector<JournalRecord> records;
+
+	REQUIRE(Journal::read(path, records));
+	REQUIRE(records.size() == 10);
+	for (int i = 0; i < 10; ++i) {
+		REQUIRE(records[i].op == JOURNAL_SCAN);
+		REQUIRE(records[i].handle == i);
+		REQUIRE(records[i].amount == i + 1);
+		REQUIRE(records[i].total == i * 100);
+	}
+	REQUIRE(Journal::read(journalPath("missing"), records) == false);
+	remove(path.c_str());
+}
+
+TEST_CASE("a Journal syncs every syncEvery commits and appends to an existing journal when opened again", "[journal]") {
+	string path = journalPath("sync");
+	{
+		Journal journal(2, 3);
+		REQUIRE(journal.open(path, true));
+		for (int i = 0; i < 12; ++i) {
+			journal.append(JOURNAL_SCAN, 0, 1, i);
+		}
+
+		REQUIRE(journal.getSyncs() == 2);
+		REQUIRE(journal.close());
+	}
+	{
+		Journal journal;
+		REQUIRE(journal.open(path));
+		journal.append(JOURNAL_REMOVE, 0, -1, 11);
+	}
+	vector<JournalRecord> records;
+
+	REQUIRE(Journal::read(path, records));
+	REQUIRE(records.size() == 13);
+	REQUIRE(records.back().op == JOURNAL_REMOVE);
+	remove(path.c_str());
+}
+
+TEST_CASE("recover rebuilds a register's total and quantities exactly from its journal", "[journal][register]") {
+	string path = journalPath("recover");
+	shared_ptr<Inventory> inv = journalInventory();
+	Register original;
+	original.assignInventory(inv);
+	Journal journal(8, 0);
+	REQUIRE(journal.open(path, true));
+	original.setJournal(&journal);
+	original.scanItem("soup");
+	original.scanItem("bananas", 125);
+	original.reset();
+	original.scanItem("soup");
+	original.scanItem("bread");
+	original.scanItem("bread");
+	original.scanItem("bananas", 250);
+	original.removeItem("bananas", 75);
+	original.scanItems("cans", 4);
+	original.removeItems("cans", 1);
+	vector<ScanEntry> burst = {ScanEntry(string("soup")), ScanEntry(string("soup")), ScanEntry(string("cans"))};
+	original.scanBatch(burst.data(), burst.size());
+	original.removeItem("missing");
+	journal.commit();
+
+	Register recovered;
+	recovered.assignInventory(inv);
+
+	REQUIRE(recovered.recover(path));
+	REQUIRE(recovered.getTotal() == original.getTotal());
+	for (const char* name : {"soup", "bananas", "bread", "cans"}) {
+		REQUIRE(recovered.getQuantity(name) == original.getQuantity(name));
+	}
+
+	SECTION("the recovered basket carries on as the original would") {
+		recovered.scanItem("bread");
+		original.scanItem("bread");
+
+		REQUIRE(recovered.getTotal() == original.getTotal());
+	}
+	SECTION("after a reset is journaled, recovery gives an empty basket") {
+		original.reset();
+		journal.commit();
+
+		REQUIRE(recovered.recover(path));
+		REQUIRE(recovered.getTotal() == 0);
+		REQUIRE(recovered.getQuantity("soup") == 0);
+	}
+	original.setJournal(nullptr);
+	journal.close();
+	remove(path.c_str());
+}
+
+TEST_CASE("recover ignores a record torn by a crash at the end of the journal", "[journal][register]") {
+	string path = journalPath("torn");
+	shared_ptr<Inventory> inv = journalInventory();
+	Register original;
+	original.assignInventory(inv);
+	{
+		Journal journal(1, 0);
+		REQUIRE(journal.open(path, true));
+		original.setJournal(&journal);
+		original.scanItem("soup");
+		original.scanItem("bread");
+		original.setJournal(nullptr);
+	}
+	int total = original.getTotal();
+	FILE* f = fopen(path.c_str(), "ab");
+	JournalRecord bad;
+	bad.handle = 0;
+	bad.amount = 5;
+	bad.total = 5000;
+	bad.op = JOURNAL_SCAN;
+	bad.check = Journal::checksum(bad) + 1;
+	fwrite(&bad, sizeof(bad), 1, f);
+	fwrite(&bad, 7, 1, f);
+	fclose(f);
+
+	Register recovered;
+	recovered.assignInventory(inv);
+
+	REQUIRE(recovered.recover(path));
+	REQUIRE(recovered.getTotal() == total);
+	REQUIRE(recovered.getQuantity("soup") == 1);
+	remove(path.c_str());
+}
+
+TEST_CASE("a Journal opened after a crash cuts off the torn record, so records appended later can be read back", "[journal]") {
+	string path = journalPath("reopen");
+	{
+		Journal journal(1, 0);
+		REQUIRE(journal.open(path, true));
+		journal.append(JOURNAL_SCAN, 0, 1, 189);
+	}
+	FILE* f = fopen(path.c_str(), "ab");
+	fwrite("torn", 4, 1, f);
+	fclose(f);
+	{
+		Journal journal(1, 0);
+		REQUIRE(journal.open(path));
+		journal.append(JOURNAL_SCAN, 0, 1, 378);
+	}
+	vector<JournalRecord> records;
+
+	REQUIRE(Journal::read(path, records));
+	REQUIRE(records.size() == 2);
+	REQUIRE(records[1].total == 378);
+
+	f = fopen(path.c_str(), "wb");
+	fwrite("not a journal", 13, 1, f);
+	fclose(f);
+	Journal other;
+
+	REQUIRE_FALSE(other.open(path));
+	remove(path.c_str());
+}
+
+TEST_CASE("a basket recovered after a crash, scanned further and lost in a second crash is recovered again", "[journal][register]") {
+	string path = journalPath("twice");
+	shared_ptr<Inventory> inv = journalInventory();
+	auto tear = [&path]() {
+		//a crash in the middle of writing a record
+		FILE* f = fopen(path.c_str(), "ab");
+		fwrite("torn rec", 8, 1, f);
+		fclose(f);
+	};
+	Register first;
+	first.assignInventory(inv);
+	{
+		Journal journal(1, 0);
+		REQUIRE(journal.open(path, true));
+		first.setJournal(&journal);
+		first.scanItem("soup");
+		first.scanItems("cans", 2);
+		first.scanItem("bananas", 150);
+		first.setJournal(nullptr);
+	}
+	tear();
+
+	Register second;
+	second.assignInventory(inv);
+	{
+		Journal journal(1, 0);
+		REQUIRE(journal.open(path));
+		second.setJournal(&journal);
+		REQUIRE(second.recover(path));
+		REQUIRE(second.getTotal() == first.getTotal());
+		second.scanItem("cans");
+		second.scanItem("bread");
+		second.removeItem("soup");
+		second.setJournal(nullptr);
+	}
+	tear();
+
+	Register third;
+	third.assignInventory(inv);
+
+	REQUIRE(third.recover(path));
+	REQUIRE(third.getTotal() == second.getTotal());
+	REQUIRE(third.getTotal() == 250 + 399 + 374);
+	for (const char* name : {"soup", "bananas", "bread", "cans"}) {
+		REQUIRE(third.getQuantity(name) == second.getQuantity(name));
+	}
+	remove(path.c_str());
+}
@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "metrics.h"
+
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+TEST_CASE("Metrics buckets hold values within a quarter of their start, in increasing order", "[metrics]") {
+	bool ordered = true;
+	for (int b = 1; b < METRIC_BUCKETS; ++b) {
+		ordered = ordered && Metrics::bucketStart(b) > Metrics::bucketStart(b - 1);
+	}
+
+	REQUIRE(ordered);
+
+	bool placed = true;
+	for (uint64_t t : {0ull, 1ull, 3ull, 4ull, 7ull, 8ull, 100ull, 12345ull, 1ull << 40, ~0ull}) {
+		int b = Metrics::bucketOf(t);
+		placed = placed && b >= 0 && b < METRIC_BUCKETS && Metrics::bucketStart(b) <= t
+			&& (b + 1 == METRIC_BUCKETS || t < Metrics::bucketStart(b + 1));
+		placed = placed && t - Metrics::bucketStart(b) <= Metrics::bucketStart(b) / 4 + 1;
+	}
+
+	REQUIRE(placed);
+}
+
+TEST_CASE("a Metrics snapshot merges the counters and latencies recorded on every thread", "[metrics]") {
+	Metrics::reset();
+	vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([] {
+			for (uint64_t i = 1; i <= 1000; ++i) {
+				Metrics::add(METRIC_SCAN, i);
+				Metrics::count(COUNT_SCANNED);
+			}
+			Metrics::count(COUNT_SCAN_NO_WEIGHT);
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	Metrics::add(METRIC_RETRIEVE, 50000);
+	MetricsSnapshot s = Metrics::snapshot();
+
+	REQUIRE(s.getCount(COUNT_SCANNED) == 4000);
+	REQUIRE(s.getCount(COUNT_SCAN_NO_WEIGHT) == 4);
+	REQUIRE(s.getCount(COUNT_REMOVED) == 0);
+	REQUIRE(s.getOps(METRIC_SCAN) == 4000);
+	REQUIRE(s.getOps(METRIC_REMOVE) == 0);
+	REQUIRE(s.percentileTicks(METRIC_SCAN, 0.5) == Approx(500).epsilon(0.25));
+	REQUIRE(s.percentileTicks(METRIC_SCAN, 0.99) == Approx(990).epsilon(0.25));
+	REQUIRE(s.percentileTicks(METRIC_SCAN, 0.999) == Approx(999).epsilon(0.25));
+	REQUIRE(s.percentileTicks(METRIC_RETRIEVE, 0.5) == Approx(50000).epsilon(0.25));
+	REQUIRE(s.percentileTicks(METRIC_REMOVE, 0.5) == 0);
+	REQUIRE(s.getTicksPerNs() > 0);
+
+	Metrics::reset();
+
+	REQUIRE(Metrics::snapshot().getOps(METRIC_SCAN) == 0);
+}
@@ -0,0 +1,99 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "metrics.h"
+#include "product.h"
+#include "register.h"
+
+#include <memory>
+#include <string>
+
+#if !defined(REGISTER_METRICS) || REGISTER_METRICS_SAMPLE != 1
+#error "built by the output_metrics target, with -DREGISTER_METRICS -DREGISTER_METRICS_SAMPLE=1"
+#endif
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+TEST_CASE("with the hooks compiled in, registers and inventories count every outcome and time every scan, removal and retrieve", "[metrics]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->insert(make_shared<Product>("soup", 189));
+	inv->insert(make_shared<Product>("apples", 299, true));
+	inv->insert(make_shared<Product>("bread", 349));
+	int bread = inv->getHandle("bread");
+	inv->erase("bread");
+	Register reg;
+	reg.assignInventory(inv);
+	Metrics::reset();
+
+	REQUIRE(reg.scanItem("soup"));
+	REQUIRE(reg.scanItems("soup", 2));
+	REQUIRE(reg.scanItem("apples", 150));
+	REQUIRE_FALSE(reg.scanItem("caviar"));
+	REQUIRE_FALSE(reg.scanItem(bread));
+	REQUIRE_FALSE(reg.scanItem("apples"));
+	REQUIRE(reg.removeItem("soup"));
+	REQUIRE(reg.removeItems("soup", 2));
+	REQUIRE_FALSE(reg.removeItem("soup"));
+	REQUIRE_FALSE(reg.removeItem("apples"));
+	REQUIRE_FALSE(reg.removeItem("caviar"));
+	REQUIRE(inv->retrieve("soup") != nullptr);
+	REQUIRE(inv->retrieve("caviar") == nullptr);
+
+	MetricsSnapshot s = Metrics::snapshot();
+
+	REQUIRE(s.getCount(COUNT_SCANNED) == 3);
+	REQUIRE(s.getCount(COUNT_SCAN_UNKNOWN) == 1);
+	REQUIRE(s.getCount(COUNT_SCAN_ERASED) == 1);
+	REQUIRE(s.getCount(COUNT_SCAN_NO_WEIGHT) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVED) == 2);
+	REQUIRE(s.getCount(COUNT_REMOVE_NOT_SCANNED) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVE_NO_WEIGHT) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVE_UNKNOWN) == 1);
+	REQUIRE(s.getCount(COUNT_RETRIEVE_HIT) == 1);
+	REQUIRE(s.getCount(COUNT_RETRIEVE_MISS) == 1);
+	REQUIRE(s.getOps(METRIC_SCAN) == 6);
+	REQUIRE(s.getOps(METRIC_REMOVE) == 5);
+	REQUIRE(s.getOps(METRIC_RETRIEVE) == 2);
+	REQUIRE(s.percentileTicks(METRIC_SCAN, 0.5) > 0);
+	REQUIRE(s.percentileTicks(METRIC_SCAN, 1.0) >= s.percentileTicks(METRIC_SCAN, 0.5));
+	REQUIRE(s.percentileTicks(METRIC_REMOVE, 0.5) > 0);
+	REQUIRE(s.percentileTicks(METRIC_RETRIEVE, 0.5) > 0);
+
+	Metrics::reset();
+	reg.reset();
+
+	REQUIRE(Metrics::snapshot().getCount(COUNT_SCANNED) == 0);
+	REQUIRE(Metrics::snapshot().getOps(METRIC_SCAN) == 0);
+}
+
+TEST_CASE("with the hooks compiled in, batch scans and removals count every entry and time each batch", "[metrics]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->insert(make_shared<Product>("soup", 189));
+	inv->insert(make_shared<Product>("apples", 299, true));
+	Register reg;
+	reg.assignInventory(inv);
+	Metrics::reset();
+	ScanEntry scans[] = {ScanEntry(string("soup")), ScanEntry(string("soup")), ScanEntry(string("apples"), 150),
+		ScanEntry(string("apples")), ScanEntry(string("caviar"))};
+	ScanEntry removals[] = {ScanEntry(string("soup")), ScanEntry(string("apples"), 200), ScanEntry(-1)};
+
+	REQUIRE(reg.scanBatch(scans, 5) == 3);
+	REQUIRE(reg.removeBatch(removals, 3) == 1);
+
+	MetricsSnapshot s = Metrics::snapshot();
+
+	REQUIRE(s.getCount(COUNT_SCANNED) == 3);
+	REQUIRE(s.getCount(COUNT_SCAN_NO_WEIGHT) == 1);
+	REQUIRE(s.getCount(COUNT_SCAN_UNKNOWN) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVED) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVE_NOT_SCANNED) == 1);
+	REQUIRE(s.getCount(COUNT_REMOVE_UNKNOWN) == 1);
+	REQUIRE(s.getOps(METRIC_SCAN_BATCH) == 1);
+	REQUIRE(s.getOps(METRIC_REMOVE_BATCH) == 1);
+	REQUIRE(s.getOps(METRIC_SCAN) == 0);
+	REQUIRE(s.percentileTicks(METRIC_SCAN_BATCH, 0.5) > 0);
+	REQUIRE(s.percentileTicks(METRIC_REMOVE_BATCH, 0.5) > 0);
+
+	Metrics::reset();
+}
@@ -0,0 +1,328 @@
+#include "catch.hpp"
+#include "importer.h"
+#include "inventory.h"
+#include "journal.h"
+#include "mix.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+SpecialTerms mixTerms(int purchaseQuantity, int discountPrice, int limit = 0) {
+	SpecialTerms t;
+	t.kind = SPECIAL_MIX;
+	t.purchaseQuantity = purchaseQuantity;
+	t.discountPrice = discountPrice;
+	t.limit = limit;
+	return t;
+}
+
+//any 3 yogurts for $5, in three flavours, plus a product on its own
+shared_ptr<Inventory> yogurtInventory() {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Special> deal = make_shared<SpecialMix>(3, 500);
+	for (const char* flavour : {"peach", "cherry", "plain"}) {
+		shared_ptr<Product> p = make_shared<Product>(flavour, 199);
+		p->assignSpecial(deal);
+		inv->insert(p);
+	}
+	inv->find("plain")->setPrice(249);
+	inv->insert(make_shared<Product>("soup", 189));
+	return inv;
+}
+
+}
+
+TEST_CASE("a MixPool sells each complete run of units for the discount price and prices each unit in one step", "[mix]") {
+	MixPool pool;
+	pool.setTerms(mixTerms(3, 500));
+	vector<vector<int>> positions(2);
+	REQUIRE(pool.add(0, 199, positions) == 199);
+	REQUIRE(pool.add(0, 199, positions) == 199);
+	REQUIRE(pool.add(1, 249, positions) == 500 - 398);
+	REQUIRE(pool.value() == 500);
+	REQUIRE(pool.getGroups() == 1);
+	REQUIRE(pool.add(1, 249, positions) == 249);
+	REQUIRE(pool.value() == 749);
+
+	SECTION("removing a unit in a run lets the waiting unit take its place, keeping the discount") {
+		REQUIRE(pool.remove(0, positions) == -249);
+		REQUIRE(pool.value() == 500);
+		REQUIRE(pool.size() == 3);
+		REQUIRE(pool.unit(1).line == 1);
+		REQUIRE(positions[0] == vector<int>({0}));
+		REQUIRE(positions[1] == vector<int>({2, 1}));
+
+		//and with none waiting, the run breaks up and its units pay full price
+		REQUIRE(pool.remove(1, positions) == 448 - 500);
+		REQUIRE(pool.value() == 448);
+		REQUIRE(pool.getGroups() == 0);
+		REQUIRE(positions[1] == vector<int>({1}));
+	}
+	SECTION("removing the waiting unit takes off its own price") {
+		REQUIRE(pool.remove(1, positions) == -249);
+		REQUIRE(pool.value() == 500);
+	}
+	SECTION("clear empties the pool") {
+		pool.clear();
+		REQUIRE(pool.size() == 0);
+		REQUIRE(pool.value() == 0);
+	}
+}
+
+TEST_CASE("a MixPool discounts only the runs within its special's limit", "[mix]") {
+	MixPool pool;
+	pool.setTerms(mixTerms(2, 300, 5));
+	vector<vector<int>> positions(1);
+	for (int i = 0; i < 6; ++i) {
+		pool.add(0, 200, positions);
+	}
+	REQUIRE(pool.getGroups() == 2);
+	REQUIRE(pool.value() == 600 + 400);
+	REQUIRE(pool.remove(0, positions) == -200);
+	REQUIRE(pool.remove(0, positions) == -200);
+	REQUIRE(pool.remove(0, positions) == 200 - 300);
+	REQUIRE(pool.value() == 500);
+}
+
+TEST_CASE("a register prices products sharing a mix and match special as one pool", "[mix][register]") {
+	Register reg;
+	reg.assignInventory(yogurtInventory());
+	REQUIRE(reg.scanItem("peach"));
+	REQUIRE(reg.scanItem("soup"));
+	REQUIRE(reg.scanItem("cherry"));
+	REQUIRE(reg.getTotal() == 199 + 189 + 199);
+	REQUIRE(reg.scanItem("plain"));
+	REQUIRE(reg.getTotal() == 500 + 189);
+	REQUIRE(reg.scanItems("peach", 2));
+	REQUIRE(reg.getTotal() == 500 + 189 + 398);
+
+	LineItem peach = reg.getLineItem(0);
+	REQUIRE(peach.specialKind == SPECIAL_MIX);
+	REQUIRE(peach.quantity == 3);
+	int amounts = 0;
+	int savings = 0;
+	for (int i = 0; i < reg.getLineCount(); ++i) {
+		amounts += reg.getLineItem(i).amount;
+		savings += reg.getLineItem(i).savings;
+	}
+	REQUIRE(amounts == reg.getTotal());
+	REQUIRE(savings == 199 + 199 + 249 - 500);
+
+	SECTION("removing a product from the deal moves a waiting unit into it") {
+		REQUIRE(reg.removeItem("plain"));
+		REQUIRE(reg.getTotal() == 500 + 189 + 199);
+		REQUIRE(reg.removeItem("peach"));
+		REQUIRE(reg.removeItem("peach"));
+		REQUIRE(reg.getTotal() == 199 + 189 + 199);
+		REQUIRE_FALSE(reg.removeItem("plain"));
+	}
+	SECTION("removeItems takes back the latest units one at a time") {
+		REQUIRE(reg.removeItems("peach", 3));
+		REQUIRE(reg.getTotal() == 199 + 249 + 189);
+		REQUIRE_FALSE(reg.removeItems("cherry", 2));
+	}
+	SECTION("a reset empties the pool") {
+		reg.reset();
+		REQUIRE(reg.scanItem("cherry"));
+		REQUIRE(reg.getTotal() == 199);
+	}
+}
+
+TEST_CASE("each mix and match line's amount is its units' share of the pool, so the lines sum to the total through any scans and removals", "[mix][register]") {
+	shared_ptr<Inventory> inv = yogurtInventory();
+	shared_ptr<Special> twoFor300 = make_shared<SpecialMix>(2, 300, 4);
+	for (const char* name : {"lime", "kiwi"}) {
+		shared_ptr<Product> p = make_shared<Product>(name, 175);
+		p->assignSpecial(twoFor300);
+		inv->insert(p);
+	}
+	const char* names[] = {"peach", "cherry", "plain", "soup", "lime", "kiwi"};
+	std::mt19937 rng(24);
+	Register reg, resumed;
+	reg.assignInventory(inv);
+	resumed.assignInventory(inv);
+	vector<char> blob;
+	for (int step = 0; step < 2000; ++step) {
+		const char* name = names[rng() % 6];
+		if (rng() % 3 == 0) {
+			reg.removeItem(name);
+		}
+		else {
+			reg.scanItem(name);
+		}
+		int amounts = 0;
+		int plain = 0;
+		for (int i = 0; i < reg.getLineCount(); ++i) {
+			LineItem item = reg.getLineItem(i);
+			amounts += item.amount;
+			plain += item.amount + item.savings;
+			REQUIRE((item.quantity != 0 || (item.amount == 0 && item.savings == 0)));
+		}
+		REQUIRE(amounts == reg.getTotal());
+		int regular = 0;
+		for (const char* n : names) {
+			regular += reg.getQuantity(n) * inv->find(n)->getPrice();
+		}
+		REQUIRE(plain == regular);
+		if (step % 100 == 99) {
+			blob.resize(reg.suspendedSize());
+			reg.suspend(blob.data(), blob.size());
+			REQUIRE(resumed.resume(blob.data(), blob.size()));
+			for (int i = 0; i < reg.getLineCount(); ++i) {
+				REQUIRE(resumed.getLineItem(i).amount == reg.getLineItem(i).amount);
+				REQUIRE(resumed.getLineItem(i).savings == reg.getLineItem(i).savings);
+			}
+		}
+	}
+}
+
+TEST_CASE("scanBatch puts mix and match units into their pool in the order given", "[mix][register]") {
+	shared_ptr<Inventory> inv = yogurtInventory();
+	Register one, batched;
+	one.assignInventory(inv);
+	batched.assignInventory(inv);
+	vector<ScanEntry> burst = {ScanEntry(string("plain")), ScanEntry(string("soup")), ScanEntry(string("peach")),
+		ScanEntry(string("plain")), ScanEntry(string("cherry")), ScanEntry(string("peach"))};
+	for (const ScanEntry& e : burst) {
+		one.scanItem(string(e.name, e.length));
+	}
+	REQUIRE(batched.scanBatch(burst.data(), burst.size()) == 6);
+	REQUIRE(batched.getTotal() == one.getTotal());
+	ScanEntry plain(string("plain"));
+	REQUIRE(batched.removeBatch(&plain, 1) == 1);
+	REQUIRE(one.removeItem("plain"));
+	REQUIRE(batched.getTotal() == one.getTotal());
+	REQUIRE(batched.getTotal() == 500 + 189 + 199);
+}
+
+TEST_CASE("a suspended basket resumes with the same units in its mix pools", "[mix][register]") {
+	shared_ptr<Inventory> inv = yogurtInventory();
+	Register reg, other;
+	reg.assignInventory(inv);
+	other.assignInventory(inv);
+	reg.scanItem("plain");
+	reg.scanItem("peach");
+	reg.scanItem("cherry");
+	reg.scanItem("peach");
+	vector<char> blob(reg.suspendedSize());
+	REQUIRE(reg.suspend(blob.data(), blob.size()) == blob.size());
+	REQUIRE(other.resume(blob.data(), blob.size()));
+	REQUIRE(other.getTotal() == reg.getTotal());
+
+	//the plain yogurt is in the deal, so removing it pulls in the peach
+	REQUIRE(other.removeItem("plain"));
+	REQUIRE(reg.removeItem("plain"));
+	REQUIRE(other.getTotal() == reg.getTotal());
+	REQUIRE(other.getTotal() == 500);
+
+	SECTION("a blob naming a pool it doesn't describe is refused") {
+		size_t size = reg.suspend(blob.data(), blob.size());
+		int32_t pool = 7;
+		memcpy(blob.data() + size - 16, &pool, sizeof(pool));
+		REQUIRE_FALSE(other.resume(blob.data(), size));
+	}
+}
+
+TEST_CASE("a basket's mix pool keeps its units and terms when its special's slot goes to another special", "[mix][register]") {
+	shared_ptr<Inventory> inv = yogurtInventory();
+	Register reg, other;
+	reg.assignInventory(inv);
+	other.assignInventory(inv);
+	REQUIRE(reg.scanItems("peach", 2));
+	int slot = inv->pricing(inv->getHandle("peach")).special;
+	shared_ptr<Special> twoFor300 = make_shared<SpecialMix>(2, 300);
+	for (const char* flavour : {"peach", "cherry", "plain"}) {
+		inv->find(flavour)->assignSpecial(twoFor300);
+	}
+	shared_ptr<Product> lemon = make_shared<Product>("lemon", 50);
+	lemon->assignSpecial(make_shared<SpecialMix>(3, 100));
+	inv->insert(lemon);
+
+	REQUIRE(inv->pricing(inv->getHandle("lemon")).special == slot);
+
+	//the lemons start a pool of their own, and more peaches still count
+	//towards the deal they were scanned under
+	REQUIRE(reg.scanItems("lemon", 3));
+	REQUIRE(reg.getTotal() == 398 + 100);
+	REQUIRE(reg.scanItem("peach"));
+	REQUIRE(reg.getTotal() == 500 + 100);
+
+	vector<char> blob(reg.suspendedSize());
+	REQUIRE(reg.suspend(blob.data(), blob.size()) == blob.size());
+	REQUIRE(other.resume(blob.data(), blob.size()));
+	REQUIRE(other.removeItem("peach"));
+	REQUIRE(reg.removeItem("peach"));
+	REQUIRE(other.getTotal() == reg.getTotal());
+	REQUIRE(other.getTotal() == 398 + 100);
+	REQUIRE(other.scanItem("lemon"));
+	REQUIRE(other.getTotal() == 398 + 150);
+}
+
+TEST_CASE("recover replays mix and match units in their journaled order", "[mix][journal]") {
+	string path = string("/tmp/test_mix_") + std::to_string(getpid()) + "_recover";
+	shared_ptr<Inventory> inv = yogurtInventory();
+	Register original;
+	original.assignInventory(inv);
+	Journal journal(8, 0);
+	REQUIRE(journal.open(path, true));
+	original.setJournal(&journal);
+	original.scanItem("plain");
+	original.scanItems("peach", 2);
+	original.scanItem("cherry");
+	original.removeItem("plain");
+	journal.commit();
+
+	Register recovered;
+	recovered.assignInventory(inv);
+	REQUIRE(recovered.recover(path));
+	REQUIRE(recovered.getTotal() == original.getTotal());
+	recovered.removeItem("cherry");
+	original.removeItem("cherry");
+	REQUIRE(recovered.getTotal() == original.getTotal());
+	journal.close();
+	remove(path.c_str());
+}
+
+TEST_CASE("products of a price file listing the same MIX group share one pool, which survives a catalog file", "[mix][importer]") {
+	const char* text = "name,price,byWeight,markdown,special\n"
+		"peach,199,0,0,MIX,1,3,500\n"
+		"cherry,199,0,0,MIX,1,3,500\n"
+		"plain,249,0,0,MIX,1,3,500\n"
+		"lemon,199,0,0,MIX,2,2,300,4\n";
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	CsvImporter importer;
+	importer.parse(text, strlen(text), *inv);
+	REQUIRE(importer.getImported() == 4);
+	REQUIRE(inv->find("peach")->getSpecial() == inv->find("plain")->getSpecial());
+	REQUIRE(inv->find("lemon")->getSpecial()->getSpecialType() == "MIX");
+
+	string path = string("/tmp/test_mix_") + std::to_string(getpid()) + ".catalog";
+	REQUIRE(inv->save(path));
+	shared_ptr<Inventory> mapped = make_shared<Inventory>();
+	REQUIRE(mapped->mapFile(path));
+	for (shared_ptr<Inventory> i : {inv, mapped}) {
+		Register reg;
+		reg.assignInventory(i);
+		reg.scanItem("peach");
+		reg.scanItem("lemon");
+		reg.scanItem("cherry");
+		reg.scanItem("plain");
+		REQUIRE(reg.getTotal() == 500 + 199);
+	}
+	remove(path.c_str());
+}
@@ -0,0 +1,449 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "optimizer.h"
+#include "pricing.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+SpecialTerms bogoTerms(int purchaseQuantity, int discountQuantity, int discountPercentage, int limit = 0) {
+	SpecialTerms t;
+	t.kind = SPECIAL_BOGO;
+	t.purchaseQuantity = purchaseQuantity;
+	t.discountQuantity = discountQuantity;
+	t.discountPercentage = discountPercentage;
+	t.limit = limit;
+	return t;
+}
+
+SpecialTerms priceTerms(int kind, int purchaseQuantity, int discountPrice, int limit = 0) {
+	SpecialTerms t;
+	t.kind = kind;
+	t.purchaseQuantity = purchaseQuantity;
+	t.discountPrice = discountPrice;
+	t.limit = limit;
+	return t;
+}
+
+Promotion promotion(const SpecialTerms& t, const vector<int>& handles) {
+	Promotion p;
+	p.terms = t;
+	p.handles = handles;
+	return p;
+}
+
+BasketOptimizer untimed(int budget = BasketOptimizer::DEFAULT_BUDGET) {
+	//exact prices can't depend on how busy the machine running the tests is
+	return BasketOptimizer(budget, BasketOptimizer::NO_TIME_LIMIT);
+}
+
+//every way of giving each unit to at most one special, for small baskets:
+//lines priced at price[i], with item specials and groups by line
+struct BruteForce {
+	vector<int> price, quantity;
+	vector<vector<SpecialTerms>> item;
+	vector<SpecialTerms> groups;
+	vector<vector<int>> groupsOf;
+	int best = INT_MAX;
+
+	void line(size_t i, int cost, vector<int>& counts) {
+		if (i == price.size()) {
+			for (size_t g = 0; g < groups.size(); ++g) {
+				int n = groups[g].purchaseQuantity;
+				if (counts[g] % n != 0 || (groups[g].limit > 0 && counts[g] > groups[g].limit / n * n)) {
+					return;
+				}
+				cost += counts[g] / n * groups[g].discountPrice;
+			}
+			best = cost < best ? cost : best;
+			return;
+		}
+		split(i, 0, quantity[i], cost, counts);
+	}
+
+	void split(size_t i, size_t s, int left, int cost, vector<int>& counts) {
+		//s runs over the line's item specials, then its groups
+		if (s < item[i].size()) {
+			for (int k = 0; k <= left; ++k) {
+				split(i, s + 1, left - k, cost + linePrice(price[i], false, k, &item[i][s]), counts);
+			}
+		} else if (s - item[i].size() < groupsOf[i].size()) {
+			int g = groupsOf[i][s - item[i].size()];
+			for (int k = 0; k <= left; ++k) {
+				counts[g] += k;
+				split(i, s + 1, left - k, cost, counts);
+				counts[g] -= k;
+			}
+		} else {
+			line(i + 1, cost + left * price[i], counts);
+		}
+	}
+};
+
+}
+
+TEST_CASE("the optimizer leaves a special unused where it costs more than full price", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> p = make_shared<Product>("soup", 100);
+	p->assignSpecial(make_shared<SpecialBulk>(3, 350));
+	inv->insert(p);
+	Register reg;
+	reg.assignInventory(inv);
+	for (int i = 0; i < 4; ++i) {
+		reg.scanItem("soup");
+	}
+	REQUIRE(reg.getTotal() == 450);
+	BasketOptimizer opt = untimed();
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE(best.total == 400);
+	REQUIRE(best.regular == 400);
+	REQUIRE(best.optimal);
+}
+
+TEST_CASE("the optimizer splits one product's units between its catalog special and an added promotion", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> p = make_shared<Product>("cola", 200);
+	p->assignSpecial(make_shared<SpecialBogo>(1, 1, 100, 2)); //buy one get one free, once
+	inv->insert(p);
+	Register reg;
+	reg.assignInventory(inv);
+	for (int i = 0; i < 5; ++i) {
+		reg.scanItem("cola");
+	}
+	REQUIRE(reg.getTotal() == 800);
+	BasketOptimizer opt = untimed();
+	REQUIRE(opt.addPromotion(promotion(priceTerms(SPECIAL_BULK, 3, 450), {inv->getHandle("cola")})) == 0);
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	//two for 200 under the BOGO, three for 450 under the bulk price
+	REQUIRE(best.total == 650);
+	REQUIRE(best.getSavings() == 350);
+}
+
+TEST_CASE("the optimizer puts the dearest units of a mix and match into its runs whatever the scan order", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Special> deal = make_shared<SpecialMix>(2, 300);
+	for (const char* name : {"cheap", "dear"}) {
+		shared_ptr<Product> p = make_shared<Product>(name, name[0] == 'c' ? 100 : 250);
+		p->assignSpecial(deal);
+		inv->insert(p);
+	}
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("cheap");
+	reg.scanItem("cheap");
+	reg.scanItem("dear");
+	reg.scanItem("dear");
+	reg.scanItem("cheap");
+	REQUIRE(reg.getTotal() == 300 + 300 + 100);
+	BasketOptimizer opt = untimed();
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE(best.total == 300 + 300);
+}
+
+TEST_CASE("the optimizer chooses between overlapping group promotions and item specials", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	for (const char* name : {"apple", "pear", "plum"}) {
+		inv->insert(make_shared<Product>(name, 150));
+	}
+	inv->find("plum")->assignSpecial(make_shared<SpecialBogo>(1, 1, 50));
+	int apple = inv->getHandle("apple"), pear = inv->getHandle("pear"), plum = inv->getHandle("plum");
+	BasketOptimizer opt = untimed();
+	opt.addPromotion(promotion(priceTerms(SPECIAL_MIX, 3, 300), {apple, pear}));
+	opt.addPromotion(promotion(priceTerms(SPECIAL_MIX, 2, 220, 2), {pear, plum}));
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem(apple);
+	reg.scanItem(apple);
+	reg.scanItem(pear);
+	reg.scanItem(pear);
+	reg.scanItem(plum);
+	reg.scanItem(plum);
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	//apple, apple, pear for 300, then pear and plum for 220, plum at 150
+	//beats the plum BOGO at 225 plus a pear at 150
+	REQUIRE(best.total == 300 + 220 + 150);
+	REQUIRE(best.regular == 900);
+}
+
+TEST_CASE("the optimizer prices weighed lines as the register does", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> beef = make_shared<Product>("beef", 599, true);
+	beef->assignSpecial(make_shared<SpecialBogo>(100, 100, 50));
+	inv->insert(beef);
+	inv->insert(make_shared<Product>("bun", 50));
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("beef", 250);
+	reg.scanItem("bun");
+	BasketOptimizer opt = untimed();
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE(best.total == reg.getTotal());
+}
+
+TEST_CASE("the optimizer memoizes results by basket signature until the basket or a row changes", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->insert(make_shared<Product>("tea", 300));
+	inv->insert(make_shared<Product>("milk", 120));
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("tea");
+	reg.scanItem("milk");
+	BasketOptimizer opt = untimed();
+	OptimizedBasket best;
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE_FALSE(best.cached);
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE(best.cached);
+	REQUIRE(best.total == 420);
+	REQUIRE(opt.getHits() == 1);
+
+	Register other;
+	other.assignInventory(inv);
+	other.scanItem("milk");
+	other.scanItem("tea");
+	REQUIRE(opt.optimize(other, best));
+	REQUIRE(best.cached);
+
+	inv->find("tea")->setPrice(280);
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE_FALSE(best.cached);
+	REQUIRE(best.total == 400);
+	reg.scanItem("milk");
+	REQUIRE(opt.optimize(reg, best));
+	REQUIRE_FALSE(best.cached);
+	REQUIRE(best.total == 520);
+	REQUIRE(opt.getMisses() == 3);
+}
+
+TEST_CASE("the optimizer prices a set too tangled for its budget within a bound of the best price and says so", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	vector<int> handles;
+	for (int i = 0; i < 6; ++i) {
+		inv->insert(make_shared<Product>("item " + std::to_string(i), 100 + 10 * i));
+		handles.push_back(inv->getHandle("item " + std::to_string(i)));
+	}
+	BasketOptimizer opt = untimed(1000);
+	BasketOptimizer exact = untimed();
+	for (int n = 2; n <= 5; ++n) {
+		opt.addPromotion(promotion(priceTerms(SPECIAL_MIX, n, 60 * n), handles));
+		exact.addPromotion(promotion(priceTerms(SPECIAL_MIX, n, 60 * n), handles));
+	}
+	Register reg;
+	reg.assignInventory(inv);
+	for (int h : handles) {
+		for (int k = 0; k < 3; ++k) {
+			reg.scanItem(h);
+		}
+	}
+	OptimizedBasket best, bounded;
+	REQUIRE(exact.optimize(reg, best));
+	REQUIRE(opt.optimize(reg, bounded));
+
+	REQUIRE(best.optimal);
+	REQUIRE(best.bound == 0);
+	REQUIRE_FALSE(bounded.optimal);
+	REQUIRE(opt.getBounded() == 1);
+	REQUIRE(opt.getTimedOut() == 0);
+	REQUIRE(bounded.total <= bounded.regular);
+	REQUIRE(bounded.total >= best.total);
+	REQUIRE(bounded.total - best.total <= bounded.bound);
+
+	//with no time limit the same budget gives the same price, so it is reused
+	OptimizedBasket again;
+	REQUIRE(opt.optimize(reg, again));
+
+	REQUIRE(again.cached);
+	REQUIRE(again.total == bounded.total);
+}
+
+TEST_CASE("past its budget the optimizer stays within its bound, a few percent above the best price on random baskets", "[optimizer]") {
+	//overlapping groups on baskets small enough to search whole with a big
+	//budget; measured on these, the fallback comes to 5.8% above the best
+	//price, running every group greedily to 6.8%, and its bound to 8.4%
+	std::mt19937 rng(25);
+	long best = 0, fallback = 0, greedy = 0, bound = 0;
+	for (int round = 0; round < 100; ++round) {
+		shared_ptr<Inventory> inv = make_shared<Inventory>();
+		vector<int> handles;
+		for (int i = 0; i < 10; ++i) {
+			string name = "p" + std::to_string(i);
+			shared_ptr<Product> p = make_shared<Product>(name, 99 + rng() % 600);
+			if (rng() % 2) {
+				p->assignSpecial(make_shared<SpecialBogo>(1 + rng() % 2, 1, 25 * (1 + rng() % 4)));
+			}
+			inv->insert(p);
+			handles.push_back(inv->getHandle(name));
+		}
+		BasketOptimizer exact = untimed(100000000), opt = untimed(3000), greedyOnly = untimed(1);
+		for (int g = 0; g < 5; ++g) {
+			int n = 2 + rng() % 3;
+			vector<int> members;
+			for (int h : handles) {
+				if (rng() % 2) {
+					members.push_back(h);
+				}
+			}
+			Promotion p = promotion(priceTerms(SPECIAL_MIX, n, n * (120 + rng() % 150), rng() % 3 == 0 ? 2 * n : 0), members);
+			exact.addPromotion(p);
+			opt.addPromotion(p);
+			greedyOnly.addPromotion(p);
+		}
+		Register reg;
+		reg.assignInventory(inv);
+		for (int h : handles) {
+			for (int k = 1 + rng() % 3; k > 0; --k) {
+				reg.scanItem(h);
+			}
+		}
+		OptimizedBasket e, f, g;
+		REQUIRE(exact.optimize(reg, e));
+		REQUIRE(opt.optimize(reg, f));
+		REQUIRE(greedyOnly.optimize(reg, g));
+
+		REQUIRE(e.optimal);
+		REQUIRE_FALSE(f.optimal);
+		REQUIRE(f.total >= e.total);
+		REQUIRE(f.total - e.total <= f.bound);
+		REQUIRE(g.total - e.total <= g.bound);
+		REQUIRE(f.total <= g.total);
+		best += e.total;
+		fallback += f.total;
+		greedy += g.total;
+		bound += f.bound;
+	}
+
+	REQUIRE(fallback < greedy);
+	REQUIRE((fallback - best) * 100 < best * 7);
+	REQUIRE(bound * 100 < best * 10);
+}
+
+TEST_CASE("the optimizer stops searching at its time limit and prices the rest within its bound", "[optimizer]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	vector<int> handles;
+	for (int i = 0; i < 40; ++i) {
+		inv->insert(make_shared<Product>("item " + std::to_string(i), 150 + 7 * i));
+		handles.push_back(inv->getHandle("item " + std::to_string(i)));
+	}
+	//a chain of group deals over sliding windows, quick to search whole but
+	//far longer than a microsecond
+	BasketOptimizer opt(BasketOptimizer::DEFAULT_BUDGET, 1);
+	BasketOptimizer exact = untimed(), greedyOnly = untimed(1);
+	for (int start = 0; start < 40; start += 2) {
+		vector<int> window(handles.begin() + start, handles.begin() + std::min(start + 4, 40));
+		int n = 2 + start % 3;
+		opt.addPromotion(promotion(priceTerms(SPECIAL_MIX, n, 130 * n), window));
+		exact.addPromotion(promotion(priceTerms(SPECIAL_MIX, n, 130 * n), window));
+		greedyOnly.addPromotion(promotion(priceTerms(SPECIAL_MIX, n, 130 * n), window));
+	}
+	Register reg;
+	reg.assignInventory(inv);
+	for (int h : handles) {
+		reg.scanItems(h, 3);
+	}
+	OptimizedBasket best, limited, greedy;
+	REQUIRE(exact.optimize(reg, best));
+	REQUIRE(opt.optimize(reg, limited));
+	REQUIRE(greedyOnly.optimize(reg, greedy));
+
+	REQUIRE(best.optimal);
+	REQUIRE_FALSE(limited.optimal);
+	REQUIRE(opt.getTimedOut() == 1);
+	REQUIRE(limited.total >= best.total);
+	REQUIRE(limited.total - best.total <= limited.bound);
+	REQUIRE(limited.total < limited.regular);
+	//the search stopped, the greedy price found before it is taken as it is
+	REQUIRE(limited.total == greedy.total);
+	REQUIRE(limited.bound == greedy.bound);
+
+	//a price the time limit cut short isn't reused; the basket is priced again
+	OptimizedBasket again;
+	REQUIRE(opt.optimize(reg, again));
+
+	REQUIRE_FALSE(again.cached);
+	REQUIRE(opt.getHits() == 0);
+	REQUIRE(opt.getMisses() == 2);
+	REQUIRE(again.total - best.total <= again.bound);
+}
+
+TEST_CASE("the optimizer finds the same best price as trying every assignment of units on random small baskets", "[optimizer]") {
+	std::mt19937 rng(25);
+	for (int round = 0; round < 300; ++round) {
+		shared_ptr<Inventory> inv = make_shared<Inventory>();
+		BasketOptimizer opt = untimed();
+		BruteForce brute;
+		int lines = 1 + rng() % 3;
+		int groups = rng() % 3;
+		brute.item.resize(lines);
+		brute.groupsOf.resize(lines);
+		vector<int> handles;
+		for (int i = 0; i < lines; ++i) {
+			string name = "p" + std::to_string(i);
+			shared_ptr<Product> p = make_shared<Product>(name, 50 + rng() % 200);
+			if (rng() % 2) {
+				p->assignSpecial(make_shared<SpecialBogo>(1 + rng() % 2, 1, 25 * (1 + rng() % 4), rng() % 3 == 0 ? 2 : 0));
+				brute.item[i].push_back(p->getSpecial()->getTerms());
+			}
+			inv->insert(p);
+			handles.push_back(inv->getHandle(name));
+			brute.price.push_back(p->getPrice());
+			brute.quantity.push_back(1 + rng() % 4);
+			if (rng() % 3 == 0) {
+				SpecialTerms t = rng() % 2 ? bogoTerms(2, 1, 100, rng() % 2 ? 3 : 0) : priceTerms(SPECIAL_BULK, 2 + rng() % 2, 100 + rng() % 300, rng() % 3 == 0 ? 3 : 0);
+				opt.addPromotion(promotion(t, {handles.back()}));
+				brute.item[i].push_back(t);
+			}
+		}
+		for (int g = 0; g < groups; ++g) {
+			SpecialTerms t = priceTerms(SPECIAL_MIX, 2 + rng() % 2, 150 + rng() % 300, rng() % 3 == 0 ? 4 : 0);
+			vector<int> members;
+			for (int i = 0; i < lines; ++i) {
+				if (rng() % 2) {
+					members.push_back(handles[i]);
+					brute.groupsOf[i].push_back(brute.groups.size());
+				}
+			}
+			if (opt.addPromotion(promotion(t, members)) >= 0) {
+				brute.groups.push_back(t);
+			} else {
+				for (int i = 0; i < lines; ++i) {
+					if (!brute.groupsOf[i].empty() && brute.groupsOf[i].back() == (int) brute.groups.size()) {
+						brute.groupsOf[i].pop_back();
+					}
+				}
+			}
+		}
+		Register reg;
+		reg.assignInventory(inv);
+		for (int i = 0; i < lines; ++i) {
+			for (int k = 0; k < brute.quantity[i]; ++k) {
+				reg.scanItem(handles[i]);
+			}
+		}
+		vector<int> counts(brute.groups.size());
+		brute.line(0, 0, counts);
+		OptimizedBasket best;
+		REQUIRE(opt.optimize(reg, best));
+		REQUIRE(best.optimal);
+		REQUIRE(best.total == brute.best);
+		REQUIRE(best.total <= reg.getTotal());
+	}
+}
@@ -0,0 +1,121 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "pool.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+std::atomic<long> allocations(0); //counts every heap allocation made by the test binary
+
+}
+
+void* operator new(size_t n) {
+	++allocations;
+	void* p = malloc(n ? n : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+TEST_CASE("RegisterPool hands out each register once until it is released, and released registers come back empty", "[pool][register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("figs", 399));
+	RegisterPool pool(testInventoryPtr, 2);
+
+	REQUIRE(pool.size() == 2);
+
+	Register* first = pool.acquire();
+	Register* second = pool.acquire();
+
+	REQUIRE(first != nullptr);
+	REQUIRE(second != nullptr);
+	REQUIRE(first != second);
+	REQUIRE(pool.acquire() == nullptr);
+	REQUIRE(pool.getAvailable() == 0);
+	REQUIRE(first->getInventory() == testInventoryPtr);
+
+	first->scanItem("figs");
+	pool.release(first);
+	Register* again = pool.acquire();
+
+	REQUIRE(again == first);
+	REQUIRE(again->getTotal() == 0);
+	REQUIRE(again->getQuantity("figs") == 0);
+}
+
+TEST_CASE("reset clears only the scanned lines, including ones removed back to zero and scanned again", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("dates", 599));
+	testInventoryPtr->insert(make_shared<Product>("prunes", 449));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	testRegister.scanItem("dates");
+	testRegister.removeItem("dates");
+	testRegister.scanItem("dates");
+	testRegister.scanItem("prunes");
+	testRegister.reset();
+
+	REQUIRE(testRegister.getTotal() == 0);
+	REQUIRE(testRegister.getQuantity("dates") == 0);
+	REQUIRE(testRegister.getQuantity("prunes") == 0);
+}
+
+TEST_CASE("a warmed register from a pool scans, totals and resets baskets without any heap allocation", "[pool][register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	vector<string> names;
+	for (int i = 0; i < 200; ++i) {
+		names.push_back("sku" + std::to_string(i));
+		shared_ptr<Product> prodPtr = make_shared<Product>(names[i], 100 + i, i % 5 == 0);
+		if (i % 3 == 0) {
+			prodPtr->assignSpecial(make_shared<SpecialBogo>(2, 1, 50));
+		}
+		testInventoryPtr->insert(prodPtr);
+	}
+	testInventoryPtr->publish();
+	RegisterPool pool(testInventoryPtr, 2, 128);
+	vector<ScanEntry> burst;
+	for (int i = 0; i < 40; ++i) {
+		burst.push_back(ScanEntry(i % 2 ? i : 150 + i, 120));
+	}
+	long checked = 0;
+	long before = allocations.load();
+	for (int basket = 0; basket < 100; ++basket) {
+		Register* lane = pool.acquire();
+		lane->setSnapshotMode(basket % 2 == 1);
+		for (int i = 0; i < 60; ++i) {
+			int h = (basket * 7 + i * 13) % 200;
+			lane->scanItem(names[h], 75);
+			lane->scanItem(h, 30);
+		}
+		lane->scanBatch(burst.data(), burst.size());
+		lane->removeItem(names[basket % 200], 30);
+		checked += lane->getTotal(); //checkout
+		pool.release(lane);
+	}
+	long made = allocations.load() - before;
+	before = allocations.load();
+	string counted(100, 'x'); //the hook does see allocations
+
+	REQUIRE(allocations.load() > before);
+	REQUIRE(checked > 0);
+	REQUIRE(made == 0);
+}
@@ -0,0 +1,180 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "pricecache.h"
+#include "pricing.h"
+#include "product.h"
+#include "register.h"
+#include "special.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+TEST_CASE("PriceCache returns what was put for the same handle, version and position, and counts hits and misses", "[pricecache]") {
+	PriceCache cache(100);
+	int price = 0;
+
+	REQUIRE(cache.enabled());
+	REQUIRE(cache.size() == 128);
+	REQUIRE(cache.get(3, 2, 0, price) == false);
+
+	cache.put(3, 2, 0, 199);
+
+	REQUIRE(cache.get(3, 2, 0, price));
+	REQUIRE(price == 199);
+	REQUIRE(cache.get(3, 4, 0, price) == false);
+	REQUIRE(cache.get(3, 2, 1, price) == false);
+	REQUIRE(cache.get(4, 2, 0, price) == false);
+	REQUIRE(cache.getHits() == 1);
+	REQUIRE(cache.getMisses() == 4);
+	REQUIRE(cache.getHitRate() == Approx(0.2));
+
+	cache.clear();
+
+	REQUIRE(cache.get(3, 2, 0, price) == false);
+
+	cache.resize(0);
+
+	REQUIRE(cache.enabled() == false);
+	REQUIRE(cache.getHits() == 0);
+}
+
+TEST_CASE("what one unit adds to a line depends only on its unitPosition", "[pricecache][pricing]") {
+	SpecialTerms bogo;
+	bogo.kind = SPECIAL_BOGO;
+	bogo.purchaseQuantity = 2;
+	bogo.discountQuantity = 1;
+	bogo.discountPercentage = 50;
+	bogo.limit = 7;
+	SpecialTerms bulk;
+	bulk.kind = SPECIAL_BULK;
+	bulk.purchaseQuantity = 4;
+	bulk.discountPrice = 333;
+	const SpecialTerms* terms[] = {nullptr, &bogo, &bulk};
+	for (const SpecialTerms* t : terms) {
+		for (int rounding : {ROUND_HALF_UP, ROUND_HALF_EVEN}) {
+			std::map<int, int> seen;
+			for (int q = 0; q < 40; ++q) {
+				int unit = linePrice(99, false, q + 1, t, rounding) - linePrice(99, false, q, t, rounding);
+				auto res = seen.insert(std::make_pair(unitPosition(q, t), unit));
+
+				REQUIRE(res.first->second == unit);
+			}
+		}
+	}
+}
+
+TEST_CASE("a register with its price cache enabled totals baskets exactly as one without", "[pricecache][register]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	for (int i = 0; i < 30; ++i) {
+		shared_ptr<Product> p = make_shared<Product>("item " + std::to_string(i), 99 + 13 * i, i % 6 == 0);
+		if (i % 3 == 1) {
+			shared_ptr<SpecialBogo> s = make_shared<SpecialBogo>(1 + i % 4, 1, 25 * (i % 5));
+			s->setLimit(i % 2 ? 0 : 5);
+			p->assignSpecial(s);
+		}
+		else if (i % 3 == 2) {
+			p->assignSpecial(make_shared<SpecialBulk>(2 + i % 3, 150 + i));
+		}
+		inv->insert(p);
+	}
+	Register cached;
+	cached.assignInventory(inv);
+	cached.setPriceCache(64);
+	Register plain;
+	plain.assignInventory(inv);
+	std::mt19937 rng(17);
+	for (int i = 0; i < 5000; ++i) {
+		int h = rng() % 30;
+		int w = h % 6 == 0 ? 1 + rng() % 200 : 0;
+		if (rng() % 4 == 0) {
+			REQUIRE(cached.removeItem(h, w) == plain.removeItem(h, w));
+		}
+		else {
+			REQUIRE(cached.scanItem(h, w) == plain.scanItem(h, w));
+		}
+		if (i % 500 == 499) {
+			inv->retrieve(h)->setPrice(inv->retrieve(h)->getPrice() + 10);
+		}
+		if (i % 700 == 699) {
+			cached.reset();
+			plain.reset();
+		}
+
+		REQUIRE(cached.getTotal() == plain.getTotal());
+	}
+	REQUIRE(cached.getPriceCache().getHitRate() > 0.5);
+}
+
+TEST_CASE("changing a product's price, markdown or special stops the cache returning its old prices", "[pricecache][register]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> soda = make_shared<Product>("soda", 150);
+	inv->insert(soda);
+	Register reg;
+	reg.assignInventory(inv);
+	reg.setPriceCache(16);
+	reg.scanItem("soda");
+	reg.scanItem("soda");
+
+	REQUIRE(reg.getTotal() == 300);
+	REQUIRE(reg.getPriceCache().getHits() == 1);
+
+	soda->setPrice(175);
+	reg.scanItem("soda");
+
+	REQUIRE(reg.getTotal() == 475);
+
+	soda->setMarkdown(25);
+	reg.scanItem("soda");
+
+	REQUIRE(reg.getTotal() == 625);
+
+	soda->assignSpecial(make_shared<SpecialBulk>(2, 200));
+	reg.removeItem("soda");
+
+	REQUIRE(reg.getTotal() == 575);
+	REQUIRE(reg.getPriceCache().getHits() == 1);
+}
+
+TEST_CASE("in snapshot mode a published change to a special's terms stops the cache returning its old prices", "[pricecache][register]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> juice = make_shared<Product>("juice", 150);
+	shared_ptr<Special> deal = make_shared<SpecialBulk>(2, 250);
+	juice->assignSpecial(deal);
+	inv->insert(juice);
+	inv->publish();
+	Register reg;
+	reg.assignInventory(inv);
+	reg.setSnapshotMode(true);
+	reg.setPriceCache(16);
+	Register old;
+	old.assignInventory(inv);
+	old.setSnapshotMode(true);
+	old.setPriceCache(16);
+	REQUIRE(reg.scanItems("juice", 2));
+	REQUIRE(reg.removeItem("juice"));
+	REQUIRE(reg.scanItem("juice"));
+	REQUIRE(reg.getTotal() == 250);
+	REQUIRE(old.scanItem("juice"));
+
+	//the special's rows move to a slot with its new terms, so their versions advance
+	deal->setDiscountPrice(200);
+	inv->publish();
+	reg.reset();
+	long long hits = reg.getPriceCache().getHits();
+
+	REQUIRE(reg.scanItem("juice"));
+	REQUIRE(reg.scanItem("juice"));
+	REQUIRE(reg.getTotal() == 200);
+	REQUIRE(reg.getPriceCache().getHits() == hits);
+
+	//a basket pinned before the publish keeps the old terms
+	REQUIRE(old.scanItem("juice"));
+	REQUIRE(old.getTotal() == 250);
+}
@@ -0,0 +1,243 @@
+#include "catch.hpp"
+#include "pricing.h"
+#include "special.h"
+
+#include <memory>
+
+using std::make_shared;
+using std::shared_ptr;
+
+namespace {
+
+int unitByUnit(int p, int q, const Special* s) {
+	//prices each unit the way scanning them one at a time always has
+	int total = 0;
+	for (int k = 0; k < q; ++k) {
+		int unit = p;
+		if (s && (s->getLimit() == 0 || k < s->getLimit())) {
+			if (s->getSpecialType() == "BOGO") {
+				int cycle = s->getPurchaseQuantity() + s->getDiscountQuantity();
+				if (k % cycle >= s->getPurchaseQuantity()) {
+					unit = (int) (p * ((100 - s->getDiscountPercentage()) / 100.0) + .5);
+				}
+			}
+			else if (k % s->getPurchaseQuantity() == s->getPurchaseQuantity() - 1) {
+				unit = s->getDiscountPrice() - p * (s->getPurchaseQuantity() - 1);
+			}
+		}
+		total += unit;
+	}
+	return total;
+}
+
+int legacyDiscountedPrice(int p, int discountPercentage) {
+	//the floating point rounding pricing used before it moved to integers
+	return (int) (p * ((100 - discountPercentage) / 100.0) + .5);
+}
+
+int baselineCalcPrice(int p, int w, int q, const Special* s) {
+	//Register::calcPrice as it was before pricing moved to integers, kept
+	//verbatim apart from taking the special by pointer: what adding w
+	//hundredths of a pound (or one unit if w is 0) to q adds to a line
+	int total = 0;
+	int overLimit = 0; //used for weight priced specials
+	if (w && s && s->getLimit() != 0) {
+		overLimit = w + q - s->getLimit();
+		overLimit = overLimit > 0 ? overLimit : 0;
+		w -= overLimit;
+	}
+	if (w && s) { //special for weighted item
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		int discountPrice = (int) (p * ((100 - discountPercentage) / 100.0) + .5); //cents per lb
+		int price = 0;
+		int fullCycles = w / totalSpecialQuantity; //amount of sets of max full price and discount price quantities
+		w = w % totalSpecialQuantity; //amount left over after taking out full sets
+		price += ((int) ((fullCycles * discountPrice * discountQuantity / 100.0) + (fullCycles * p * purchaseQuantity / 100.0) + .5)); //adding the total of max full and discount price quantities
+		int margin = q % totalSpecialQuantity; //amount of product towards next cycle previously scanned
+		if (margin / purchaseQuantity) { //already in discount price
+			int discPriceQuantity = totalSpecialQuantity - margin; //calculate how much quantity to add until out of discount price range and add
+			discPriceQuantity = discPriceQuantity < w ? discPriceQuantity : w; //check if enough weight to cover dpq range
+			price += ((int) (discountPrice * (discPriceQuantity / 100.0) + .5));
+			w -= discPriceQuantity;
+			price += ((int) (p * (w / 100.0) + .5)); //dump rest into full price
+		}
+		else { //have some way to go in full price
+			int fullPriceQuantity = purchaseQuantity - margin; //calculate how much quantity to add in full price range and add
+			fullPriceQuantity = fullPriceQuantity < w ? fullPriceQuantity : w; //check if enough weight to cover fPQ
+			w -= fullPriceQuantity;
+			price += ((int) (p * (fullPriceQuantity / 100.0) + .5));
+			price += ((int) (discountPrice * (w / 100.0) + .5)); //dump rest into disc price
+		}
+		w = overLimit;
+		total = price;
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BOGO") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountQuantity = s->getDiscountQuantity();
+		int discountPercentage = s->getDiscountPercentage();
+		int totalSpecialQuantity = purchaseQuantity + discountQuantity;
+		if (q % totalSpecialQuantity >= purchaseQuantity) {
+			double discountPrice = 100 - discountPercentage;
+			discountPrice /= 100.0;
+			discountPrice *= p;
+			discountPrice += .5; //for rounding
+			p = (int) discountPrice;
+		}
+	}
+	else if (s && (q < s->getLimit() || s->getLimit() == 0) && s->getSpecialType() == "BULK") {
+		int purchaseQuantity = s->getPurchaseQuantity();
+		int discountPrice = s->getDiscountPrice();
+		if (q % purchaseQuantity == purchaseQuantity - 1) {
+			p = discountPrice - (p * (purchaseQuantity - 1));
+		}
+	}
+	if (w != 0) { //multiply price per pound by quantity in
+		//hundredths of a pound
+		double lbScanned = w / 100.0;
+		double cost = lbScanned * p;
+		cost += .5; //for rounding
+		total += (int) cost;
+	}
+	if (total) { //for weight priced items
+		p = total;
+	}
+	return p;
+}
+
+}
+
+TEST_CASE("linePrice prices a quantity of units without a special at the unit price times the quantity", "[pricing]") {
+	REQUIRE(linePrice(199, false, 0, nullptr) == 0);
+	REQUIRE(linePrice(199, false, 1, nullptr) == 199);
+	REQUIRE(linePrice(199, false, 48, nullptr) == 199 * 48);
+}
+
+TEST_CASE("linePrice gives the same price as pricing each unit in turn for any special, limit and quantity", "[pricing]") {
+	bool allMatch = true;
+	for (int pq = 1; pq <= 4; ++pq) {
+		for (int limit = 0; limit <= 9; limit += 3) {
+			shared_ptr<Special> bulk = make_shared<SpecialBulk>(pq, pq * 150, limit);
+			for (int dq = 0; dq <= 3; ++dq) {
+				shared_ptr<Special> bogo = make_shared<SpecialBogo>(pq, dq, 35 * dq % 101, limit);
+				for (int q = 0; q <= 30; ++q) {
+					allMatch = allMatch && linePrice(299, false, q, &bogo->getTerms()) == unitByUnit(299, q, bogo.get());
+					allMatch = allMatch && linePrice(299, false, q, &bulk->getTerms()) == unitByUnit(299, q, bulk.get());
+				}
+			}
+		}
+	}
+
+	REQUIRE(allMatch);
+}
+
+TEST_CASE("linePrice prices a weight in hundredths of a pound, discounting the covered part of each purchase cycle up to the limit", "[pricing]") {
+	SpecialBogo bacon(200, 100, 50);
+	SpecialBogo shrimp(200, 200, 75, 400);
+
+	REQUIRE(linePrice(376, true, 110, nullptr) == (int) (376 * 1.1 + .5));
+	REQUIRE(linePrice(700, true, 300, &bacon.getTerms()) == 700 * 2 + 350);
+	REQUIRE(linePrice(700, true, 450, &bacon.getTerms()) == 700 * 3 + 350 + 350);
+	REQUIRE(linePrice(500, true, 600, &shrimp.getTerms()) == 500 * 2 + 125 * 2 + 500 * 2);
+	REQUIRE(linePrice(500, true, 300, &shrimp.getTerms()) == 500 * 2 + 125);
+}
+
+TEST_CASE("linePrice takes the same time for any quantity", "[pricing]") {
+	SpecialBogo bogo(2, 1, 100);
+	SpecialBulk bulk(4, 1000, 40);
+
+	REQUIRE(linePrice(300, false, 300000000 / 300 * 3, &bogo.getTerms()) == 300 * 2000000);
+	REQUIRE(linePrice(300, false, 1000000, &bulk.getTerms()) == 1000 * 10 + 300 * (1000000 - 40));
+}
+
+TEST_CASE("integer pricing matches the former floating point pricing of a weighed line, apart from the documented drifts", "[pricing]") {
+	//weighed lines scanned in one go onto an empty line, against the former
+	//calcPrice itself. it drifted from the exact price in three ways, which
+	//are the only differences allowed:
+	//- a line under half a cent rounded to 0, and 0 meant "not weighed", so
+	//  it charged the price of a whole pound
+	//- an exact half of a cent sometimes rounded down, as the double it
+	//  was computed in fell just below the half; it now always rounds up
+	//- the full price, discounted and over the limit parts of a line were
+	//  each rounded on their own, so the line could be a cent off either way
+	//lines built up over several scans aren't compared: a scan crossing
+	//more than one boundary of the purchase cycle put its whole remainder
+	//in one part, so those totals were wrong by far more than rounding
+	long long mismatches = 0;
+	long long ties = 0;
+	long long underHalf = 0;
+	long long split = 0;
+	for (int p = 1; p <= 1000; ++p) {
+		for (int w = 1; w <= 10000; ++w) {
+			int fixed = linePrice(p, true, w, nullptr);
+			int legacy = baselineCalcPrice(p, w, 0, nullptr);
+			long long exact = (long long) p * w;
+			if (exact < 50) {
+				++underHalf;
+				mismatches += fixed != 0 || legacy != p;
+			}
+			else if (exact % 100 == 50) {
+				++ties;
+				mismatches += fixed != (exact + 50) / 100 || (legacy != fixed && legacy != fixed - 1);
+			}
+			else {
+				mismatches += fixed != legacy;
+			}
+		}
+	}
+	for (int p = 1; p <= 20000; ++p) {
+		for (int pct = 0; pct <= 100; ++pct) {
+			SpecialTerms t;
+			t.discountPercentage = pct;
+			int fixed = discountedPrice(p, t, ROUND_HALF_UP);
+			if ((long long) p * (100 - pct) % 100 == 50) {
+				mismatches += fixed != (p * (100 - pct) + 50) / 100;
+			}
+			else {
+				mismatches += fixed != legacyDiscountedPrice(p, pct);
+			}
+		}
+	}
+	SpecialBogo bogo(200, 100, 35, 900);
+	for (int p = 1; p <= 1000; ++p) {
+		for (int w = 1; w <= 2000; ++w) {
+			int fixed = linePrice(p, true, w, &bogo.getTerms());
+			int legacy = baselineCalcPrice(p, w, 0, &bogo);
+			long long exact = (long long) p * w;
+			if (exact < 50) {
+				++underHalf;
+				mismatches += fixed != 0 || legacy != p;
+			}
+			else if (w <= bogo.getPurchaseQuantity()) {
+				//all at full price, in one part
+				bool tie = exact % 100 == 50;
+				ties += tie;
+				mismatches += tie ? fixed != (exact + 50) / 100 || (legacy != fixed && legacy != fixed - 1) : fixed != legacy;
+			}
+			else {
+				split += fixed != legacy;
+				mismatches += fixed - legacy > 1 || legacy - fixed > 1;
+			}
+		}
+	}
+
+	REQUIRE(ties > 0);
+	REQUIRE(underHalf > 0);
+	REQUIRE(split > 0);
+	REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("the rounding policy decides exact halves of a cent, rounding half up or to the even cent", "[pricing]") {
+	SpecialBogo bogo(1, 1, 50);
+
+	REQUIRE(linePrice(50, true, 1, nullptr, ROUND_HALF_UP) == 1);
+	REQUIRE(linePrice(50, true, 1, nullptr, ROUND_HALF_EVEN) == 0);
+	REQUIRE(linePrice(50, true, 3, nullptr, ROUND_HALF_EVEN) == 2);
+	REQUIRE(linePrice(50, true, 2, nullptr, ROUND_HALF_EVEN) == 1);
+	REQUIRE(linePrice(51, true, 1, nullptr, ROUND_HALF_EVEN) == 1);
+	REQUIRE(linePrice(5, false, 2, &bogo.getTerms(), ROUND_HALF_UP) == 5 + 3);
+	REQUIRE(linePrice(5, false, 2, &bogo.getTerms(), ROUND_HALF_EVEN) == 5 + 2);
+	REQUIRE(linePrice(7, false, 2, &bogo.getTerms(), ROUND_HALF_EVEN) == 7 + 4);
+}
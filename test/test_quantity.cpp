@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "quantity.h"
+
+#include <map>
+
+using std::map;
+
+TEST_CASE("QuantityStore keeps a quantity per handle in first scan order and get never adds a line", "[quantity]") {
+	QuantityStore store;
+
+	REQUIRE(store.get(42) == 0);
+	REQUIRE(store.size() == 0);
+
+	store.set(42, 3);
+	store.set(7, 150);
+	store.set(42, 5);
+	store.set(9, 0);
+
+	REQUIRE(store.size() == 2);
+	REQUIRE(store.get(42) == 5);
+	REQUIRE(store.get(7) == 150);
+	REQUIRE(store.get(9) == 0);
+	REQUIRE(store.line(0).handle == 42);
+	REQUIRE(store.line(1).handle == 7);
+
+	SECTION("a line brought back to 0 keeps its place") {
+		store.set(42, 0);
+		store.set(42, 1);
+
+		REQUIRE(store.size() == 2);
+		REQUIRE(store.line(0).handle == 42);
+		REQUIRE(store.line(0).quantity == 1);
+	}
+	SECTION("clear empties the store") {
+		store.clear();
+
+		REQUIRE(store.size() == 0);
+		REQUIRE(store.get(42) == 0);
+	}
+}
+
+TEST_CASE("QuantityStore gives the same quantities as a map for baskets on both sides of the inline limit", "[quantity]") {
+	QuantityStore store;
+	unsigned seed = 11;
+	bool allMatch = true;
+	for (int basket = 0; basket < 60; ++basket) {
+		map<int, int> expected;
+		int distinct = 1 + basket * 3;
+		for (int k = 0; k < distinct * 4; ++k) {
+			seed = seed * 1103515245u + 12345u;
+			int h = (int) (seed / 65536 % distinct) * 1009;
+			int q = (int) (seed % 50);
+			store.set(h, q);
+			if (q != 0 || expected.count(h)) {
+				expected[h] = q;
+			}
+			allMatch = allMatch && store.get(h + 1) == 0;
+		}
+		for (const auto& e : expected) {
+			allMatch = allMatch && store.get(e.first) == e.second;
+		}
+		allMatch = allMatch && store.size() == (int) expected.size();
+		store.clear();
+	}
+
+	REQUIRE(allMatch);
+}
+
+TEST_CASE("QuantityStore lines filled in after assign can be looked up once indexed, and duplicate handles are refused", "[quantity]") {
+	QuantityStore store;
+	for (int n : {5, 40}) {
+		QuantityStore::Line* lines = store.assign(n);
+		for (int i = 0; i < n; ++i) {
+			lines[i].handle = i * 7;
+			lines[i].quantity = i + 1;
+		}
+
+		REQUIRE(store.index());
+		REQUIRE(store.size() == n);
+		REQUIRE(store.get(7 * (n - 1)) == n);
+		REQUIRE(store.get(3) == 0);
+
+		store.set(1000, 2);
+
+		REQUIRE(store.line(n).handle == 1000);
+
+		lines = store.assign(n);
+		for (int i = 0; i < n; ++i) {
+			lines[i].handle = i % (n - 1);
+			lines[i].quantity = 1;
+		}
+
+		REQUIRE(store.index() == false);
+		REQUIRE(store.size() == 0);
+	}
+}
@@ -0,0 +1,162 @@
+#include "catch.hpp"
+#include "inventory.h"
+#include "product.h"
+#include "receipt.h"
+#include "register.h"
+#include "special.h"
+
+#include <memory>
+#include <string>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+namespace {
+
+shared_ptr<Inventory> receiptInventory() {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> soda = make_shared<Product>("soda", 150);
+	soda->assignSpecial(make_shared<SpecialBogo>(1, 1, 100));
+	inv->insert(soda);
+	shared_ptr<Product> bananas = make_shared<Product>("bananas", 59, true);
+	bananas->setMarkdown(10);
+	inv->insert(bananas);
+	inv->insert(make_shared<Product>("\"quoted\" jam", 425));
+	inv->insert(make_shared<Product>("gum", 99));
+	return inv;
+}
+
+string writeAll(ReceiptWriter& writer, size_t chunk) {
+	string out;
+	char buffer[256];
+	while (!writer.done()) {
+		size_t n = writer.write(buffer, chunk);
+		if (n == 0 && !writer.done()) {
+			return "buffer too small";
+		}
+		out.append(buffer, n);
+	}
+	return out;
+}
+
+}
+
+TEST_CASE("ReceiptWriter writes a text receipt with markdowns and special savings under each line", "[receipt]") {
+	shared_ptr<Inventory> inv = receiptInventory();
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("soda");
+	reg.scanItem("soda");
+	reg.scanItem("bananas", 250);
+	reg.scanItem("gum");
+	reg.removeItem("gum");
+	ReceiptWriter writer(reg);
+
+	REQUIRE(writeAll(writer, 256) ==
+		"soda                     2 @ 1.50  1.50\n"
+		"    BOGO savings -1.50\n"
+		"bananas                  2.50 lb @ 0.59  1.23\n"
+		"    markdown -0.10 /lb\n"
+		"SAVINGS 1.50\n"
+		"TOTAL 2.73\n");
+}
+
+TEST_CASE("ReceiptWriter writes a JSON receipt with amounts in cents and names escaped", "[receipt]") {
+	shared_ptr<Inventory> inv = receiptInventory();
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("gum");
+	reg.removeItem("gum");
+	reg.scanItem("\"quoted\" jam");
+	reg.scanItem("soda");
+	ReceiptWriter writer(reg, RECEIPT_JSON);
+
+	REQUIRE(writeAll(writer, 256) ==
+		"{\"lines\":["
+		"{\"name\":\"\\\"quoted\\\" jam\",\"quantity\":1,\"byWeight\":false,\"price\":425,\"markdown\":0,\"special\":\"\",\"savings\":0,\"amount\":425},"
+		"{\"name\":\"soda\",\"quantity\":1,\"byWeight\":false,\"price\":150,\"markdown\":0,\"special\":\"BOGO\",\"savings\":0,\"amount\":150}"
+		"],\"savings\":0,\"total\":575}\n");
+}
+
+TEST_CASE("ReceiptWriter streams through a small buffer, writing only whole pieces, and gives the same receipt", "[receipt]") {
+	shared_ptr<Inventory> inv = receiptInventory();
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("soda");
+	reg.scanItem("bananas", 125);
+	reg.scanItem("soda");
+	reg.scanItem("gum");
+	for (int format : {RECEIPT_TEXT, RECEIPT_JSON}) {
+		ReceiptWriter whole(reg, format);
+		ReceiptWriter streamed(reg, format);
+		string expected = writeAll(whole, 256);
+
+		REQUIRE(writeAll(streamed, 150) == expected);
+	}
+
+	ReceiptWriter tooSmall(reg, RECEIPT_JSON);
+	char buffer[8];
+
+	REQUIRE(tooSmall.write(buffer, sizeof(buffer)) == 0);
+	REQUIRE(tooSmall.done() == false);
+}
+
+TEST_CASE("ReceiptWriter splits a mix and match run over its lines, and a removal that breaks the run reprices every line in it", "[receipt][mix]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Special> deal = make_shared<SpecialMix>(3, 500);
+	for (const char* name : {"a", "b", "c"}) {
+		shared_ptr<Product> p = make_shared<Product>(name, 200);
+		p->assignSpecial(deal);
+		inv->insert(p);
+	}
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItem("a");
+	reg.scanItem("b");
+	reg.scanItem("c");
+	ReceiptWriter deal3(reg);
+
+	REQUIRE(writeAll(deal3, 256) ==
+		"a                        1 @ 2.00  1.66\n"
+		"    MIX savings -0.34\n"
+		"b                        1 @ 2.00  1.67\n"
+		"    MIX savings -0.33\n"
+		"c                        1 @ 2.00  1.67\n"
+		"    MIX savings -0.33\n"
+		"SAVINGS 1.00\n"
+		"TOTAL 5.00\n");
+
+	reg.removeItem("a");
+	int amounts = 0;
+	for (int i = 0; i < reg.getLineCount(); ++i) {
+		amounts += reg.getLineItem(i).amount;
+	}
+	ReceiptWriter broken(reg);
+
+	REQUIRE(reg.getLineItem(0).amount == 0);
+	REQUIRE(reg.getLineItem(0).savings == 0);
+	REQUIRE(amounts == reg.getTotal());
+	REQUIRE(writeAll(broken, 256) ==
+		"b                        1 @ 2.00  2.00\n"
+		"c                        1 @ 2.00  2.00\n"
+		"TOTAL 4.00\n");
+}
+
+TEST_CASE("ReceiptWriter shows a line whose special costs more than its own prices as added, with one sign", "[receipt]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	shared_ptr<Product> mints = make_shared<Product>("mints", 200);
+	mints->assignSpecial(make_shared<SpecialMix>(2, 500));
+	inv->insert(mints);
+	Register reg;
+	reg.assignInventory(inv);
+	reg.scanItems("mints", 2);
+	ReceiptWriter writer(reg);
+
+	REQUIRE(reg.getLineItem(0).savings == -100);
+	REQUIRE(writeAll(writer, 256) ==
+		"mints                    2 @ 2.00  5.00\n"
+		"    MIX savings +1.00\n"
+		"SAVINGS -1.00\n"
+		"TOTAL 5.00\n");
+}
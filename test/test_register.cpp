@@ -4,9 +4,13 @@
 #include "register.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 using std::make_shared;
 using std::shared_ptr;
+using std::string;
+using std::vector;
 
 TEST_CASE("assignInventory assigns an inventory object to the register", "[register]") {
 	Register testRegister;
@@ -190,6 +194,242 @@ TEST_CASE("removeItem removes a product from the register and reduces the total
 	}
 }
 
+TEST_CASE("scanItem and removeItem accept an inventory handle in place of a product name", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("soup", 189));
+	testInventoryPtr->insert(make_shared<Product>("grapes", 299, true));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	int soup = testInventoryPtr->getHandle("soup");
+	int grapes = testInventoryPtr->getHandle("grapes");
+
+	SECTION("scanning by handle updates the same quantity and total as scanning by name") {
+		REQUIRE(testRegister.scanItem(soup) == true);
+		testRegister.scanItem("soup");
+
+		REQUIRE(testRegister.getQuantity(soup) == 2);
+		REQUIRE(testRegister.getQuantity("soup") == 2);
+		REQUIRE(testRegister.getTotal() == 189 * 2);
+	}
+	SECTION("scanning and removing a weighted product by handle uses the passed weight") {
+		testRegister.scanItem(grapes, 250);
+		testRegister.removeItem(grapes, 50);
+
+		REQUIRE(testRegister.getQuantity(grapes) == 200);
+		REQUIRE(testRegister.getTotal() == (int) (299 * (250 / 100.0) + .5) - (int) (299 * (50 / 100.0) + .5));
+	}
+	SECTION("scanItem and removeItem return false when passed a handle not in the inventory") {
+		REQUIRE(testRegister.scanItem(7) == false);
+		REQUIRE(testRegister.removeItem(-1) == false);
+		REQUIRE(testRegister.getQuantity(7) == 0);
+	}
+	SECTION("removeItem returns false when passed a product name not in the inventory") {
+		REQUIRE(testRegister.removeItem("bagels") == false);
+	}
+}
+
+TEST_CASE("scanItems and removeItems scan and remove several units of a product in one step, pricing specials as if scanned one at a time", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	shared_ptr<Product> prodPtr = make_shared<Product>("seltzer", 99);
+	prodPtr->assignSpecial(make_shared<SpecialBulk>(12, 999, 24));
+	testInventoryPtr->insert(prodPtr);
+	testInventoryPtr->insert(make_shared<Product>("limes", 349, true));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+
+	REQUIRE(testRegister.scanItems("seltzer", 48) == true);
+	REQUIRE(testRegister.getQuantity("seltzer") == 48);
+	REQUIRE(testRegister.getTotal() == 999 * 2 + 99 * 24);
+
+	REQUIRE(testRegister.removeItems("seltzer", 30) == true);
+	REQUIRE(testRegister.getQuantity("seltzer") == 18);
+	REQUIRE(testRegister.getTotal() == 999 + 99 * 6);
+
+	testRegister.scanItem("seltzer");
+
+	REQUIRE(testRegister.getTotal() == 999 + 99 * 7);
+
+	SECTION("removeItems returns false and changes nothing when removing more units than were scanned") {
+		REQUIRE(testRegister.removeItems("seltzer", 20) == false);
+		REQUIRE(testRegister.getQuantity("seltzer") == 19);
+	}
+	SECTION("scanItems and removeItems return false for a count below 1 or a product priced by weight") {
+		REQUIRE(testRegister.scanItems("seltzer", 0) == false);
+		REQUIRE(testRegister.removeItems("seltzer", -2) == false);
+		REQUIRE(testRegister.scanItems("limes", 3) == false);
+		REQUIRE(testRegister.scanItems("kumquats", 3) == false);
+		REQUIRE(testRegister.getTotal() == 999 + 99 * 7);
+	}
+}
+
+TEST_CASE("scanBatch and removeBatch give the same total, quantities and per entry results as scanning or removing each entry in turn", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	vector<string> names;
+	for (int i = 0; i < 12; ++i) {
+		names.push_back("item" + std::to_string(i));
+		shared_ptr<Product> prodPtr = make_shared<Product>(names[i], 100 + 37 * i, i % 4 == 3);
+		if (i % 3 == 1) {
+			prodPtr->assignSpecial(make_shared<SpecialBogo>(2, 1, 40, i % 2 ? 5 : 0));
+		}
+		else if (i % 3 == 2) {
+			prodPtr->assignSpecial(make_shared<SpecialBulk>(3, 250, i % 2 ? 6 : 0));
+		}
+		testInventoryPtr->insert(prodPtr);
+	}
+	names.push_back("unknown");
+	testInventoryPtr->erase("item11");
+	Register batched;
+	Register single;
+	batched.assignInventory(testInventoryPtr);
+	single.assignInventory(testInventoryPtr);
+	unsigned seed = 7;
+	bool allMatch = true;
+	for (int round = 0; round < 200; ++round) {
+		vector<ScanEntry> entries;
+		int count = 1 + round % 40;
+		for (int k = 0; k < count; ++k) {
+			seed = seed * 1103515245u + 12345u;
+			int p = seed / 65536 % names.size();
+			int w = seed / 16 % 3 == 0 ? 0 : seed / 256 % 150;
+			if (seed % 2) {
+				entries.push_back(ScanEntry(names[p], w));
+			}
+			else {
+				entries.push_back(ScanEntry(p == 12 ? 40 : p, w));
+			}
+		}
+		bool removing = round % 3 == 2;
+		bool status[40];
+		int done = removing ? batched.removeBatch(entries.data(), entries.size(), status)
+			: batched.scanBatch(entries.data(), entries.size(), status);
+		int expected = 0;
+		for (size_t k = 0; k < entries.size(); ++k) {
+			const ScanEntry& e = entries[k];
+			bool ok;
+			if (e.name) {
+				string n(e.name, e.length);
+				ok = removing ? single.removeItem(n, e.weight) : single.scanItem(n, e.weight);
+			}
+			else {
+				ok = removing ? single.removeItem(e.handle, e.weight) : single.scanItem(e.handle, e.weight);
+			}
+			allMatch = allMatch && ok == status[k];
+			expected += ok;
+		}
+		allMatch = allMatch && done == expected && batched.getTotal() == single.getTotal();
+		for (int h = 0; h < 12; ++h) {
+			allMatch = allMatch && batched.getQuantity(h) == single.getQuantity(h);
+		}
+	}
+
+	REQUIRE(allMatch);
+	REQUIRE(batched.getTotal() > 0);
+}
+
+TEST_CASE("setRounding chooses how the register rounds half cents when pricing weighed products", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("saffron", 250, true));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+
+	REQUIRE(testRegister.getRounding() == ROUND_HALF_UP);
+
+	testRegister.scanItem("saffron", 1);
+
+	REQUIRE(testRegister.getTotal() == 3);
+
+	testRegister.reset();
+	testRegister.setRounding(ROUND_HALF_EVEN);
+	testRegister.scanItem("saffron", 1);
+
+	REQUIRE(testRegister.getTotal() == 2);
+
+	testRegister.scanItem("saffron", 1);
+
+	REQUIRE(testRegister.getTotal() == 5);
+}
+
+TEST_CASE("scanItem returns false for a product erased from the inventory, while one already in the basket can still be removed by handle", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("eggnog", 499));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	int eggnog = testInventoryPtr->getHandle("eggnog");
+	testRegister.scanItem("eggnog");
+	testInventoryPtr->erase("eggnog");
+
+	REQUIRE(testRegister.scanItem("eggnog") == false);
+	REQUIRE(testRegister.scanItem(eggnog) == false);
+	REQUIRE(testRegister.removeItem(eggnog) == true);
+	REQUIRE(testRegister.getTotal() == 0);
+}
+
+TEST_CASE("reset starts a new basket, clearing the total and quantities", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("butter", 459));
+	testInventoryPtr->insert(make_shared<Product>("salmon", 1299, true));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	testRegister.scanItem("butter");
+	testRegister.scanItem("salmon", 150);
+	testRegister.reset();
+
+	REQUIRE(testRegister.getTotal() == 0);
+	REQUIRE(testRegister.getQuantity("butter") == 0);
+	REQUIRE(testRegister.getQuantity("salmon") == 0);
+	REQUIRE(testRegister.removeItem("butter") == false);
+
+	testRegister.scanItem("butter");
+
+	REQUIRE(testRegister.getTotal() == 459);
+}
+
+TEST_CASE("in snapshot mode a register prices a whole basket against the inventory version published when the basket started", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	shared_ptr<Product> prodPtr = make_shared<Product>("olive oil", 1099);
+	testInventoryPtr->insert(prodPtr);
+	testInventoryPtr->publish();
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	testRegister.setSnapshotMode(true);
+	testRegister.scanItem("olive oil");
+
+	REQUIRE(testRegister.getSnapshotVersion() == 1);
+
+	prodPtr->setPrice(1199);
+	testInventoryPtr->insert(make_shared<Product>("vinegar", 399));
+	testInventoryPtr->publish();
+
+	SECTION("changes published mid basket don't affect the basket") {
+		testRegister.scanItem("olive oil");
+
+		REQUIRE(testRegister.getTotal() == 1099 * 2);
+		REQUIRE(testRegister.scanItem("vinegar") == false);
+
+		testRegister.removeItem("olive oil");
+
+		REQUIRE(testRegister.getTotal() == 1099);
+		REQUIRE(testRegister.getSnapshotVersion() == 1);
+	}
+	SECTION("the next basket after reset pins the latest published version") {
+		testRegister.reset();
+		testRegister.scanItem("olive oil");
+
+		REQUIRE(testRegister.getSnapshotVersion() == 2);
+		REQUIRE(testRegister.getTotal() == 1199);
+		REQUIRE(testRegister.scanItem("vinegar") == true);
+	}
+	SECTION("a register not in snapshot mode sees changes as soon as they are made") {
+		Register liveRegister;
+		liveRegister.assignInventory(testInventoryPtr);
+		prodPtr->setPrice(1249);
+		liveRegister.scanItem("olive oil");
+
+		REQUIRE(liveRegister.getTotal() == 1249);
+		REQUIRE(liveRegister.getSnapshotVersion() == 0);
+	}
+}
+
 TEST_CASE("calcPrice calculates the price correctly when the scanned item has an associated special") {
 		shared_ptr<Inventory> testInventory = make_shared<Inventory>();
 		shared_ptr<Product> prodPtr = make_shared<Product>("fish", 598);
@@ -413,3 +653,139 @@ TEST_CASE("calcPrice calculates the price correctly when the scanned item has an
 		REQUIRE(testRegister.getTotal() == 1125);
 	}
 }
+
+TEST_CASE("getLineItem reports each line in first scan order with its pricing, and the line amounts sum to the total", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	shared_ptr<Product> soup = make_shared<Product>("soup", 189);
+	soup->assignSpecial(make_shared<SpecialBulk>(3, 500));
+	testInventoryPtr->insert(soup);
+	shared_ptr<Product> apples = make_shared<Product>("apples", 299, true);
+	apples->setMarkdown(50);
+	testInventoryPtr->insert(apples);
+	testInventoryPtr->insert(make_shared<Product>("bread", 349));
+	Register testRegister;
+	testRegister.assignInventory(testInventoryPtr);
+	testRegister.scanItems("soup", 4);
+	testRegister.scanItem("apples", 150);
+	testRegister.scanItem("bread");
+	testRegister.removeItem("bread");
+	ScanEntry burst[] = {ScanEntry(string("soup")), ScanEntry(string("soup"))};
+	testRegister.scanBatch(burst, 2);
+
+	REQUIRE(testRegister.getLineCount() == 3);
+
+	LineItem soupLine = testRegister.getLineItem(0);
+	LineItem appleLine = testRegister.getLineItem(1);
+	LineItem breadLine = testRegister.getLineItem(2);
+
+	REQUIRE(soupLine.handle == testInventoryPtr->getHandle("soup"));
+	REQUIRE(soupLine.quantity == 6);
+	REQUIRE(soupLine.specialKind == SPECIAL_BULK);
+	REQUIRE(soupLine.amount == 1000);
+	REQUIRE(soupLine.savings == 189 * 6 - 1000);
+	REQUIRE(appleLine.byWeight);
+	REQUIRE(appleLine.quantity == 150);
+	REQUIRE(appleLine.price == 299);
+	REQUIRE(appleLine.markdown == 50);
+	REQUIRE(appleLine.amount == 374);
+	REQUIRE(appleLine.savings == 0);
+	REQUIRE(breadLine.quantity == 0);
+	REQUIRE(breadLine.amount == 0);
+	REQUIRE(soupLine.amount + appleLine.amount + breadLine.amount == testRegister.getTotal());
+
+	testRegister.reset();
+
+	REQUIRE(testRegister.getLineCount() == 0);
+}
+
+TEST_CASE("resume restores a basket written by suspend, on the same or another register, and rejects damaged blobs", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	shared_ptr<Product> soup = make_shared<Product>("soup", 189);
+	soup->assignSpecial(make_shared<SpecialBogo>(1, 1, 50));
+	testInventoryPtr->insert(soup);
+	testInventoryPtr->insert(make_shared<Product>("apples", 299, true));
+	testInventoryPtr->insert(make_shared<Product>("bread", 349));
+	Register kiosk;
+	kiosk.assignInventory(testInventoryPtr);
+	kiosk.setRounding(ROUND_HALF_EVEN);
+	kiosk.scanItems("soup", 3);
+	kiosk.scanItem("bread");
+	kiosk.scanItem("apples", 150);
+	kiosk.removeItem("bread");
+	char blob[1024];
+	size_t size = kiosk.suspend(blob, sizeof(blob));
+
+	REQUIRE(size == kiosk.suspendedSize());
+	REQUIRE(kiosk.suspend(blob, size - 1) == 0);
+
+	Register lane;
+	lane.assignInventory(testInventoryPtr);
+	lane.scanItem("bread");
+
+	SECTION("the basket comes back line for line") {
+		REQUIRE(lane.resume(blob, size));
+		REQUIRE(lane.getTotal() == kiosk.getTotal());
+		REQUIRE(lane.getRounding() == ROUND_HALF_EVEN);
+		REQUIRE(lane.getLineCount() == 3);
+		for (int i = 0; i < 3; ++i) {
+			LineItem a = kiosk.getLineItem(i);
+			LineItem b = lane.getLineItem(i);
+
+			REQUIRE(a.handle == b.handle);
+			REQUIRE(a.quantity == b.quantity);
+			REQUIRE(a.byWeight == b.byWeight);
+			REQUIRE(a.price == b.price);
+			REQUIRE(a.specialKind == b.specialKind);
+			REQUIRE(a.amount == b.amount);
+			REQUIRE(a.savings == b.savings);
+		}
+
+		lane.scanItem("soup");
+		kiosk.scanItem("soup");
+
+		REQUIRE(lane.getTotal() == kiosk.getTotal());
+	}
+	SECTION("a blob with a changed byte, a changed length or another format version is refused") {
+		blob[40] ^= 1;
+
+		REQUIRE(lane.resume(blob, size) == false);
+
+		blob[40] ^= 1;
+
+		REQUIRE(lane.resume(blob, size - 1) == false);
+
+		blob[4] = 9;
+
+		REQUIRE(lane.resume(blob, size) == false);
+		REQUIRE(lane.getTotal() == 349);
+		REQUIRE(lane.getQuantity("bread") == 1);
+	}
+}
+
+TEST_CASE("in snapshot mode a resumed basket is pinned to its catalog version while it is the latest published", "[register]") {
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	shared_ptr<Product> tea = make_shared<Product>("tea", 450);
+	testInventoryPtr->insert(tea);
+	Register kiosk;
+	kiosk.assignInventory(testInventoryPtr);
+	kiosk.setSnapshotMode(true);
+	kiosk.scanItem("tea");
+	char blob[256];
+	size_t size = kiosk.suspend(blob, sizeof(blob));
+	Register lane;
+	lane.assignInventory(testInventoryPtr);
+	lane.setSnapshotMode(true);
+
+	REQUIRE(lane.resume(blob, size));
+	REQUIRE(lane.getSnapshotVersion() == kiosk.getSnapshotVersion());
+
+	tea->setPrice(500);
+	testInventoryPtr->publish();
+
+	REQUIRE(lane.resume(blob, size));
+	REQUIRE(lane.getSnapshotVersion() == 0);
+
+	lane.scanItem("tea");
+
+	REQUIRE(lane.getTotal() == 950);
+}
@@ -71,3 +71,20 @@ TEST_CASE("SpecialBulk is a type of Special which contains members which denote
 		REQUIRE(testSpecial.getSpecialType() == "BULK");
 	}
 }
+
+TEST_CASE("getTerms returns the special's kind and parameters as plain data which tracks later changes made through the setters") {
+	SpecialBogo bogo(2, 1, 75, 6);
+	SpecialBulk bulk(3, 500);
+	bogo.setDiscountPercentage(50);
+	bulk.setDiscountQuantity(4);
+
+	REQUIRE(bogo.getTerms().kind == SPECIAL_BOGO);
+	REQUIRE(bogo.getTerms().purchaseQuantity == 2);
+	REQUIRE(bogo.getTerms().discountQuantity == 1);
+	REQUIRE(bogo.getTerms().discountPercentage == 50);
+	REQUIRE(bogo.getTerms().limit == 6);
+	REQUIRE(bulk.getTerms().kind == SPECIAL_BULK);
+	REQUIRE(bulk.getTerms().discountPrice == 500);
+	REQUIRE(bulk.getTerms().discountQuantity == 0);
+	REQUIRE(bulk.getDiscountQuantity() == 0);
+}
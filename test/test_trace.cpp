@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include "importer.h"
+#include "inventory.h"
+#include "product.h"
+#include "register.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+namespace {
+
+string tracePath(const char* name) {
+	return string("/tmp/test_trace_") + std::to_string(getpid()) + "_" + name;
+}
+
+string readFile(const string& path) {
+	std::ifstream in(path);
+	std::stringstream s;
+	s << in.rdbuf();
+	return s.str();
+}
+
+}
+
+TEST_CASE("a TraceGenerator writes the same price file and trace for the same seed", "[trace]") {
+	TraceConfig config;
+	config.skus = 200;
+	config.sessions = 50;
+	string prices = tracePath("prices.csv"), trace = tracePath("sessions.trace");
+	string prices2 = tracePath("prices2.csv"), trace2 = tracePath("sessions2.trace");
+	REQUIRE(TraceGenerator(config).write(prices, trace));
+	REQUIRE(TraceGenerator(config).write(prices2, trace2));
+	REQUIRE(readFile(prices) == readFile(prices2));
+	REQUIRE(readFile(trace) == readFile(trace2));
+	config.seed = 2;
+	REQUIRE(TraceGenerator(config).write(prices2, trace2));
+	REQUIRE(readFile(trace) != readFile(trace2));
+
+	Inventory inv;
+	CsvImporter importer;
+	REQUIRE(importer.load(prices, inv));
+	REQUIRE(importer.getImported() == 200);
+	REQUIRE(importer.getRejects().empty());
+	for (const string& p : {prices, trace, prices2, trace2}) {
+		remove(p.c_str());
+	}
+}
+
+TEST_CASE("a TraceReplay gives the same session totals on any number of threads as scanning them by hand", "[trace]") {
+	TraceConfig config;
+	config.skus = 500;
+	config.sessions = 300;
+	config.removalRate = 0.1;
+	string prices = tracePath("replay.csv"), trace = tracePath("replay.trace");
+	REQUIRE(TraceGenerator(config).write(prices, trace));
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	CsvImporter importer;
+	REQUIRE(importer.load(prices, *inv));
+
+	TraceReplay replay(inv);
+	REQUIRE(replay.load(trace));
+	REQUIRE(replay.getSessions() == 300);
+	REQUIRE(replay.getMalformed() == 0);
+	ReplayResult one = replay.run(1);
+	ReplayResult four = replay.run(4);
+	REQUIRE(one.sessions == 300);
+	REQUIRE(one.events == (long long) replay.getEvents());
+	REQUIRE(one.rejected == 0);
+	REQUIRE(one.totals == four.totals);
+	REQUIRE(one.checksum == four.checksum);
+	REQUIRE(one.totalCents == four.totalCents);
+	REQUIRE(one.totalCents > 0);
+	REQUIRE(one.sessionP50 <= one.sessionP99);
+	REQUIRE(one.sessionP99 <= one.sessionP999);
+
+	//the same trace read line by line straight into a register
+	std::ifstream in(trace);
+	string line;
+	Register reg;
+	reg.assignInventory(inv);
+	size_t session = 0;
+	bool same = true;
+	while (std::getline(in, line)) {
+		if (line == "B") {
+			reg.reset();
+		}
+		else if (line == "E") {
+			same = same && reg.getTotal() == one.totals[session++];
+		}
+		else {
+			size_t comma = line.find(',', 2);
+			string name = line.substr(2, comma == string::npos ? string::npos : comma - 2);
+			int weight = comma == string::npos ? 0 : std::stoi(line.substr(comma + 1));
+			line[0] == 'S' ? reg.scanItem(name, weight) : reg.removeItem(name, weight);
+		}
+	}
+	REQUIRE(session == 300);
+	REQUIRE(same);
+	remove(prices.c_str());
+	remove(trace.c_str());
+}
+
+TEST_CASE("a TraceReplay skips unfinished sessions and malformed lines and rejects unknown products", "[trace]") {
+	shared_ptr<Inventory> inv = make_shared<Inventory>();
+	inv->insert(make_shared<Product>("soup", 189));
+	inv->insert(make_shared<Product>("bananas", 249, true));
+	TraceReplay replay(inv);
+	const char* text =
+		"S,soup\n"
+		"B\nS,soup\nS,bananas,200\nS,caviar\nX,soup\nS,bananas,2x\nR,soup\nE\n"
+		"\n"
+		"B\nS,soup\nB\nS,soup\nS,soup\nE\n"
+		"B\nS,soup\n";
+	replay.parse(text, strlen(text));
+	REQUIRE(replay.getSessions() == 2);
+	REQUIRE(replay.getEvents() == 6);
+	REQUIRE(replay.getMalformed() == 5);
+	ReplayResult r = replay.run(2);
+	REQUIRE(r.rejected == 1);
+	REQUIRE(r.totals.size() == 2);
+	REQUIRE(r.totals[0] == 498);
+	REQUIRE(r.totals[1] == 378);
+}
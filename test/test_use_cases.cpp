@@ -3,6 +3,7 @@
 #include "product.h"
 #include "register.h"
 
+#include <cstdio>
 #include <memory>
 
 using std::make_shared;
@@ -196,3 +197,41 @@ TEST_CASE("after configuring an inventory with products, a register repeatedly a
 		REQUIRE(testRegister.getTotal() == total - 1750);
 	}
 }
+
+TEST_CASE("a register scanning against an inventory mapped from a saved catalog file totals the same as against the original inventory", "[inventory][register]") {
+	const char* path = "test_use_cases.catalog";
+	shared_ptr<Inventory> testInventoryPtr = make_shared<Inventory>();
+	testInventoryPtr->insert(make_shared<Product>("tea", 299));
+	shared_ptr<Product> testPtr = make_shared<Product>("cereal", 299);
+	testPtr->assignSpecial(make_shared<SpecialBogo>(1, 1, 50, 2));
+	testInventoryPtr->insert(testPtr);
+	testPtr = make_shared<Product>("coke", 499);
+	testPtr->assignSpecial(make_shared<SpecialBulk>(3, 1200, 3));
+	testInventoryPtr->insert(testPtr);
+	testPtr = make_shared<Product>("shrimp", 700, true);
+	testPtr->assignSpecial(make_shared<SpecialBogo>(300, 100, 50, 400));
+	testInventoryPtr->insert(testPtr);
+	testInventoryPtr->save(path);
+	shared_ptr<Inventory> mappedPtr = make_shared<Inventory>();
+	mappedPtr->mapFile(path);
+	Register original;
+	original.assignInventory(testInventoryPtr);
+	Register fromFile;
+	fromFile.assignInventory(mappedPtr);
+	const char* scans[] = {"tea", "cereal", "cereal", "coke", "cereal", "coke", "coke", "coke", "tea"};
+
+	for (const char* s : scans) {
+		original.scanItem(s);
+		fromFile.scanItem(s);
+	}
+	original.scanItem("shrimp", 500);
+	fromFile.scanItem("shrimp", 500);
+	original.removeItem("cereal");
+	fromFile.removeItem("cereal");
+
+	REQUIRE(fromFile.getTotal() == original.getTotal());
+	REQUIRE(fromFile.getQuantity("coke") == 4);
+
+	mappedPtr = nullptr;
+	std::remove(path);
+}
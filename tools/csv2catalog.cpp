@@ -0,0 +1,28 @@
+//converts a price file into a catalog file which Inventory::mapFile can serve
+//lookups from, printing any rejected rows
+#include "importer.h"
+#include "inventory.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s prices.csv out.catalog\n", argv[0]);
+		return 2;
+	}
+	Inventory inventory;
+	CsvImporter importer;
+	if (!importer.load(argv[1], inventory)) {
+		perror(argv[1]);
+		return 1;
+	}
+	for (const ImportReject& r : importer.getRejects()) {
+		fprintf(stderr, "%s:%ld: %s\n", argv[1], r.line, r.reason.c_str());
+	}
+	if (!inventory.save(argv[2])) {
+		perror(argv[2]);
+		return 1;
+	}
+	printf("%ld products written to %s, %zu rows rejected\n", importer.getImported(), argv[2], importer.getRejects().size());
+	return 0;
+}
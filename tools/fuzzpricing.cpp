@@ -0,0 +1,22 @@
+//plays random catalogs and baskets through the register's pricing paths
+//and a naive reference, printing a minimal failing case if any disagree
+#include "fuzz.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+	long iterations = argc > 1 ? atol(argv[1]) : 100000;
+	unsigned seed = argc > 2 ? atoi(argv[2]) : 1;
+	PricingFuzzer fuzzer(seed);
+	fuzzer.addRegisterEngines();
+	FuzzMismatch m;
+	if (fuzzer.run(iterations, m)) {
+		printf("%ld cases, %zu engines agree with the reference\n", fuzzer.getCases(), fuzzer.getEngines());
+		return 0;
+	}
+	printf("case %ld: engine \"%s\" disagrees with the reference, %zu ops minimized to %zu\n", fuzzer.getCases(),
+		m.engine.c_str(), m.failing.ops.size(), m.minimal.ops.size());
+	printf("after op %zu the total is %d, expected %d\n%s", m.op + 1, m.actual, m.expected, PricingFuzzer::describe(m.minimal).c_str());
+	return 1;
+}
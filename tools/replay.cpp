@@ -0,0 +1,32 @@
+//plays a trace from ./tracegen through registers on several threads and
+//prints throughput, session latency and a checksum of the session totals
+#include "importer.h"
+#include "trace.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s prices.csv sessions.trace [threads]\n", argv[0]);
+		return 2;
+	}
+	int threads = argc > 3 ? atoi(argv[3]) : 1;
+	shared_ptr<Inventory> inventory = std::make_shared<Inventory>();
+	CsvImporter importer;
+	if (!importer.load(argv[1], *inventory)) {
+		perror(argv[1]);
+		return 1;
+	}
+	TraceReplay replay(inventory);
+	if (!replay.load(argv[2])) {
+		perror(argv[2]);
+		return 1;
+	}
+	ReplayResult r = replay.run(threads);
+	printf("%lld sessions, %lld events, %lld rejected, %ld malformed lines on %d threads\n", r.sessions, r.events, r.rejected, replay.getMalformed(), threads);
+	printf("%.0f events/sec, session p50 %.2f us, p99 %.2f us, p99.9 %.2f us\n", r.getEventsPerSecond(), r.sessionP50, r.sessionP99, r.sessionP999);
+	printf("total %lld cents, checksum %016" PRIx64 "\n", r.totalCents, r.checksum);
+	return 0;
+}
@@ -0,0 +1,30 @@
+//writes a synthetic price file and a trace of basket sessions against it
+//for ./replay, optionally overriding the traffic shape
+#include "trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s prices.csv sessions.trace [skus sessions zipf weighted special removal basket seed]\n", argv[0]);
+		return 2;
+	}
+	TraceConfig config;
+	if (argc > 3) config.skus = atoi(argv[3]);
+	if (argc > 4) config.sessions = atoi(argv[4]);
+	if (argc > 5) config.zipfSkew = atof(argv[5]);
+	if (argc > 6) config.weightedRatio = atof(argv[6]);
+	if (argc > 7) config.specialRatio = atof(argv[7]);
+	if (argc > 8) config.removalRate = atof(argv[8]);
+	if (argc > 9) config.basketMean = atoi(argv[9]);
+	if (argc > 10) config.seed = atoi(argv[10]);
+	TraceGenerator generator(config);
+	if (!generator.write(argv[1], argv[2])) {
+		perror(argv[1]);
+		return 1;
+	}
+	printf("%d products written to %s, %d sessions to %s\n", config.skus, argv[1], config.sessions, argv[2]);
+	return 0;
+}